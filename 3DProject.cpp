@@ -2,9 +2,16 @@
 #include <cmath>
 #include <cstdlib>
 #include <ctime>
+#include <random>
 #include <cstring>
 #include <cstdio>
 #include <vector>
+#include "InputLog.h"
+#include "MosquitoInstancer.h"
+#include "SimClock.h"
+#include "Snapshot.h"
+#include "UnitCircle.h"
+#include "World.h"
 #include <math.h>
 #include <stdlib.h>
 #ifdef _WIN32
@@ -12,45 +19,22 @@
 #endif
 
 // ---------------- Configuration ----------------
-const int NUM_MOSQUITOES = 30;
 const int WINDOW_W = 900;
 const int WINDOW_H = 650;
-// Pond position (BOTTOM-LEFT)
-const float pondX = -0.7f;
-const float pondY = -0.75f;
-const float pondRadiusX = 0.25f;
-const float pondRadiusY = 0.12f;
-// Water bowl position (BOTTOM-LEFT, BESIDE POND)
-float waterBowlX = -0.4f, waterBowlY = -0.8f, waterBowlRadius = 0.05f;
-bool waterBowlVisible = false;
+// Simulation state lives in the engine; see WorldConfig::classic3D()
+World world(WorldConfig::classic3D());
+// Fixed-timestep clock: the window redraws every FRAME_MILLIS and runs
+// however many world ticks of cfg.tickMillis have elapsed since
+const int FRAME_MILLIS = 16;
+SimClock simClock(world.cfg.tickMillis);
+// User input reaches the world through this queue, one tick at a time, and
+// is logged to INPUT_LOG_FILE for Headless --replay
+InputQueue inputs;
+const char* INPUT_LOG_FILE = "mosquito.input";
 bool draggingBowl = false;
-// Spray variables
-bool spraying = false;
-float sprayX = 0.0f, sprayY = 0.0f, sprayRadius = 0.02f;
-const float maxSprayRadius = 0.15f;
-const float sprayGrowth = 0.018f;
-int sprayCharges = 5; // Limited spray resource
-const int maxSprayCharges = 5;
-int sprayRefillTimer = 0;
-const int sprayRefillInterval = 600; // 30s at 50ms per frame
-
-// Spawn control (frames)
-int spawnCounter = 0;
-int spawnIntervalNormal = 180;
-int spawnIntervalHigh = 50;
-int currentSpawnInterval = spawnIntervalNormal;
-// Rain event
-bool rainActive = false;
-int rainTimer = 0;
-const int rainDuration = 600; // 30s at 50ms
-const int rainSpawnCount = 5; // Mosquitoes spawned during rain
-// Score
-int totalAlive = 0;
-int totalKilled = 0;
 
 // --- Environment Cycle ---
-int environmentState = 0; // 0=Day, 1=Night, 2=Fog
-const int ENV_STATES = 3;
+const int ENV_STATES = 3; // world.environmentState: 0=Day, 1=Night, 2=Fog
 
 // --- Camera ---
 float camX = 0.0f, camY = 0.0f, camZ = 2.0f; // Top-down view
@@ -60,174 +44,70 @@ float lookX = 0.0f, lookY = 0.0f, lookZ = 0.0f;
 float g_rotateY = -30.0f; // Initial rotation to show front and side
 float g_rotateX = 20.0f;  // Initial tilt
 
-// Larva tracking
-struct Larva {
-    float x;      // Position x
-    float y;      // Position y
-    float size;   // Visual/collision size
-    int timer;    // Frame counter for logic (e.g., growth)
-    bool alive;   // Flag for active state
-
-};
-std::vector<Larva> larvae;
 // Educational popup
 char popupText[256] = "";
 int popupTimer = 0;
-const int popupDuration = 80;
-// Histogram data (kills per minute, assuming 1200 frames = 1 minute at 50ms)
+const int popupDuration = 250; // Rendered frames, about 4 s; not ticks, so warp cannot skip it
+// Histogram data (kills per simulated minute)
 std::vector<int> killsPerMinute;
-int frameCounter = 0;
-const int framesPerMinute = 1200;
 // Menu IDs
-enum MenuOptions { MENU_RESTART, MENU_TOGGLE_BOWL, MENU_EXIT, MENU_TRIGGER_RAIN };
-// Utility random
+enum MenuOptions { MENU_RESTART, MENU_TOGGLE_BOWL, MENU_EXIT, MENU_TRIGGER_RAIN, MENU_SAVE, MENU_LOAD };
+const char* SNAPSHOT_FILE = "mosquito.snap";
+// Utility random (cosmetic only; the simulation has its own generator)
 float randFloat(float a, float b) {
     return a + static_cast<float>(rand()) / RAND_MAX * (b - a);
 }
-// ---------------- Mosquito struct ----------------
-struct Mosquito {
-    float x, y, z;
-    float dx, dy;
-    float size;
-    bool alive;
-    int deadTimer;
-    bool attractedToPond;
-    int pondTime; // For larva spawning
-};
-
-Mosquito mosquitoes[NUM_MOSQUITOES];
 // Initialize mosquitoes
 void initializeMosquitoes() {
     srand(static_cast<unsigned>(time(0)));
-    totalAlive = 0;
-    totalKilled = 0;
-    larvae.clear();
+    world.reset(static_cast<unsigned>(time(0)));
     killsPerMinute.clear();
     killsPerMinute.push_back(0);
-    sprayCharges = maxSprayCharges;
-    rainActive = false;
-    rainTimer = 0;
-    environmentState = 0; // Start at day
-    frameCounter = 0;
-    for (int i = 0; i < NUM_MOSQUITOES; ++i) {
-        mosquitoes[i].x = randFloat(-0.9f, 0.9f);
-        mosquitoes[i].y = randFloat(-0.9f, 0.9f);
-        mosquitoes[i].z = 0.0f; // Z will be set in display
-        mosquitoes[i].dx = randFloat(-0.003f, 0.003f);
-        mosquitoes[i].dy = randFloat(-0.003f, 0.003f);
-        mosquitoes[i].size = randFloat(0.035f, 0.05f);
-        mosquitoes[i].alive = (rand() % 2 == 0);
-        mosquitoes[i].deadTimer = 0;
-        mosquitoes[i].attractedToPond = (rand() % 3 == 0);
-        mosquitoes[i].pondTime = 0;
-        if (mosquitoes[i].alive) totalAlive++;
-    }
 }
 // ---------------- Drawing helpers ----------------
 void displayText(const char* text, float x, float y, void* font); // Forward declaration
 
 void drawCircle(float cx, float cy, float rx, float ry, int segments = 48) {
+    const float* t = unitCircle(segments);
     glBegin(GL_POLYGON);
     for (int i = 0; i < segments; ++i) {
-        float a = 2.0f * 3.1415926f * i / segments;
-        glVertex3f(cx + cosf(a) * rx, cy + sinf(a) * ry, 0.0f); // Draw at z=0
+        glVertex3f(cx + t[2 * i] * rx, cy + t[2 * i + 1] * ry, 0.0f); // Draw at z=0
     }
     glEnd();
 }
-void drawMosquito(float x, float y, float z, float size, float r, float g, float b, bool bloodFed = false) {
-    GLUquadricObj* quadric = gluNewQuadric();
-    gluQuadricDrawStyle(quadric, GLU_FILL); 
-
-    glPushMatrix();
-    glTranslatef(x, y, z);
-
-    // Thorax
-    glPushMatrix();
-    glColor3f(r * 0.8f, g * 0.8f, b * 0.8f); 
-    glScalef(size * 0.15f, size * 0.1f, size * 0.1f); 
-    glutSolidSphere(1.0f, 12, 12);
-    glPopMatrix();
-
-    // Head
-    glPushMatrix();
-    glTranslatef(size * 0.15f, 0.0f, 0.0f); 
-    glColor3f(r * 0.5f, g * 0.5f, b * 0.5f); 
-    glutSolidSphere(size * 0.08f, 10, 10);
-    glPopMatrix();
-
-    // Proboscis
-    glPushMatrix();
-    glTranslatef(size * 0.23f, 0.0f, 0.0f);
-    glRotatef(90.0f, 0.0f, 1.0f, 0.0f); 
-    glColor3f(r * 0.3f, g * 0.3f, b * 0.3f); 
-    gluCylinder(quadric, size * 0.01f, size * 0.005f, size * 0.1f, 8, 1); 
-    glPopMatrix();
-
-    // Antennae
-    for (int i = -1; i <= 1; i += 2) {
-        glPushMatrix();
-        glTranslatef(size * 0.15f, size * 0.05f * i, size * 0.05f);
-        glRotatef(45.0f, 0.0f, 0.0f, 1.0f); 
-        glColor3f(r * 0.4f, g * 0.4f, b * 0.4f);
-        gluCylinder(quadric, size * 0.005f, size * 0.002f, size * 0.12f, 6, 1);
-        glPopMatrix();
-    }
-
-    // Abdomen
-    glPushMatrix();
-    glTranslatef(-size * 0.15f, 0.0f, 0.0f); 
-    if (bloodFed) {
-        glColor3f(1.0f, 0.0f, 0.0f); 
-    } else {
-        glColor3f(r, g, b);
-    }
-    glScalef(size * 0.2f, size * 0.08f, size * 0.08f); 
-    glutSolidSphere(1.0f, 12, 12);
-    glPopMatrix();
-
-    // Wings
-    for (int i = -1; i <= 1; i += 2) {
-        glPushMatrix();
-        glTranslatef(0.0f, size * 0.05f * i, size * 0.05f);
-        glRotatef(30.0f * i, 1.0f, 0.0f, 0.0f); 
-        glColor4f(1.0f, 1.0f, 1.0f, 0.6f); 
-        glBegin(GL_TRIANGLES);
-        glVertex3f(0.0f, 0.0f, 0.0f);
-        glVertex3f(size * 0.3f, size * 0.1f, 0.0f);
-        glVertex3f(0.0f, size * 0.2f, 0.0f);
-        glEnd();
-        glPopMatrix();
-    }
-
-    // Legs
-    float legAngles[3] = {-45.0f, 0.0f, 45.0f}; 
-    for (int leg = 0; leg < 3; ++leg) {
-        for (int side = -1; side <= 1; side += 2) {
-            glPushMatrix();
-            glTranslatef(size * (0.05f - leg * 0.1f), size * 0.05f * side, 0.0f);
-            glRotatef(legAngles[leg], 0.0f, 0.0f, 1.0f); 
-            glColor3f(r * 0.6f, g * 0.6f, b * 0.6f);
-            gluCylinder(quadric, size * 0.01f, size * 0.005f, size * 0.3f, 6, 1);
-            glPopMatrix();
-        }
+// ---------------- Cached meshes ----------------
+// Mosquito and larva geometry is tessellated once, at unit size, into display
+// lists by buildMeshes(); drawing one is then a transform and a glCallList.
+// Where the GL allows it, mosquitoes and their shadows skip the per-agent
+// lists and are drawn as two instanced calls (MosquitoInstancer.h).
+GLuint mosquitoList[2] = {0, 0}; // Plain, blood-fed
+GLuint larvaList = 0;
+GLuint shadowList = 0; // Ground shadow under each mosquito
+MosquitoInstancer mosquitoInstancer, shadowInstancer;
+bool instancing = false;
+
+void compileMesh(GLuint list, const std::vector<MeshVertex>& mesh) {
+    glNewList(list, GL_COMPILE);
+    glBegin(GL_TRIANGLES);
+    for (const MeshVertex& v : mesh) {
+        glColor4f(v.r, v.g, v.b, v.a);
+        glNormal3f(v.nx, v.ny, v.nz);
+        glVertex3f(v.x, v.y, v.z);
     }
-
-    gluDeleteQuadric(quadric);
-    glPopMatrix();
+    glEnd();
+    glEndList();
 }
-void drawLarva(float x, float y, float size) { 
-    GLUquadricObj* quadric = gluNewQuadric();
-    gluQuadricDrawStyle(quadric, GLU_FILL);
 
+void compileLarva(GLuint list, GLUquadricObj* quadric) {
+    glNewList(list, GL_COMPILE);
     glPushMatrix();
-    glTranslatef(x, y, 0.0f); 
     glRotatef(-90.0f, 1.0f, 0.0f, 0.0f); 
 
     // Head
     glPushMatrix();
-    glTranslatef(0.0f, size * 0.1f, 0.0f);
+    glTranslatef(0.0f, 0.1f, 0.0f);
     glColor4f(0.4f, 0.3f, 0.2f, 0.8f); 
-    glutSolidSphere(size * 0.05f, 10, 10);
+    glutSolidSphere(0.05f, 10, 10);
     glPopMatrix();
 
     // Mouth brushes
@@ -236,61 +116,95 @@ void drawLarva(float x, float y, float size) {
     glBegin(GL_LINES);
     for (int i = 0; i < 6; ++i) {
         float angle = i * 60.0f * 3.14159f / 180.0f;
-        glVertex3f(0.0f, size * 0.1f, 0.0f);
-        glVertex3f(size * 0.03f * sin(angle), size * 0.1f + size * 0.05f, size * 0.03f * cos(angle));
+        glVertex3f(0.0f, 0.1f, 0.0f);
+        glVertex3f(0.03f * sin(angle), 0.15f, 0.03f * cos(angle));
     }
     glEnd();
 
     // Antennae
     for (int side = -1; side <= 1; side += 2) {
         glPushMatrix();
-        glTranslatef(size * 0.03f * side, size * 0.1f, 0.0f);
+        glTranslatef(0.03f * side, 0.1f, 0.0f);
         glRotatef(45.0f * side, 0.0f, 0.0f, 1.0f);
         glColor4f(0.4f, 0.3f, 0.2f, 0.8f);
-        gluCylinder(quadric, size * 0.005f, size * 0.002f, size * 0.08f, 6, 1);
+        gluCylinder(quadric, 0.005f, 0.002f, 0.08f, 6, 1);
         glPopMatrix();
     }
 
     // Thorax
     glPushMatrix();
     glTranslatef(0.0f, 0.0f, 0.0f);
-    glScalef(size * 0.08f, size * 0.15f, size * 0.08f); 
+    glScalef(0.08f, 0.15f, 0.08f); 
     glColor4f(0.5f, 0.4f, 0.3f, 0.7f);
     glutSolidSphere(1.0f, 12, 12);
     glPopMatrix();
 
     // Abdomen
-    float segmentLength = size * 0.05f;
-    float currentY = -size * 0.1f; 
+    float segmentLength = 0.05f;
+    float currentY = -0.1f; 
     for (int seg = 0; seg < 8; ++seg) {
         glPushMatrix();
         glTranslatef(0.0f, currentY, 0.0f);
         glColor4f(0.6f + seg * 0.05f, 0.5f + seg * 0.05f, 0.4f, 0.7f); 
-        gluCylinder(quadric, size * (0.04f - seg * 0.002f), size * (0.035f - seg * 0.002f), segmentLength, 8, 1);
+        gluCylinder(quadric, 0.04f - seg * 0.002f, 0.035f - seg * 0.002f, segmentLength, 8, 1);
         currentY -= segmentLength;
         glPopMatrix();
     }
 
     // Siphon
     glPushMatrix();
-    glTranslatef(0.0f, currentY - size * 0.05f, 0.0f);
+    glTranslatef(0.0f, currentY - 0.05f, 0.0f);
     glColor4f(0.3f, 0.2f, 0.1f, 0.8f); 
-    gluCylinder(quadric, size * 0.01f, size * 0.005f, size * 0.1f, 6, 1);
+    gluCylinder(quadric, 0.01f, 0.005f, 0.1f, 6, 1);
     glPopMatrix();
 
     // Optional lateral hairs
     glColor4f(0.3f, 0.3f, 0.3f, 0.5f);
     glBegin(GL_LINES);
     for (int seg = 1; seg < 8; seg += 2) {
-        float hairY = -size * 0.1f - seg * segmentLength;
+        float hairY = -0.1f - seg * segmentLength;
         for (int side = -1; side <= 1; side += 2) {
-            glVertex3f(size * 0.03f * side, hairY, 0.0f);
-            glVertex3f(size * 0.05f * side, hairY - size * 0.02f, 0.0f);
+            glVertex3f(0.03f * side, hairY, 0.0f);
+            glVertex3f(0.05f * side, hairY - 0.02f, 0.0f);
         }
     }
     glEnd();
+    glPopMatrix();
+    glEndList();
+}
 
+// Needs a current GL context; called from initGL()
+void buildMeshes() {
+    GLUquadricObj* quadric = gluNewQuadric();
+    gluQuadricDrawStyle(quadric, GLU_FILL);
+    GLuint base = glGenLists(4);
+    mosquitoList[0] = base;
+    mosquitoList[1] = base + 1;
+    larvaList = base + 2;
+    shadowList = base + 3;
+    std::vector<MeshVertex> plain = mosquitoMesh(0.0f, 0.0f, 0.0f, false);
+    std::vector<MeshVertex> fed = mosquitoMesh(0.0f, 0.0f, 0.0f, true);
+    std::vector<MeshVertex> shadow = shadowMesh();
+    compileMesh(mosquitoList[0], plain);
+    compileMesh(mosquitoList[1], fed);
+    compileLarva(larvaList, quadric);
     gluDeleteQuadric(quadric);
+    compileMesh(shadowList, shadow);
+    instancing = mosquitoInstancer.init(plain, fed) && shadowInstancer.init(shadow, shadow);
+}
+
+void drawMosquito(float x, float y, float z, float size, bool bloodFed = false) {
+    glPushMatrix();
+    glTranslatef(x, y, z);
+    glScalef(size, size, size);
+    glCallList(mosquitoList[bloodFed ? 1 : 0]);
+    glPopMatrix();
+}
+void drawLarva(float x, float y, float size) {
+    glPushMatrix();
+    glTranslatef(x, y, 0.0f);
+    glScalef(size, size, size);
+    glCallList(larvaList);
     glPopMatrix();
 }
 
@@ -382,7 +296,7 @@ void drawPitchedRoofHouse(bool isNight) {
 
 
     // --- 3. Draw Lit Windows (if night) ---
-    if (environmentState == 1) { // Use environmentState instead of isNight
+    if (world.environmentState == 1) { // Use world.environmentState instead of isNight
         glDisable(GL_LIGHTING); 
         glColor3f(1.0f, 0.9f, 0.2f); // Yellow light
         
@@ -528,7 +442,7 @@ void drawMoon(float x, float y) {
     glPushMatrix();
     glTranslatef(x, y, 0.0f); 
 
-    srand(12345); // Fixed seed for consistent crater placement
+    std::mt19937 craters(12345); // Fixed seed for consistent crater placement
 
     // --- Enable Blending for Transparency (Essential for Glow) ---
     glEnable(GL_BLEND);
@@ -556,11 +470,11 @@ void drawMoon(float x, float y) {
     
     for (int i = 0; i < numCraters; ++i) {
         glPushMatrix();
-        float r = ((float)(rand() % 100) / 100.0f) * 0.09f + 0.015f; // Wider spread
-        float theta = ((float)(rand() % 100) / 100.0f) * 2.0f * 3.1415926f;
+        float r = ((float)(craters() % 100) / 100.0f) * 0.09f + 0.015f; // Wider spread
+        float theta = ((float)(craters() % 100) / 100.0f) * 2.0f * 3.1415926f;
         float craterX = r * cosf(theta);
         float craterY = r * sinf(theta);
-        float craterSize = 0.008f + ((float)(rand() % 60) / 100.0f) * 0.025f; // More varied sizes
+        float craterSize = 0.008f + ((float)(craters() % 60) / 100.0f) * 0.025f; // More varied sizes
         glTranslatef(craterX, craterY, -0.02f); // Deeper for pronounced shadows
         glutSolidSphere(craterSize, 16, 16); // Higher res
         
@@ -578,11 +492,11 @@ void drawMoon(float x, float y) {
     int numHighlands = 15; // More highlands for balanced texture
     for (int i = 0; i < numHighlands; ++i) {
         glPushMatrix();
-        float r = ((float)(rand() % 100) / 100.0f) * 0.07f + 0.03f;
-        float theta = ((float)(rand() % 100) / 100.0f) * 2.0f * 3.1415926f;
+        float r = ((float)(craters() % 100) / 100.0f) * 0.07f + 0.03f;
+        float theta = ((float)(craters() % 100) / 100.0f) * 2.0f * 3.1415926f;
         float highX = r * cosf(theta);
         float highY = r * sinf(theta);
-        float highSize = 0.01f + ((float)(rand() % 40) / 100.0f) * 0.02f;
+        float highSize = 0.01f + ((float)(craters() % 40) / 100.0f) * 0.02f;
         glTranslatef(highX, highY, 0.008f); // Slightly more raised
         glutSolidSphere(highSize, 12, 12);
         glPopMatrix();
@@ -614,24 +528,24 @@ void drawMoon(float x, float y) {
 void drawGrass(float x, float y) {
     
     int seed = (int)(x * 1234.0f + y * 5678.0f);
-    srand(seed); 
+    std::mt19937 blade(seed); // Same clump for the same spot, without touching blade()
     // Draw a clump of 3-5 blades per coordinate
-    int bladeCount = 3 + (rand() % 3); 
+    int bladeCount = 3 + (blade() % 3); 
 
     for (int i = 0; i < bladeCount; i++) {
         // --- SCALE & VARIATION ---
         // Increased Scale: Height is now 0.15 to 0.25 (was 0.08)
-        float height = 0.15f + (rand() % 15) * 0.01f;
+        float height = 0.15f + (blade() % 15) * 0.01f;
         
         // Width relative to height
-        float width = 0.02f + (rand() % 5) * 0.002f; 
+        float width = 0.02f + (blade() % 5) * 0.002f; 
 
         // "Lean" - how much the grass curves to the left or right
         // This makes it look organic, not like spikes.
-        float lean = ((rand() % 20) - 10) * 0.01f; 
+        float lean = ((blade() % 20) - 10) * 0.01f; 
 
         // Slight random offset for position so they aren't in a perfect line
-        float offsetX = ((rand() % 10) - 5) * 0.005f;
+        float offsetX = ((blade() % 10) - 5) * 0.005f;
 
         // --- DRAWING THE BLADE ---
         glBegin(GL_TRIANGLES);
@@ -642,7 +556,7 @@ void drawGrass(float x, float y) {
 
             // Vertex 2: The Tip (Lighter Green - Sunlight)
             // Note: We add 'lean' to the X coordinate to curve it
-            float greenVar = 0.6f + (rand() % 40) * 0.01f; // Random bright green
+            float greenVar = 0.6f + (blade() % 40) * 0.01f; // Random bright green
             glColor3f(0.1f, greenVar, 0.1f); 
             glVertex3f(x + offsetX + lean, y + height, -0.05f);
 
@@ -672,7 +586,10 @@ void drawPond() {
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
     const int segments = 72;
-    const float PI = 3.1415926f;
+    const float* t = unitCircle(segments);
+    const float* ripple = unitCircle(36);
+    const float pondX = world.cfg.pondX, pondY = world.cfg.pondY;
+    const float pondRadiusX = world.cfg.pondRadiusX, pondRadiusY = world.cfg.pondRadiusY;
 
     // --- PART A: The Water (Radial Gradient for Depth) ---
     // We use GL_TRIANGLE_FAN to create a gradient from center to edge
@@ -684,9 +601,8 @@ void drawPond() {
         // Outer vertices: Darker blue (deep water feel)
         glColor4f(0.05f, 0.2f, 0.6f, 0.95f); 
         for (int i = 0; i <= segments; ++i) {
-            float theta = 2.0f * PI * float(i) / float(segments);
-            float dx = cosf(theta) * pondRadiusX;
-            float dy = sinf(theta) * pondRadiusY;
+            float dx = t[2 * i] * pondRadiusX;
+            float dy = t[2 * i + 1] * pondRadiusY;
             glVertex3f(pondX + dx, pondY + dy, 0.0f);
         }
     glEnd();
@@ -697,9 +613,8 @@ void drawPond() {
     glColor3f(0.35f, 0.25f, 0.15f); // Dark Sandy/Muddy color
     glBegin(GL_LINE_LOOP);
         for (int i = 0; i < segments; ++i) {
-            float theta = 2.0f * PI * float(i) / float(segments);
-            glVertex3f(pondX + cosf(theta) * pondRadiusX, 
-                       pondY + sinf(theta) * pondRadiusY, 0.01f); // Slightly higher z
+            glVertex3f(pondX + t[2 * i] * pondRadiusX, 
+                       pondY + t[2 * i + 1] * pondRadiusY, 0.01f); // Slightly higher z
         }
     glEnd();
 
@@ -709,10 +624,9 @@ void drawPond() {
     glColor4f(0.5f, 0.8f, 1.0f, 0.4f); // Very light blue, transparent
     glBegin(GL_LINE_LOOP);
         for (int i = 0; i < 36; ++i) {
-            float theta = 2.0f * PI * float(i) / 36;
             // Draw at 80% size (0.8f)
-            glVertex3f(pondX + cosf(theta) * pondRadiusX * 0.8f, 
-                       pondY + sinf(theta) * pondRadiusY * 0.8f, 0.01f);
+            glVertex3f(pondX + ripple[2 * i] * pondRadiusX * 0.8f, 
+                       pondY + ripple[2 * i + 1] * pondRadiusY * 0.8f, 0.01f);
         }
     glEnd();
 
@@ -721,7 +635,9 @@ void drawPond() {
 }
 
 void drawWaterBowl() {
-    if (!waterBowlVisible) return;
+    if (!world.waterBowlVisible) return;
+    const float waterBowlX = world.waterBowlX, waterBowlY = world.waterBowlY;
+    const float waterBowlRadius = world.cfg.bowlRadius;
 
     glPushMatrix();
     // Keep original position
@@ -732,7 +648,8 @@ void drawWaterBowl() {
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
     const int segments = 32;
-    const float PI = 3.1415926f;
+    const float* t = unitCircle(segments);
+    const float* shine = unitCircle(20);
 
     // --- PART 1: The Bowl (Clay Material) ---
     // We use a gradient: Darker at edges, lighter in center to simulate a curved bottom
@@ -742,9 +659,8 @@ void drawWaterBowl() {
         
         glColor3f(0.35f, 0.15f, 0.05f); // Edge: Darker Clay (shadows)
         for (int i = 0; i <= segments; ++i) {
-            float theta = 2.0f * PI * float(i) / float(segments);
-            glVertex2f(waterBowlX + cosf(theta) * waterBowlRadius, 
-                       waterBowlY + sinf(theta) * waterBowlRadius);
+            glVertex2f(waterBowlX + t[2 * i] * waterBowlRadius, 
+                       waterBowlY + t[2 * i + 1] * waterBowlRadius);
         }
     glEnd();
 
@@ -756,10 +672,9 @@ void drawWaterBowl() {
 
         glColor4f(0.1f, 0.4f, 0.8f, 0.9f);  // Edge: Deep water
         for (int i = 0; i <= segments; ++i) {
-            float theta = 2.0f * PI * float(i) / float(segments);
             // Using 0.85f leaves a visible "rim" of the bowl showing
-            glVertex2f(waterBowlX + cosf(theta) * waterBowlRadius * 0.85f, 
-                       waterBowlY + sinf(theta) * waterBowlRadius * 0.85f);
+            glVertex2f(waterBowlX + t[2 * i] * waterBowlRadius * 0.85f, 
+                       waterBowlY + t[2 * i + 1] * waterBowlRadius * 0.85f);
         }
     glEnd();
 
@@ -768,13 +683,12 @@ void drawWaterBowl() {
     glBegin(GL_POLYGON);
         glColor4f(1.0f, 1.0f, 1.0f, 0.4f); // Semi-transparent white
         for (int i = 0; i <= 20; ++i) {
-            float theta = 2.0f * PI * float(i) / 20.0f;
             // Positioned slightly up and left (-0.3, +0.3)
             float shineX = waterBowlX - (waterBowlRadius * 0.3f);
             float shineY = waterBowlY + (waterBowlRadius * 0.3f);
             // Small radius (0.15)
-            glVertex2f(shineX + cosf(theta) * waterBowlRadius * 0.15f, 
-                       shineY + sinf(theta) * waterBowlRadius * 0.10f);
+            glVertex2f(shineX + shine[2 * i] * waterBowlRadius * 0.15f, 
+                       shineY + shine[2 * i + 1] * waterBowlRadius * 0.10f);
         }
     glEnd();
 
@@ -785,10 +699,10 @@ void drawWaterBowl() {
 // --- NEW 3D RAIN FUNCTION ---
 void drawRain() {
 
-    if (rainActive || environmentState == 2) {
+    if (world.rainActive || world.environmentState == 2) {
 
-        float alpha = (environmentState == 2 && !rainActive) ? 0.15f : 0.35f;
-        int numDrops = (environmentState == 2 && !rainActive) ? 120 : 300;
+        float alpha = (world.environmentState == 2 && !world.rainActive) ? 0.15f : 0.35f;
+        int numDrops = (world.environmentState == 2 && !world.rainActive) ? 120 : 300;
 
         glLineWidth(1.8f);
 
@@ -809,7 +723,7 @@ void drawRain() {
             float speedOffset = randFloat(0.7f, 1.3f);
 
             // y position moves from topY → bottomY
-            float y = topY - fmod(frameCounter * dropSpeed * speedOffset + (topY - baseY),
+            float y = topY - fmod(world.tick * dropSpeed * speedOffset + (topY - baseY),
                                   (topY - bottomY));
 
             // diagonal (wind)
@@ -830,6 +744,234 @@ void drawRain() {
 }
 
 
+// ---------------- Baked scenery ----------------
+// Everything behind the agents (stars at night, fog layers, ground, sun or
+// moon, clouds, grass, houses, trees, pond) changes only with the
+// environment state, so it is compiled into one display list and replayed
+// every frame. The camera and the light position are applied when the list
+// runs; only a change in SceneryKey rebakes. Stars and grass are placed by
+// their own fixed-seed generators, so they come out the same on every bake
+// and never touch rand().
+struct SceneryKey {
+    int environmentState;
+    float rotateX, rotateY;
+    float pondX, pondY, pondRadiusX, pondRadiusY;
+
+    bool operator==(const SceneryKey& o) const {
+        return environmentState == o.environmentState && rotateX == o.rotateX && rotateY == o.rotateY &&
+               pondX == o.pondX && pondY == o.pondY && pondRadiusX == o.pondRadiusX && pondRadiusY == o.pondRadiusY;
+    }
+};
+GLuint sceneryList = 0;
+SceneryKey bakedScenery = {-1, 0, 0, 0, 0, 0, 0}; // No environment state is -1, so the first frame bakes
+const int GRASS_CLUMPS = 20;
+
+// Night sky; the ground hides it from the default camera
+void drawStars() {
+    std::mt19937 sky(54321); // Fixed seed for consistent star placement
+    glDisable(GL_LIGHTING); // Flat colors for stars
+
+    glPointSize(1.5f); // Slightly larger points for visibility
+    glBegin(GL_POINTS);
+    
+    int numStars = 500; // Number of stars for a dense but not overwhelming sky
+    for (int i = 0; i < numStars; ++i) {
+        // Random positions across the view (assuming normalized device coordinates -1 to 1)
+        float starX = ((float)(sky() % 2000) / 1000.0f) - 1.0f;
+        float starY = ((float)(sky() % 2000) / 1000.0f) - 1.0f;
+        float starZ = -1.0f; // Place stars far back in 3D space for depth
+        
+        // Vary star brightness and slight color tint for realism (white to yellowish)
+        float brightness = 0.7f + ((float)(sky() % 30) / 100.0f); // 0.7 to 1.0
+        float tint = (sky() % 2 == 0) ? 1.0f : 0.95f; // Subtle yellow tint for some stars
+        glColor3f(brightness, brightness * tint, brightness * 0.95f); // Cool white to warm
+        
+        glVertex3f(starX * 2.0f, starY * 2.0f, starZ); // Scale to cover wider area
+    }
+    
+    glEnd();
+
+    // Add a few brighter stars (e.g., like Sirius or Venus) for highlights
+    glPointSize(3.0f); // Larger size for bright stars; not allowed inside glBegin
+    glBegin(GL_POINTS);
+    int numBrightStars = 10;
+    for (int i = 0; i < numBrightStars; ++i) {
+        float starX = ((float)(sky() % 2000) / 1000.0f) - 1.0f;
+        float starY = ((float)(sky() % 2000) / 1000.0f) - 1.0f;
+        float starZ = -1.0f;
+        glColor3f(1.0f, 1.0f, 0.9f); // Bright yellowish-white
+        glVertex3f(starX * 2.0f, starY * 2.0f, starZ);
+    }
+    
+    glEnd();
+    glPointSize(1.0f); // Reset point size
+    glEnable(GL_LIGHTING); // Re-enable lighting if needed for other elements
+}
+
+// Clumps along the bottom edge
+void drawGrassField() {
+    std::mt19937 field(2024);
+    std::uniform_real_distribution<float> x(-1.0f, 1.0f);
+    for (int i = 0; i < GRASS_CLUMPS; ++i) drawGrass(x(field), -0.95f);
+}
+
+void drawBackdrop() {
+    // 4. Enable/Disable Fog
+    if (world.environmentState == 2) { // Fog
+        // Replace built-in fog with layered alpha quads for more realistic 3D volumetric fog effect
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glDisable(GL_LIGHTING); // Flat color for fog layers
+        glDepthMask(GL_FALSE); // Disable depth writing to allow proper blending over scene geometry
+
+        // Fog color MUST match the background color, with low alpha for layering
+        GLfloat fogColor[4] = {0.75f, 0.75f, 0.75f, 0.04f}; // Adjusted alpha for subtlety (tune based on numLayers)
+        glColor4fv(fogColor);
+
+        int numLayers = 25; // More layers for smoother, more realistic fog (but impacts performance)
+        float heightStep = 0.4f; // Smaller steps for denser fog appearance
+        float minHeight = 0.0f; // Start at ground level
+        float size = 100.0f; // Large size to cover the scene; adjust based on scene scale
+
+        for (int i = 0; i < numLayers; ++i) {
+            float y = minHeight + i * heightStep;
+            glPushMatrix();
+            glTranslatef(0.0f, y, 0.0f); // Stack layers horizontally along y-axis (assuming y-up)
+            glBegin(GL_QUADS);
+            glVertex3f(-size, 0.0f, -size);
+            glVertex3f(size, 0.0f, -size);
+            glVertex3f(size, 0.0f, size);
+            glVertex3f(-size, 0.0f, size);
+            glEnd();
+            glPopMatrix();
+        }
+
+        glDepthMask(GL_TRUE); // Re-enable depth writing
+        glEnable(GL_LIGHTING); // Re-enable if needed for the rest of the scene
+        glDisable(GL_BLEND);
+    } else {
+        glDisable(GL_BLEND);
+    }
+
+
+    // 5. Draw ground plane (at z=-0.1, and larger)
+    glColor3f(0.3f, 0.6f, 0.2f); // Green ground
+    glBegin(GL_QUADS);
+    glVertex3f(-1.5f, -1.2f, -0.1f);
+    glVertex3f( 1.5f, -1.2f, -0.1f);
+    glVertex3f( 1.5f,  1.2f, -0.1f);
+    glVertex3f(-1.5f,  1.2f, -0.1f);
+    glEnd();
+
+    // 6. Draw Sun/Moon (but not in fog)
+    if (world.environmentState == 1) { // Night
+    drawMoon(0.8f, 0.8f);
+} else if (world.environmentState == 0) { // Day
+    drawSun(0.8f, 0.8f);
+}
+
+    // 7. Draw other scene objects (clouds; the grass follows)
+    glColor3f(1,1,1);
+    drawCircle(-0.8f, 0.75f, 0.08f, 0.04f, 24);
+    drawCircle(-0.55f, 0.8f, 0.07f, 0.035f, 24);
+    drawCircle(0.3f, 0.7f, 0.09f, 0.045f, 24);
+}
+
+void drawBuildings() {
+    // --- 8. Draw the new 3D Houses ---
+    
+    GLfloat light_pos[] = { 1.0f, 5.0f, 5.0f, 1.0f };
+    bool lightWindows = (world.environmentState == 1); // Windows light up only at night
+    
+    // --- House 1 ---
+    glPushMatrix();
+    glTranslatef(-0.5f, -0.3f, -0.099f);
+    float scale1 = 0.3f / 8.0f; 
+    glScalef(scale1, scale1, scale1);
+    glRotatef(g_rotateX, 1.0f, 0.0f, 0.0f);
+    glRotatef(g_rotateY, 0.0f, 1.0f, 0.0f);
+    glEnable(GL_LIGHTING);
+    glEnable(GL_LIGHT0);
+    glLightfv(GL_LIGHT0, GL_POSITION, light_pos);
+    glEnable(GL_COLOR_MATERIAL);
+    drawPitchedRoofHouse(lightWindows);
+    glDisable(GL_LIGHTING);
+    glDisable(GL_LIGHT0);
+    glDisable(GL_COLOR_MATERIAL);
+    glPopMatrix();
+
+
+    // --- House 2 ---
+    glPushMatrix();
+    glTranslatef(0.0f, -0.35f, -0.099f);
+    float scale2 = 0.4f / 8.0f;
+    glScalef(scale2, scale2, scale2);
+    glRotatef(g_rotateX, 1.0f, 0.0f, 0.0f);
+    glRotatef(g_rotateY, 0.0f, 1.0f, 0.0f);
+    glEnable(GL_LIGHTING);
+    glEnable(GL_LIGHT0);
+    glLightfv(GL_LIGHT0, GL_POSITION, light_pos);
+    glEnable(GL_COLOR_MATERIAL);
+    drawPitchedRoofHouse(lightWindows);
+    glDisable(GL_LIGHTING);
+    glDisable(GL_LIGHT0);
+    glDisable(GL_COLOR_MATERIAL);
+    glPopMatrix();
+
+
+    // --- House 3 ---
+    glPushMatrix();
+    glTranslatef(0.5f, -0.3f, -0.099f);
+    float scale3 = 0.25f / 8.0f;
+    glScalef(scale3, scale3, scale3);
+    glRotatef(g_rotateX, 1.0f, 0.0f, 0.0f);
+    glRotatef(g_rotateY, 0.0f, 1.0f, 0.0f);
+    glEnable(GL_LIGHTING);
+    glEnable(GL_LIGHT0);
+    glLightfv(GL_LIGHT0, GL_POSITION, light_pos);
+    glEnable(GL_COLOR_MATERIAL);
+    drawPitchedRoofHouse(lightWindows);
+    glDisable(GL_LIGHTING);
+    glDisable(GL_LIGHT0);
+    glDisable(GL_COLOR_MATERIAL);
+    glPopMatrix();
+
+
+    // 9. Draw Trees (now 3D)
+    glEnable(GL_LIGHTING);
+    glEnable(GL_LIGHT0);
+    glLightfv(GL_LIGHT0, GL_POSITION, light_pos);
+    glEnable(GL_COLOR_MATERIAL);
+    
+    drawTree(-0.7f, -0.4f);
+    drawTree(0.7f, -0.4f);
+    drawTree(0.2f, -0.75f);
+    
+    glDisable(GL_LIGHTING);
+    glDisable(GL_LIGHT0);
+    glDisable(GL_COLOR_MATERIAL);
+
+
+    // Drawn on top of the z=-0.1 ground
+    drawPond();
+}
+
+// Needs a current GL context; called from display()
+void bakeScenery() {
+    const WorldConfig& c = world.cfg;
+    SceneryKey key = {world.environmentState, g_rotateX, g_rotateY, c.pondX, c.pondY, c.pondRadiusX, c.pondRadiusY};
+    if (sceneryList && key == bakedScenery) return;
+    if (!sceneryList) sceneryList = glGenLists(1);
+    glNewList(sceneryList, GL_COMPILE);
+    if (world.environmentState == 1) drawStars();
+    drawBackdrop();
+    drawGrassField();
+    drawBuildings();
+    glEndList();
+    bakedScenery = key;
+}
+
+
 // ---------------- Histogram ----------------
 void drawHistogram() {
     if (killsPerMinute.empty()) return;
@@ -887,183 +1029,15 @@ void drawHistogram() {
     glDisable(GL_BLEND);
 }
 
-void updateHistogram(int killedThisFrame) {
-    // frameCounter++; // <-- REMOVED: It is now in timerFunc
-    killsPerMinute.back() += killedThisFrame;
-    if (frameCounter >= framesPerMinute) {
-        killsPerMinute.push_back(0);
-        frameCounter = 0;
-        if (killsPerMinute.size() > 5) killsPerMinute.erase(killsPerMinute.begin());
-    }
-}
-// ---------------- Logic ----------------
-bool isNearPondArea(float x, float y) {
-    float rx = pondRadiusX * 1.8f;
-    float ry = pondRadiusY * 2.5f;
-    float nx = (x - pondX) / rx;
-    float ny = (y - pondY) / ry;
-    return (nx * nx + ny * ny) <= 1.0f;
-}
-bool isNearWaterBowl(float x, float y) {
-    if (!waterBowlVisible) return false;
-    float dx = x - waterBowlX;
-    float dy = y - waterBowlY;
-    return sqrtf(dx*dx + dy*dy) <= waterBowlRadius * 2.0f;
-}
-void spawnOneMosquito(bool pondBoost) {
-    for (int i = 0; i < NUM_MOSQUITOES; ++i) {
-        if (!mosquitoes[i].alive) {
-            bool useBowl = waterBowlVisible && (rand() % 2 == 0);
-            float angle = randFloat(0.0f, 2.0f * 3.1415926f);
-            if (pondBoost && useBowl) {
-                mosquitoes[i].x = waterBowlX + cosf(angle) * waterBowlRadius * 1.2f;
-                mosquitoes[i].y = waterBowlY + sinf(angle) * waterBowlRadius * 1.2f;
-            } else if (pondBoost) {
-                float rx = pondRadiusX * 0.9f + randFloat(0.0f, 0.04f);
-                float ry = pondRadiusY * 0.9f + randFloat(0.0f, 0.03f);
-                mosquitoes[i].x = pondX + cosf(angle) * rx;
-                mosquitoes[i].y = pondY + sinf(angle) * ry;
-            } else {
-                mosquitoes[i].x = randFloat(-0.9f, 0.9f);
-                mosquitoes[i].y = randFloat(-0.9f, 0.9f);
-            }
-            mosquitoes[i].dx = randFloat(-0.004f, 0.004f);
-            mosquitoes[i].dy = randFloat(-0.004f, 0.004f);
-            mosquitoes[i].size = randFloat(0.035f, 0.05f);
-            mosquitoes[i].alive = true;
-            mosquitoes[i].deadTimer = 0;
-            mosquitoes[i].attractedToPond = (rand() % 2 == 0);
-            mosquitoes[i].pondTime = 0;
-            totalAlive++;
-            return;
-        }
-    }
-}
-void updateMosquitoesLogic() {
-    for (int i = 0; i < NUM_MOSQUITOES; ++i) {
-        if (mosquitoes[i].alive) {
-            if (mosquitoes[i].attractedToPond) {
-                float targetX = pondX, targetY = pondY;
-                if (waterBowlVisible && rand() % 2 == 0) {
-                    targetX = waterBowlX;
-                    targetY = waterBowlY;
-                }
-                float dx = targetX - mosquitoes[i].x;
-                float dy = targetY - mosquitoes[i].y;
-                float dist = sqrtf(dx*dx + dy*dy);
-                if (dist > 0.01f) {
-                    mosquitoes[i].dx += (dx / dist) * 0.001f;
-                    mosquitoes[i].dy += (dy / dist) * 0.001f;
-                }
-            }
-            mosquitoes[i].x += mosquitoes[i].dx;
-            mosquitoes[i].y += mosquitoes[i].dy;
-            if (mosquitoes[i].x < -0.98f || mosquitoes[i].x > 0.98f) mosquitoes[i].dx = -mosquitoes[i].dx;
-            if (mosquitoes[i].y < -0.98f || mosquitoes[i].y > 0.98f) mosquitoes[i].dy = -mosquitoes[i].dy;
-            if ((rand() % 1000) < 8) {
-                mosquitoes[i].dx += randFloat(-0.002f, 0.002f);
-                mosquitoes[i].dy += randFloat(-0.002f, 0.002f);
-            }
-            // Larva spawning logic
-            if (isNearPondArea(mosquitoes[i].x, mosquitoes[i].y)) {
-                mosquitoes[i].pondTime++;
-                if (mosquitoes[i].pondTime > 200) { // ~10s
-                    Larva larva = {mosquitoes[i].x + randFloat(-0.02f, 0.02f), mosquitoes[i].y + randFloat(-0.02f, 0.02f), 0.04f, 0, true}; // Give larva a size
-                    larvae.push_back(larva);
-                    mosquitoes[i].pondTime = 0;
-                }
-            } else {
-                mosquitoes[i].pondTime = 0;
-            }
-        } else if (mosquitoes[i].deadTimer > 0) {
-            mosquitoes[i].deadTimer--;
-        }
-    }
-    // Larva update
-    for (size_t i = 0; i < larvae.size(); ++i) {
-        larvae[i].timer++;
-        if (larvae[i].timer > 400) { // ~20s, then larva matures
-            spawnOneMosquito(true);
-            larvae.erase(larvae.begin() + i);
-            --i;
-        }
-    }
-    // Rain event
-    if (rainActive) {
-        rainTimer--;
-        if (rainTimer <= 0) {
-            rainActive = false;
-            snprintf(popupText, sizeof(popupText), "Rain stopped. Watch for breeding sites!");
-            popupTimer = popupDuration;
-        }
-    } else if (rand() % 1000 < 2 && !rainActive && environmentState != 2) { // No random rain in fog
-        rainActive = true;
-        rainTimer = rainDuration;
-        for (int i = 0; i < rainSpawnCount; ++i) spawnOneMosquito(true);
-        snprintf(popupText, sizeof(popupText), "Rain event! Mosquitoes spawning!");
-        popupTimer = popupDuration;
-#ifdef _WIN32
-        Beep(500, 300);
-#endif
-    }
-    // Spawn logic
-    bool boost = waterBowlVisible || totalAlive > 5 || rainActive || (environmentState != 0);
-    int nearPondCount = 0, nearBowlCount = 0;
-    for (int i = 0; i < NUM_MOSQUITOES; ++i) {
-        if (mosquitoes[i].alive) {
-            if (isNearPondArea(mosquitoes[i].x, mosquitoes[i].y)) nearPondCount++;
-            if (isNearWaterBowl(mosquitoes[i].x, mosquitoes[i].y)) nearBowlCount++;
-        }
-    }
-    if (nearPondCount > 2 || nearBowlCount > 1) boost = true;
-    currentSpawnInterval = boost ? spawnIntervalHigh : spawnIntervalNormal;
-    spawnCounter++;
-    if (spawnCounter >= currentSpawnInterval) {
-        spawnOneMosquito(boost);
-        if (rand() % 100 < 60) spawnOneMosquito(boost);
-        spawnCounter = 0;
-    }
+void updateHistogram(int killed) {
+    killsPerMinute.back() += killed;
 }
-// ---------------- Spray & collision ----------------
-void checkSprayCollisions() {
-    if (!spraying) return;
-    int killedThisSpray = 0;
-    for (int i = 0; i < NUM_MOSQUITOES; ++i) {
-        if (!mosquitoes[i].alive) continue;
-        float dx = mosquitoes[i].x - sprayX;
-        float dy = mosquitoes[i].y - sprayY;
-        float dist = sqrtf(dx*dx + dy*dy);
-        if (dist <= sprayRadius + mosquitoes[i].size * 0.5f) {
-            mosquitoes[i].alive = false;
-            mosquitoes[i].deadTimer = 150 + (rand() % 150);
-            totalAlive--;
-            totalKilled++;
-            killedThisSpray++;
-            updateHistogram(1);
-            mosquitoes[i].x += randFloat(-0.04f, 0.04f);
-            mosquitoes[i].y += randFloat(-0.04f, 0.04f);
-        }
-    }
-    // Spray larvae too
-    for (size_t i = 0; i < larvae.size(); ++i) {
-        float dx = larvae[i].x - sprayX;
-        float dy = larvae[i].y - sprayY;
-        float dist = sqrtf(dx*dx + dy*dy);
-        if (dist <= sprayRadius) {
-            larvae.erase(larvae.begin() + i);
-            --i;
-            totalKilled++;
-            killedThisSpray++;
-            updateHistogram(1);
-        }
-    }
-    if (killedThisSpray > 0) {
-#ifdef _WIN32
-        Beep(800, 100);
-#endif
-        snprintf(popupText, sizeof(popupText), "Killed %d mosquitoes/larvae!", killedThisSpray);
-        popupTimer = popupDuration;
-    }
+
+// Start a new bar each simulated minute
+void advanceHistogram() {
+    if (world.tick % (60000 / world.cfg.tickMillis) != 0) return;
+    killsPerMinute.push_back(0);
+    if (killsPerMinute.size() > 5) killsPerMinute.erase(killsPerMinute.begin());
 }
 // ---------------- Display ----------------
 void displayText(const char* text, float x, float y, void* font) {
@@ -1076,21 +1050,23 @@ void displayUI() {
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     glColor4f(1.0f, 1.0f, 1.0f, 0.7f);
     glBegin(GL_QUADS);
-    glVertex2f(-0.98f, 0.85f);
-    glVertex2f(-0.5f, 0.85f);
+    glVertex2f(-0.98f, 0.80f);
+    glVertex2f(-0.5f, 0.80f);
     glVertex2f(-0.5f, 0.98f);
     glVertex2f(-0.98f, 0.98f);
     glEnd();
     glDisable(GL_BLEND);
     char buf[128];
-    snprintf(buf, sizeof(buf), "Alive: %d", totalAlive);
+    snprintf(buf, sizeof(buf), "Alive: %d", world.totalAlive);
     displayText(buf, -0.95f, 0.94f, GLUT_BITMAP_HELVETICA_18);
-    snprintf(buf, sizeof(buf), "Killed: %d", totalKilled);
+    snprintf(buf, sizeof(buf), "Killed: %d", world.totalKilled);
     displayText(buf, -0.95f, 0.89f, GLUT_BITMAP_HELVETICA_18);
-    snprintf(buf, sizeof(buf), "Spawn Rate: %s", (currentSpawnInterval == spawnIntervalHigh ? "High" : "Normal"));
+    snprintf(buf, sizeof(buf), "Spawn Rate: %s", (world.currentSpawnInterval == world.cfg.spawnIntervalHigh ? "High" : "Normal"));
     displayText(buf, -0.7f, 0.94f, GLUT_BITMAP_HELVETICA_18);
-    snprintf(buf, sizeof(buf), "Spray Charges: %d/%d", sprayCharges, maxSprayCharges);
+    snprintf(buf, sizeof(buf), "Spray Charges: %d/%d", world.sprayCharges, world.cfg.maxSprayCharges);
     displayText(buf, -0.7f, 0.89f, GLUT_BITMAP_HELVETICA_18);
+    simClock.formatSpeed(buf, sizeof(buf));
+    displayText(buf, -0.95f, 0.84f, GLUT_BITMAP_HELVETICA_18);
 }
 void displayInstructions() {
     const char* lines[] = {
@@ -1100,6 +1076,7 @@ void displayInstructions() {
         "S: Random Spray",
         "R: Toggle Water Bowl",
         "T: Trigger Rain Event",
+        "F: Fast-Forward (x1/x10/x100/max)",
         "ESC: Exit"
     };
     float y = 0.75f;
@@ -1127,49 +1104,12 @@ void displayPopup() {
 // --- COMPLETE AND CORRECT display() FUNCTION ---
 void display() {
     // 1. Set clear color based on environment state
-   if (environmentState == 1) { // Night
+   if (world.environmentState == 1) { // Night
         // New color: A darker, more realistic navy blue
         glClearColor(0.02f, 0.04f, 0.10f, 1.0f);
-
-        // Add realistic night view: Draw a starry sky with twinkling stars
-        glDisable(GL_LIGHTING); // Flat colors for stars
-        srand(54321); // Fixed seed for consistent star placement
-
-        glPointSize(1.5f); // Slightly larger points for visibility
-        glBegin(GL_POINTS);
-        
-        int numStars = 500; // Number of stars for a dense but not overwhelming sky
-        for (int i = 0; i < numStars; ++i) {
-            // Random positions across the view (assuming normalized device coordinates -1 to 1)
-            float starX = ((float)(rand() % 2000) / 1000.0f) - 1.0f;
-            float starY = ((float)(rand() % 2000) / 1000.0f) - 1.0f;
-            float starZ = -1.0f; // Place stars far back in 3D space for depth
-            
-            // Vary star brightness and slight color tint for realism (white to yellowish)
-            float brightness = 0.7f + ((float)(rand() % 30) / 100.0f); // 0.7 to 1.0
-            float tint = (rand() % 2 == 0) ? 1.0f : 0.95f; // Subtle yellow tint for some stars
-            glColor3f(brightness, brightness * tint, brightness * 0.95f); // Cool white to warm
-            
-            glVertex3f(starX * 2.0f, starY * 2.0f, starZ); // Scale to cover wider area
-        }
-        
-        // Add a few brighter stars (e.g., like Sirius or Venus) for highlights
-        int numBrightStars = 10;
-        for (int i = 0; i < numBrightStars; ++i) {
-            float starX = ((float)(rand() % 2000) / 1000.0f) - 1.0f;
-            float starY = ((float)(rand() % 2000) / 1000.0f) - 1.0f;
-            float starZ = -1.0f;
-            glPointSize(3.0f); // Larger size for bright stars
-            glColor3f(1.0f, 1.0f, 0.9f); // Bright yellowish-white
-            glVertex3f(starX * 2.0f, starY * 2.0f, starZ);
-        }
-        
-        glEnd();
-        glPointSize(1.0f); // Reset point size
-        glEnable(GL_LIGHTING); // Re-enable lighting if needed for other elements
     }
 
-     else if (environmentState == 2) { // Fog
+     else if (world.environmentState == 2) { // Fog
         // Changed color: Use the dark navy blue from night for a foggy night ambiance
         glClearColor(0.02f, 0.04f, 0.10f, 1.0f);
 
@@ -1234,145 +1174,10 @@ void display() {
 
     // --- 3D SCENE ---
 
-    // 4. Enable/Disable Fog
-    if (environmentState == 2) { // Fog
-        // Replace built-in fog with layered alpha quads for more realistic 3D volumetric fog effect
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-        glDisable(GL_LIGHTING); // Flat color for fog layers
-        glDepthMask(GL_FALSE); // Disable depth writing to allow proper blending over scene geometry
-
-        // Fog color MUST match the background color, with low alpha for layering
-        GLfloat fogColor[4] = {0.75f, 0.75f, 0.75f, 0.04f}; // Adjusted alpha for subtlety (tune based on numLayers)
-        glColor4fv(fogColor);
-
-        int numLayers = 25; // More layers for smoother, more realistic fog (but impacts performance)
-        float heightStep = 0.4f; // Smaller steps for denser fog appearance
-        float minHeight = 0.0f; // Start at ground level
-        float size = 100.0f; // Large size to cover the scene; adjust based on scene scale
-
-        for (int i = 0; i < numLayers; ++i) {
-            float y = minHeight + i * heightStep;
-            glPushMatrix();
-            glTranslatef(0.0f, y, 0.0f); // Stack layers horizontally along y-axis (assuming y-up)
-            glBegin(GL_QUADS);
-            glVertex3f(-size, 0.0f, -size);
-            glVertex3f(size, 0.0f, -size);
-            glVertex3f(size, 0.0f, size);
-            glVertex3f(-size, 0.0f, size);
-            glEnd();
-            glPopMatrix();
-        }
-
-        glDepthMask(GL_TRUE); // Re-enable depth writing
-        glEnable(GL_LIGHTING); // Re-enable if needed for the rest of the scene
-        glDisable(GL_BLEND);
-    } else {
-        glDisable(GL_BLEND);
-    }
-
-
-    // 5. Draw ground plane (at z=-0.1, and larger)
-    glColor3f(0.3f, 0.6f, 0.2f); // Green ground
-    glBegin(GL_QUADS);
-    glVertex3f(-1.5f, -1.2f, -0.1f);
-    glVertex3f( 1.5f, -1.2f, -0.1f);
-    glVertex3f( 1.5f,  1.2f, -0.1f);
-    glVertex3f(-1.5f,  1.2f, -0.1f);
-    glEnd();
-
-    // 6. Draw Sun/Moon (but not in fog)
-    if (environmentState == 1) { // Night
-    drawMoon(0.8f, 0.8f);
-} else if (environmentState == 0) { // Day
-    drawSun(0.8f, 0.8f);
-}
-
-    // 7. Draw other scene objects (clouds, grass)
-    glColor3f(1,1,1);
-    drawCircle(-0.8f, 0.75f, 0.08f, 0.04f, 24);
-    drawCircle(-0.55f, 0.8f, 0.07f, 0.035f, 24);
-    drawCircle(0.3f, 0.7f, 0.09f, 0.045f, 24);
-
-    for (int i = 0; i < 20; ++i) drawGrass(randFloat(-1.0f, 1.0f), -0.95f);
-
-
-    // --- 8. Draw the new 3D Houses ---
-    
-    GLfloat light_pos[] = { 1.0f, 5.0f, 5.0f, 1.0f };
-    bool lightWindows = (environmentState == 1); // Windows light up only at night
-    
-    // --- House 1 ---
-    glPushMatrix();
-    glTranslatef(-0.5f, -0.3f, -0.099f);
-    float scale1 = 0.3f / 8.0f; 
-    glScalef(scale1, scale1, scale1);
-    glRotatef(g_rotateX, 1.0f, 0.0f, 0.0f);
-    glRotatef(g_rotateY, 0.0f, 1.0f, 0.0f);
-    glEnable(GL_LIGHTING);
-    glEnable(GL_LIGHT0);
-    glLightfv(GL_LIGHT0, GL_POSITION, light_pos);
-    glEnable(GL_COLOR_MATERIAL);
-    drawPitchedRoofHouse(lightWindows);
-    glDisable(GL_LIGHTING);
-    glDisable(GL_LIGHT0);
-    glDisable(GL_COLOR_MATERIAL);
-    glPopMatrix();
-
-
-    // --- House 2 ---
-    glPushMatrix();
-    glTranslatef(0.0f, -0.35f, -0.099f);
-    float scale2 = 0.4f / 8.0f;
-    glScalef(scale2, scale2, scale2);
-    glRotatef(g_rotateX, 1.0f, 0.0f, 0.0f);
-    glRotatef(g_rotateY, 0.0f, 1.0f, 0.0f);
-    glEnable(GL_LIGHTING);
-    glEnable(GL_LIGHT0);
-    glLightfv(GL_LIGHT0, GL_POSITION, light_pos);
-    glEnable(GL_COLOR_MATERIAL);
-    drawPitchedRoofHouse(lightWindows);
-    glDisable(GL_LIGHTING);
-    glDisable(GL_LIGHT0);
-    glDisable(GL_COLOR_MATERIAL);
-    glPopMatrix();
-
-
-    // --- House 3 ---
-    glPushMatrix();
-    glTranslatef(0.5f, -0.3f, -0.099f);
-    float scale3 = 0.25f / 8.0f;
-    glScalef(scale3, scale3, scale3);
-    glRotatef(g_rotateX, 1.0f, 0.0f, 0.0f);
-    glRotatef(g_rotateY, 0.0f, 1.0f, 0.0f);
-    glEnable(GL_LIGHTING);
-    glEnable(GL_LIGHT0);
-    glLightfv(GL_LIGHT0, GL_POSITION, light_pos);
-    glEnable(GL_COLOR_MATERIAL);
-    drawPitchedRoofHouse(lightWindows);
-    glDisable(GL_LIGHTING);
-    glDisable(GL_LIGHT0);
-    glDisable(GL_COLOR_MATERIAL);
-    glPopMatrix();
-
-
-    // 9. Draw Trees (now 3D)
-    glEnable(GL_LIGHTING);
-    glEnable(GL_LIGHT0);
-    glLightfv(GL_LIGHT0, GL_POSITION, light_pos);
-    glEnable(GL_COLOR_MATERIAL);
-    
-    drawTree(-0.7f, -0.4f);
-    drawTree(0.7f, -0.4f);
-    drawTree(0.2f, -0.75f);
-    
-    glDisable(GL_LIGHTING);
-    glDisable(GL_LIGHT0);
-    glDisable(GL_COLOR_MATERIAL);
-
-
+    // 4-9. Backdrop, grass, then houses, trees and pond
+    bakeScenery();
+    glCallList(sceneryList);
     // These will now draw correctly on top of the z=-0.1 ground
-    drawPond();
     drawWaterBowl();
 
     // --- 10. Draw 3D Dynamic Objects (larvae, mosquitoes, rain, spray) ---
@@ -1381,25 +1186,39 @@ void display() {
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
     // Larvae
-    for (size_t i = 0; i < larvae.size(); ++i) drawLarva(larvae[i].x, larvae[i].y, larvae[i].size);
-
-    // Mosquitoes
-    for (int i = 0; i < NUM_MOSQUITOES; ++i) {
-      if (mosquitoes[i].alive) {
-          // Shadow
-          glColor4f(0.0f, 0.0f, 0.0f, 0.3f);
-          drawCircle(mosquitoes[i].x, mosquitoes[i].y, mosquitoes[i].size * 0.2f, mosquitoes[i].size * 0.1f);
-          
-          // Mosquito
-          float zPos = 0.05f + sinf((float)frameCounter * 0.1f + i) * 0.02f;
-          drawMosquito(mosquitoes[i].x, mosquitoes[i].y, zPos, mosquitoes[i].size, 0.0f, 0.0f, 0.0f);
-      }
+    const LarvaPool& larvae = world.larvae;
+    for (size_t i = larvae.front; i < larvae.used(); ++i)
+        if (larvae.alive[i]) drawLarva(larvae.x[i], larvae.y[i], world.larvaSize(i));
+
+    // Mosquitoes (bob phase follows the slot, which is stable for its lifetime)
+    const Population& m = world.mosquitoes;
+    // 2 rad per simulated second (0.1 per 50 ms tick), between ticks too;
+    // wrapped in double so the float angle keeps its precision on long runs
+    float bob = (float)fmod(simClock.renderSeconds(world.tick) * 2.0, 2.0 * 3.14159265358979);
+    // A population too big for the GL to map falls back to the display lists for good
+    instancing = instancing && shadowInstancer.reserve(m.count()) && mosquitoInstancer.reserve(m.count());
+    if (instancing) {
+        MosquitoInstancer::Hover ground = {0.0f, 0.0f, 0.0f}, hover = {0.05f, 0.02f, bob};
+        shadowInstancer.draw(m.x.data(), m.y.data(), m.size.data(), nullptr, nullptr, m.count(), ground);
+        mosquitoInstancer.draw(m.x.data(), m.y.data(), m.size.data(), m.slot.data(), nullptr, m.count(), hover);
+    } else {
+        for (size_t i = 0; i < m.count(); ++i) {
+            // Shadow
+            glPushMatrix();
+            glTranslatef(m.x[i], m.y[i], 0.0f);
+            glScalef(m.size[i], m.size[i], 1.0f);
+            glCallList(shadowList);
+            glPopMatrix();
+
+            float zPos = 0.05f + sinf(bob + m.slot[i]) * 0.02f;
+            drawMosquito(m.x[i], m.y[i], zPos, m.size[i]);
+        }
     }
 
     // Spray
-    if (spraying) {
+    if (world.spraying) {
         glColor4f(0.08f, 0.5f, 1.0f, 0.45f);
-        drawCircle(sprayX, sprayY, sprayRadius, sprayRadius, 36);
+        drawCircle(world.sprayX, world.sprayY, world.sprayRadius, world.sprayRadius, 36);
     }
     
     // 3D Rain (This is the correct location for it)
@@ -1439,89 +1258,123 @@ void display() {
 }
 
 // ---------------- Input & Timer ----------------
-void timerFunc(int value) {
-    frameCounter++; // This makes the rain animate
-    updateMosquitoesLogic();
-    if (spraying) {
-        checkSprayCollisions();
-        sprayRadius += sprayGrowth;
-        if (sprayRadius > maxSprayRadius) {
-            spraying = false;
-            sprayRadius = 0.02f;
-        }
+void handleSimEvent(const SimEvent& e) {
+    switch (e.type) {
+        case EVENT_RAIN_STARTED:
+            snprintf(popupText, sizeof(popupText), "Rain event! Mosquitoes spawning!");
+            popupTimer = popupDuration;
 #ifdef _WIN32
-        Beep(600, 50);
+            Beep(500, 300);
 #endif
-    }
-    sprayRefillTimer++;
-    if (sprayRefillTimer >= sprayRefillInterval && sprayCharges < maxSprayCharges) {
-        sprayCharges++;
-        sprayRefillTimer = 0;
-        snprintf(popupText, sizeof(popupText), "Spray charge refilled! %d/%d", sprayCharges, maxSprayCharges);
-        popupTimer = popupDuration;
+            break;
+        case EVENT_RAIN_STOPPED:
+            snprintf(popupText, sizeof(popupText), "Rain stopped. Watch for breeding sites!");
+            popupTimer = popupDuration;
+            break;
+        case EVENT_SPRAY_KILLS:
+            for (int i = 0; i < e.count; ++i) updateHistogram(1);
 #ifdef _WIN32
-        Beep(1200, 200);
+            Beep(800, 100);
 #endif
+            snprintf(popupText, sizeof(popupText), "Killed %d mosquitoes/larvae!", e.count);
+            popupTimer = popupDuration;
+            break;
+        case EVENT_SPRAY_REFILLED:
+            snprintf(popupText, sizeof(popupText), "Spray charge refilled! %d/%d", e.count, world.cfg.maxSprayCharges);
+            popupTimer = popupDuration;
+#ifdef _WIN32
+            Beep(1200, 200);
+#endif
+            break;
+        default:
+            break;
     }
-    for (int i = 0; i < NUM_MOSQUITOES; ++i) {
-        if (!mosquitoes[i].alive && mosquitoes[i].deadTimer <= 0) {
-            if (totalAlive < 5) spawnOneMosquito(false);
-        } else if (!mosquitoes[i].alive) {
-            int dec = (waterBowlVisible || isNearPondArea(mosquitoes[i].x, mosquitoes[i].y)) ? 2 : 1;
-            mosquitoes[i].deadTimer -= dec;
-            if (mosquitoes[i].deadTimer <= 0) spawnOneMosquito(false);
-        }
-    }
-    if (popupTimer > 0) popupTimer--;
-    glutPostRedisplay();
-    glutTimerFunc(50, timerFunc, 0);
 }
-void keyboard(unsigned char key, int x, int y) {
-    if (key == 's' || key == 'S') {
-        if (sprayCharges > 0) {
-            sprayX = randFloat(-0.9f, 0.9f);
-            sprayY = randFloat(-0.9f, 0.9f);
-            sprayRadius = 0.02f;
-            spraying = true;
-            sprayCharges--;
-            snprintf(popupText, sizeof(popupText), "Random spray! Charges left: %d", sprayCharges);
+// Popups and sounds for an input once the world has applied it
+void handleInput(const InputEvent& e) {
+    switch (e.type) {
+        case INPUT_SPRAY:
+        case INPUT_SPRAY_RANDOM:
+            if (e.accepted) {
+                snprintf(popupText, sizeof(popupText), e.type == INPUT_SPRAY ? "Spray at mouse! Charges left: %d" :
+                         "Random spray! Charges left: %d", world.sprayCharges);
+            } else {
+                snprintf(popupText, sizeof(popupText), "No spray charges! Wait for refill.");
+#ifdef _WIN32
+                Beep(400, 200);
+#endif
+            }
             popupTimer = popupDuration;
-        } else {
-            snprintf(popupText, sizeof(popupText), "No spray charges! Wait for refill.");
+            break;
+        case INPUT_TOGGLE_BOWL:
+            snprintf(popupText, sizeof(popupText), world.waterBowlVisible ? "Water bowl added: Increases breeding!" : "Water bowl removed: Reduces spawning.");
             popupTimer = popupDuration;
 #ifdef _WIN32
-            Beep(400, 200);
+            Beep(1000, 200);
 #endif
-        }
-    } else if (key == 'r' || key == 'R') {
-        waterBowlVisible = !waterBowlVisible;
-        snprintf(popupText, sizeof(popupText), waterBowlVisible ? "Water bowl added: Increases breeding!" : "Water bowl removed: Reduces spawning.");
-        popupTimer = popupDuration;
+            break;
+        case INPUT_RAIN:
+            if (e.accepted) {
+                snprintf(popupText, sizeof(popupText), "Rain event triggered!");
+                popupTimer = popupDuration;
 #ifdef _WIN32
-        Beep(1000, 200);
+                Beep(500, 300);
 #endif
-    } else if (key == 't' || key == 'T') {
-        if (!rainActive) {
-            rainActive = true;
-            rainTimer = rainDuration;
-            for (int i = 0; i < rainSpawnCount; ++i) spawnOneMosquito(true);
-            snprintf(popupText, sizeof(popupText), "Manual rain event triggered!");
+            }
+            break;
+        case INPUT_ENVIRONMENT:
+            if (world.environmentState == 0) {
+                snprintf(popupText, sizeof(popupText), "Switched to Day");
+            } else if (world.environmentState == 1) {
+                snprintf(popupText, sizeof(popupText), "Switched to Night");
+            } else {
+                snprintf(popupText, sizeof(popupText), "Switched to Fog");
+            }
             popupTimer = popupDuration;
+            break;
+        case INPUT_RESTART:
+            killsPerMinute.clear();
+            killsPerMinute.push_back(0);
+            snprintf(popupText, sizeof(popupText), "Simulation Restarted!");
+            popupTimer = popupDuration;
+            break;
+        default:
+            break;
+    }
+}
+// One simulation tick
+void stepSimulation() {
+    inputs.apply(world, handleInput);
+    world.step();
+    for (size_t i = 0; i < world.events.size(); ++i) handleSimEvent(world.events[i]);
+    advanceHistogram();
+}
+
+void timerFunc(int value) {
 #ifdef _WIN32
-            Beep(500, 300);
+    if (world.spraying && simClock.warp == 1.0) Beep(600, 50);
 #endif
-        }
+    int steps = simClock.advance(glutGet(GLUT_ELAPSED_TIME));
+    for (int i = 0; i < steps; ++i) stepSimulation();
+    if (popupTimer > 0) popupTimer--; // Once per frame, however many ticks ran
+    glutPostRedisplay();
+    glutTimerFunc(FRAME_MILLIS, timerFunc, 0);
+}
+void keyboard(unsigned char key, int x, int y) {
+    if (key == 's' || key == 'S') {
+        inputs.push(world, INPUT_SPRAY_RANDOM, 0.9f); // Target drawn from the sim stream when applied
+    } else if (key == 'r' || key == 'R') {
+        inputs.push(world, INPUT_TOGGLE_BOWL);
+    } else if (key == 'f' || key == 'F') {
+        simClock.cycleWarp();
+    } else if (key == 't' || key == 'T') {
+        inputs.push(world, INPUT_RAIN);
     } else if (key == 'd' || key == 'D') {
-        environmentState = (environmentState + 1) % ENV_STATES;
-        if (environmentState == 0) {
-            snprintf(popupText, sizeof(popupText), "Switched to Day");
-        } else if (environmentState == 1) {
-            snprintf(popupText, sizeof(popupText), "Switched to Night");
-        } else {
-            snprintf(popupText, sizeof(popupText), "Switched to Fog");
-        }
-        popupTimer = popupDuration;
-    } else if (key == 27) exit(0);
+        inputs.push(world, INPUT_ENVIRONMENT, 0.0f, 0.0f, (world.environmentState + 1) % ENV_STATES);
+    } else if (key == 27) {
+        inputs.finish(world);
+        exit(0);
+    }
 }
 void mouse(int button, int state, int mx, int my) {
     int winW = glutGet(GLUT_WINDOW_WIDTH);
@@ -1529,26 +1382,12 @@ void mouse(int button, int state, int mx, int my) {
     float nx = (2.0f * mx / winW) - 1.0f;
     float ny = 1.0f - (2.0f * my / winH);
     if (button == GLUT_LEFT_BUTTON && state == GLUT_DOWN) {
-        if (sprayCharges > 0) {
-            sprayX = nx;
-            sprayY = ny;
-            sprayRadius = 0.02f;
-            spraying = true;
-            sprayCharges--;
-            snprintf(popupText, sizeof(popupText), "Spray at mouse! Charges left: %d", sprayCharges);
-            popupTimer = popupDuration;
-        } else {
-            snprintf(popupText, sizeof(popupText), "No spray charges! Wait for refill.");
-            popupTimer = popupDuration;
-#ifdef _WIN32
-            Beep(400, 200);
-#endif
-        }
+        inputs.push(world, INPUT_SPRAY, nx, ny);
     } else if (button == GLUT_RIGHT_BUTTON && state == GLUT_DOWN) {
-        if (waterBowlVisible) {
-            float dx = nx - waterBowlX;
-            float dy = ny - waterBowlY;
-            if (sqrtf(dx*dx + dy*dy) < waterBowlRadius * 1.5f) {
+        if (world.waterBowlVisible) {
+            float dx = nx - world.waterBowlX;
+            float dy = ny - world.waterBowlY;
+            if (sqrtf(dx*dx + dy*dy) < world.cfg.bowlRadius * 1.5f) {
                 draggingBowl = true;
             }
         }
@@ -1560,36 +1399,39 @@ void motion(int mx, int my) {
     if (draggingBowl) {
         int winW = glutGet(GLUT_WINDOW_WIDTH);
         int winH = glutGet(GLUT_WINDOW_HEIGHT);
-        waterBowlX = (2.0f * mx / winW) - 1.0f;
-        waterBowlY = 1.0f - (2.0f * my / winH); // Corrected from 'H'
-        glutPostRedisplay();
+        inputs.push(world, INPUT_MOVE_BOWL, (2.0f * mx / winW) - 1.0f, 1.0f - (2.0f * my / winH));
     }
 }
 void menuFunc(int option) {
     switch (option) {
         case MENU_RESTART:
-            initializeMosquitoes();
-            snprintf(popupText, sizeof(popupText), "Simulation Restarted!");
-            popupTimer = popupDuration;
+            inputs.push(world, INPUT_RESTART, 0.0f, 0.0f, (int32_t)time(0));
             break;
         case MENU_TOGGLE_BOWL:
-            waterBowlVisible = !waterBowlVisible;
-            snprintf(popupText, sizeof(popupText), waterBowlVisible ? "Water Bowl Toggled On" : "Water Bowl Toggled Off");
-            popupTimer = popupDuration;
+            inputs.push(world, INPUT_TOGGLE_BOWL);
             break;
         case MENU_TRIGGER_RAIN:
-            if (!rainActive) {
-                rainActive = true;
-                rainTimer = rainDuration;
-                for (int i = 0; i < rainSpawnCount; ++i) spawnOneMosquito(true);
-                snprintf(popupText, sizeof(popupText), "Rain event triggered!");
-                popupTimer = popupDuration;
-#ifdef _WIN32
-                Beep(500, 300);
-#endif
+            inputs.push(world, INPUT_RAIN);
+            break;
+        case MENU_SAVE:
+            snprintf(popupText, sizeof(popupText), saveSnapshot(world, SNAPSHOT_FILE, &killsPerMinute) ?
+                     "Saved to %s" : "Could not write %s", SNAPSHOT_FILE);
+            popupTimer = popupDuration;
+            break;
+        case MENU_LOAD:
+            if (loadSnapshot(world, SNAPSHOT_FILE, &killsPerMinute)) {
+                if (killsPerMinute.empty()) killsPerMinute.push_back(0);
+                simClock.stepMillis = world.cfg.tickMillis;
+                simClock.reset();
+                inputs.record(INPUT_LOG_FILE, world); // A replay starts from the loaded state
+                snprintf(popupText, sizeof(popupText), "Loaded %s", SNAPSHOT_FILE);
+            } else {
+                snprintf(popupText, sizeof(popupText), "Could not load %s", SNAPSHOT_FILE);
             }
+            popupTimer = popupDuration;
             break;
         case MENU_EXIT:
+            inputs.finish(world);
             exit(0);
             break;
     }
@@ -1609,7 +1451,9 @@ void initGL() {
 
     glShadeModel(GL_SMOOTH);
 
+    buildMeshes();
     initializeMosquitoes();
+    inputs.record(INPUT_LOG_FILE, world);
 }
 
 int main(int argc, char** argv) {
@@ -1622,11 +1466,13 @@ int main(int argc, char** argv) {
     glutKeyboardFunc(keyboard);
     glutMouseFunc(mouse);
     glutMotionFunc(motion);
-    glutTimerFunc(50, timerFunc, 0);
+    glutTimerFunc(FRAME_MILLIS, timerFunc, 0);
     glutCreateMenu(menuFunc);
     glutAddMenuEntry("Restart", MENU_RESTART);
     glutAddMenuEntry("Toggle Water Bowl", MENU_TOGGLE_BOWL);
     glutAddMenuEntry("Trigger Rain", MENU_TRIGGER_RAIN);
+    glutAddMenuEntry("Save Snapshot", MENU_SAVE);
+    glutAddMenuEntry("Load Snapshot", MENU_LOAD);
     glutAddMenuEntry("Exit", MENU_EXIT);
     glutAttachMenu(GLUT_RIGHT_BUTTON);
     glutMainLoop();
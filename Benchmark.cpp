@@ -0,0 +1,351 @@
+// Benchmark.cpp - micro-benchmarks for the simulation engine
+//
+// Build: g++ -std=c++17 -O2 -pthread Benchmark.cpp -o benchmark
+// Usage: ./benchmark [all|movement|spray|simd|threads|snapshot|larvae|sites]
+//
+// Each benchmark prints one line per population size. Nothing here opens a
+// window; it measures World.h exactly as the front-ends run it.
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <thread>
+#include "BreedingSites.h"
+#include "MoveKernel.h"
+#include "Snapshot.h"
+#include "SpatialGrid.h"
+#include "World.h"
+
+typedef std::chrono::steady_clock BenchClock;
+
+static double secondsSince(BenchClock::time_point start) {
+    return std::chrono::duration<double>(BenchClock::now() - start).count();
+}
+
+// Enough ticks for roughly 50M agent updates, but at least 10
+static long long ticksFor(long long agents) {
+    long long t = 50000000LL / agents;
+    return t < 10 ? 10 : t;
+}
+
+// A world with every slot alive, so each pass does full work
+static WorldConfig fullPopulation(int agents) {
+    WorldConfig cfg = WorldConfig::classic2D();
+    cfg.maxMosquitoes = agents;
+    cfg.initialAliveChance = 1.0f;
+    return cfg;
+}
+
+// ---------------- Movement ----------------
+static void benchMovement() {
+    const int sizes[] = {30, 10000, 1000000};
+    printf("movement pass (World::moveMosquitoes)\n");
+    printf("%10s %10s %14s\n", "agents", "ticks", "ns/agent/tick");
+    for (int n : sizes) {
+        World world(fullPopulation(n), 1);
+        long long ticks = ticksFor(n);
+        world.moveMosquitoes(); // Warm caches
+        BenchClock::time_point start = BenchClock::now();
+        for (long long t = 0; t < ticks; ++t) world.moveMosquitoes();
+        double secs = secondsSince(start);
+        printf("%10d %10lld %14.2f\n", n, ticks, secs * 1e9 / ((double)n * ticks));
+    }
+}
+
+// ---------------- Spray queries ----------------
+// Circle queries over random points, the way checkSprayCollisions uses them:
+// brute force tests every point per spray, the grid is rebuilt once per tick
+// and then touches only the cells under each spray.
+static void benchSpray() {
+    const int sizes[] = {10000, 1000000};
+    const int sprayCounts[] = {1, 8};
+    const float radius = 0.15f;
+    printf("spray queries (radius %.2f), us per tick\n", radius);
+    printf("%10s %7s %12s %12s %9s\n", "points", "sprays", "brute", "grid", "speedup");
+    for (int n : sizes) {
+        std::mt19937 rng(42);
+        std::uniform_real_distribution<float> pos(-0.98f, 0.98f);
+        std::vector<float> x(n), y(n);
+        for (int i = 0; i < n; ++i) {
+            x[i] = pos(rng);
+            y[i] = pos(rng);
+        }
+        for (int sprays : sprayCounts) {
+            std::vector<float> sx(sprays), sy(sprays);
+            for (int k = 0; k < sprays; ++k) {
+                sx[k] = pos(rng);
+                sy[k] = pos(rng);
+            }
+            long long ticks = ticksFor((long long)n * sprays);
+            long long bruteHits = 0, gridHits = 0;
+
+            BenchClock::time_point start = BenchClock::now();
+            for (long long t = 0; t < ticks; ++t) {
+                for (int k = 0; k < sprays; ++k) {
+                    for (int i = 0; i < n; ++i) {
+                        float dx = x[i] - sx[k], dy = y[i] - sy[k];
+                        if (sqrtf(dx * dx + dy * dy) <= radius) bruteHits++;
+                    }
+                }
+            }
+            double brute = secondsSince(start);
+
+            SpatialGrid grid;
+            start = BenchClock::now();
+            for (long long t = 0; t < ticks; ++t) {
+                grid.build(x.data(), y.data(), n, -1.1f, 1.1f, SpatialGrid::sideFor(n));
+                for (int k = 0; k < sprays; ++k) {
+                    grid.query(sx[k] - radius, sy[k] - radius, sx[k] + radius, sy[k] + radius, [&](size_t i) {
+                        float dx = x[i] - sx[k], dy = y[i] - sy[k];
+                        if (sqrtf(dx * dx + dy * dy) <= radius) gridHits++;
+                    });
+                }
+            }
+            double gridSecs = secondsSince(start);
+            if (bruteHits != gridHits) fprintf(stderr, "hit count mismatch: %lld vs %lld\n", bruteHits, gridHits);
+            printf("%10d %7d %12.1f %12.1f %8.2fx\n", n, sprays, brute * 1e6 / ticks, gridSecs * 1e6 / ticks, brute / gridSecs);
+        }
+    }
+}
+
+// ---------------- SIMD movement kernel ----------------
+// The kernel alone on fixed random words, once per ISA level, checking that
+// every level ends bit-identical to the scalar one.
+static void benchSimd() {
+    const int sizes[] = {10000, 1000000};
+    const MoveIsa levels[] = {MOVE_SCALAR, MOVE_SSE2, MOVE_AVX2};
+    printf("movement kernel (MoveKernel.h)\n");
+    printf("%10s %8s %16s %8s\n", "agents", "isa", "Magents/s", "result");
+    for (int n : sizes) {
+        std::mt19937 rng(7);
+        std::uniform_real_distribution<float> pos(-0.98f, 0.98f), vel(-0.004f, 0.004f);
+        std::vector<float> x0(n), y0(n), dx0(n), dy0(n);
+        std::vector<unsigned char> attracted(n);
+        std::vector<uint32_t> rand0(n), rand1(n);
+        for (int i = 0; i < n; ++i) {
+            x0[i] = pos(rng);
+            y0[i] = pos(rng);
+            dx0[i] = vel(rng);
+            dy0[i] = vel(rng);
+            attracted[i] = rng() % 3 == 0;
+            rand0[i] = rng();
+            rand1[i] = rng();
+        }
+        WorldConfig cfg = WorldConfig::arcade(); // Has a speed limit, so every branch is exercised
+        MoveParams p = {cfg.pondX, cfg.pondY, cfg.bowlX, cfg.bowlY, true, cfg.attractAccel, cfg.attractMinDist,
+                        cfg.speedLimit, cfg.bounds, 0.002f, (uint32_t)(cfg.jitterChance * 2147483648.0),
+                        cfg.jitterAmount};
+        long long ticks = ticksFor(n);
+        std::vector<float> refX, refY, refDx, refDy;
+        for (MoveIsa isa : levels) {
+            if (!moveIsaSupported(isa)) {
+                printf("%10d %8s %16s %8s\n", n, moveIsaName(isa), "-", "n/a");
+                continue;
+            }
+            std::vector<float> x = x0, y = y0, dx = dx0, dy = dy0;
+            MoveColumns c = {x.data(), y.data(), dx.data(), dy.data(), attracted.data(), rand0.data(), rand1.data(), nullptr, nullptr};
+            BenchClock::time_point start = BenchClock::now();
+            for (long long t = 0; t < ticks; ++t) moveAgents(isa, p, c, 0, n);
+            double secs = secondsSince(start);
+            const char* result = "ref";
+            if (isa == MOVE_SCALAR) {
+                refX = x; refY = y; refDx = dx; refDy = dy;
+            } else {
+                bool same = !memcmp(x.data(), refX.data(), n * sizeof(float)) && !memcmp(y.data(), refY.data(), n * sizeof(float)) &&
+                            !memcmp(dx.data(), refDx.data(), n * sizeof(float)) && !memcmp(dy.data(), refDy.data(), n * sizeof(float));
+                result = same ? "same" : "DIFFERS";
+            }
+            printf("%10d %8s %16.1f %8s\n", n, moveIsaName(isa), (double)n * ticks / secs / 1e6, result);
+        }
+    }
+}
+
+// ---------------- Thread scaling ----------------
+// Strong scaling of World::step() at 1M agents. Every thread count must end
+// in the same state as one thread; a hash of the position columns checks it.
+static uint64_t stateHash(const World& world) {
+    const Population& m = world.mosquitoes;
+    uint64_t h = 1469598103934665603ULL; // FNV-1a
+    for (size_t i = 0; i < m.count(); ++i) {
+        uint32_t bits[2];
+        memcpy(&bits[0], &m.x[i], 4);
+        memcpy(&bits[1], &m.y[i], 4);
+        h = (h ^ bits[0]) * 1099511628211ULL;
+        h = (h ^ bits[1]) * 1099511628211ULL;
+    }
+    return (h ^ world.larvae.count()) * 1099511628211ULL;
+}
+
+static void benchThreads() {
+    const int agents = 1000000;
+    const int threadCounts[] = {1, 2, 4, 8, 16, 32, 64};
+    const long long ticks = 100;
+    printf("tick scaling at %d agents, %u hardware threads\n", agents, std::thread::hardware_concurrency());
+    printf("%8s %10s %9s %11s %8s\n", "threads", "ticks/s", "speedup", "efficiency", "result");
+    double base = 0.0;
+    uint64_t ref = 0;
+    for (int threads : threadCounts) {
+        World world(fullPopulation(agents), 1);
+        world.setThreads(threads);
+        world.step(); // Warm caches and the pool
+        BenchClock::time_point start = BenchClock::now();
+        for (long long t = 0; t < ticks; ++t) world.step();
+        double rate = ticks / secondsSince(start);
+        uint64_t h = stateHash(world);
+        if (threads == 1) {
+            base = rate;
+            ref = h;
+        }
+        printf("%8d %10.1f %8.2fx %10.0f%% %8s\n", threads, rate, rate / base, 100.0 * rate / base / threads,
+               threads == 1 ? "ref" : (h == ref ? "same" : "DIFFERS"));
+    }
+}
+
+// ---------------- Larva spray wipe ----------------
+// One step with a spray covering the whole map, so every larva dies in the
+// same tick. Removal is a tombstone plus one compaction pass (LarvaPool.h),
+// so the cost per larva should stay flat as the pool grows.
+static void benchLarvae() {
+    const int sizes[] = {10000, 100000, 1000000};
+    printf("larva spray wipe, one step\n");
+    printf("%10s %10s %12s %10s\n", "larvae", "ms", "ns/larva", "killed");
+    for (int n : sizes) {
+        WorldConfig cfg = WorldConfig::classic2D();
+        cfg.maxLarvae = n;
+        cfg.sprayStartRadius = cfg.sprayMaxRadius = 3.0f;
+        cfg.sprayGrowth = 0.0f;
+        World world(cfg, 1);
+        std::mt19937 rng(42);
+        std::uniform_real_distribution<float> pos(-0.98f, 0.98f);
+        for (int i = 0; i < n; ++i) world.larvae.add(pos(rng), pos(rng), cfg.larvaSize, world.tick);
+        world.spray(0.0f, 0.0f);
+        BenchClock::time_point start = BenchClock::now();
+        world.step();
+        double secs = secondsSince(start);
+        int killed = n - (int)world.larvae.count();
+        printf("%10d %10.2f %12.1f %10d\n", n, secs * 1e3, secs * 1e9 / n, killed);
+    }
+}
+
+// ---------------- Breeding sites ----------------
+// Nearest-site queries through SiteIndex against a scan of every site (on a
+// sample, the scan is too slow for all of them; the winners must agree),
+// then World::step() at 1M agents as the site count grows.
+static int nearestSiteBrute(const std::vector<BreedingSite>& sites, float x, float y) {
+    int best = -1;
+    float bestScore = 1e18f;
+    for (size_t s = 0; s < sites.size(); ++s) {
+        if (sites[s].attractiveness <= 0.0f) continue;
+        float dx = sites[s].x - x, dy = sites[s].y - y;
+        float score = (dx * dx + dy * dy) / (sites[s].attractiveness * sites[s].attractiveness);
+        if (score < bestScore) {
+            bestScore = score;
+            best = (int)s;
+        }
+    }
+    return best;
+}
+
+static void benchSites() {
+    const int siteCounts[] = {200, 10000};
+    const int queries = 1000000, sample = 10000;
+    const float extent = WorldConfig::classic2D().bounds;
+    printf("nearest breeding site, %d queries\n", queries);
+    printf("%8s %12s %12s %10s %8s\n", "sites", "index ns", "scan ns", "speedup", "result");
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> pos(-extent, extent);
+    std::vector<float> qx(queries), qy(queries);
+    for (int i = 0; i < queries; ++i) {
+        qx[i] = pos(rng);
+        qy[i] = pos(rng);
+    }
+    for (int n : siteCounts) {
+        std::vector<BreedingSite> sites = randomSites(n, 7, extent);
+        SiteIndex index;
+        index.build(sites, -extent, extent);
+        long long sum = 0;
+        BenchClock::time_point start = BenchClock::now();
+        for (int i = 0; i < queries; ++i) {
+            float score = 1e18f;
+            sum += index.nearest(qx[i], qy[i], score);
+        }
+        double indexNs = secondsSince(start) * 1e9 / queries;
+        bool same = true;
+        start = BenchClock::now();
+        for (int i = 0; i < sample; ++i) {
+            float score = 1e18f;
+            int b = nearestSiteBrute(sites, qx[i], qy[i]);
+            same = same && b == index.nearest(qx[i], qy[i], score);
+            sum += b;
+        }
+        double scanNs = secondsSince(start) * 1e9 / sample;
+        printf("%8d %12.1f %12.1f %9.0fx %8s\n", n, indexNs, scanNs, scanNs / indexNs, same ? "same" : "DIFFERS");
+        if (sum == 42) printf("\n"); // Keep the loops
+    }
+
+    const int agents = 1000000;
+    const int stepSites[] = {0, 200, 10000};
+    const long long ticks = 20;
+    printf("tick at %d agents with extra breeding sites\n", agents);
+    printf("%8s %10s %10s\n", "sites", "ms/tick", "larvae");
+    for (int n : stepSites) {
+        WorldConfig cfg = fullPopulation(agents);
+        World world(cfg, 1);
+        world.setSites(randomSites(n, 7, cfg.bounds));
+        world.step(); // Warm caches and build the index
+        BenchClock::time_point start = BenchClock::now();
+        for (long long t = 0; t < ticks; ++t) world.step();
+        double secs = secondsSince(start);
+        printf("%8d %10.2f %10zu\n", n, secs * 1e3 / ticks, world.larvae.count());
+    }
+}
+
+// ---------------- Snapshots ----------------
+// Save and load through the page cache; the file is removed afterwards
+static void benchSnapshot() {
+    const int sizes[] = {1000000, 10000000};
+    const char* path = "benchmark.snap";
+    printf("snapshot save/load (Snapshot.h)\n");
+    printf("%10s %10s %10s %10s %8s\n", "agents", "MB", "save ms", "load ms", "result");
+    for (int n : sizes) {
+        World world(fullPopulation(n), 1);
+        world.step();
+        BenchClock::time_point start = BenchClock::now();
+        bool saved = saveSnapshot(world, path);
+        double save = secondsSince(start);
+        FILE* f = fopen(path, "rb");
+        long bytes = 0;
+        if (f) {
+            fseek(f, 0, SEEK_END);
+            bytes = ftell(f);
+            fclose(f);
+        }
+        World loaded;
+        start = BenchClock::now();
+        bool ok = saved && loadSnapshot(loaded, path);
+        double load = secondsSince(start);
+        world.step();
+        loaded.step();
+        ok = ok && stateHash(world) == stateHash(loaded);
+        printf("%10d %10.1f %10.1f %10.1f %8s\n", n, bytes / 1e6, save * 1e3, load * 1e3, ok ? "same" : "DIFFERS");
+        remove(path);
+    }
+}
+
+int main(int argc, char** argv) {
+    const char* which = argc > 1 ? argv[1] : "all";
+    bool all = !strcmp(which, "all");
+    bool ran = false;
+    if (all || !strcmp(which, "movement")) { benchMovement(); ran = true; }
+    if (all || !strcmp(which, "spray")) { benchSpray(); ran = true; }
+    if (all || !strcmp(which, "simd")) { benchSimd(); ran = true; }
+    if (all || !strcmp(which, "threads")) { benchThreads(); ran = true; }
+    if (all || !strcmp(which, "snapshot")) { benchSnapshot(); ran = true; }
+    if (all || !strcmp(which, "larvae")) { benchLarvae(); ran = true; }
+    if (all || !strcmp(which, "sites")) { benchSites(); ran = true; }
+    if (!ran) {
+        fprintf(stderr, "Usage: %s [all|movement|spray|simd|threads|snapshot|larvae|sites]\n", argv[0]);
+        return 1;
+    }
+    return 0;
+}
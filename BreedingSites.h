@@ -0,0 +1,200 @@
+// ---------------------------------------------------------------------------
+// BreedingSites.h - extra breeding containers and a grid index over them
+//
+// Besides the pond and the water bowl a world can hold any number of small
+// breeding sites (tyres, pots, gutters). Each is an ellipse of standing
+// water with its own larva capacity and attractiveness; the pond counts as
+// attractiveness 1, so a site of 0.5 pulls like a pond twice as far away.
+//
+// SiteIndex answers the two per-mosquito questions in roughly constant time
+// however many sites there are:
+//   containing(x, y)  the site whose near area (the ellipse scaled by
+//                     nearScale) holds the point, lowest index first
+//   nearest(x, y, s)  the site with the smallest distance / attractiveness,
+//                     if it beats the score s the caller already has
+// It keeps two uniform grids: every site's near box is listed in each cell
+// it overlaps (for containing), and every centre in exactly one cell (for
+// nearest, which searches rings of cells outwards until no closer ring can
+// win). Both are built by counting sort like SpatialGrid.h and are rebuilt
+// only when the site list changes. The grid covers the range it is given,
+// widened to every site centre: the ring search's stopping bound holds only
+// if each site lies inside its own cell. Query points outside are clamped.
+// ---------------------------------------------------------------------------
+#ifndef MOSQUITO_BREEDING_SITES_H
+#define MOSQUITO_BREEDING_SITES_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+struct BreedingSite {
+    float x, y;
+    float radiusX, radiusY; // Water surface; a circle when equal
+    float nearScale;        // Breeding area is the surface scaled by this
+    int capacity;           // Larvae it holds at once (0 = unlimited)
+    float attractiveness;   // Pull relative to the pond; 0 never attracts
+};
+
+// n sites scattered over [-extent, extent], e.g. for benchmarks and
+// Headless.cpp --sites
+inline std::vector<BreedingSite> randomSites(size_t n, unsigned seed, float extent) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> pos(-extent, extent), radius(0.005f, 0.02f), pull(0.2f, 1.0f);
+    std::uniform_int_distribution<int> capacity(1, 10);
+    std::vector<BreedingSite> sites(n);
+    for (BreedingSite& s : sites) {
+        s.x = pos(rng);
+        s.y = pos(rng);
+        s.radiusX = radius(rng);
+        s.radiusY = s.radiusX * 0.7f;
+        s.nearScale = 2.0f;
+        s.capacity = capacity(rng);
+        s.attractiveness = pull(rng);
+    }
+    return sites;
+}
+
+class SiteIndex {
+public:
+    size_t size() const { return cx.size(); }
+
+    void build(const std::vector<BreedingSite>& sites, float minCoord, float maxCoord) {
+        const size_t n = sites.size();
+        cx.resize(n);
+        cy.resize(n);
+        invRx.resize(n);
+        invRy.resize(n);
+        pull.resize(n);
+        invPull2.resize(n);
+        maxPull = 0.0f;
+        for (size_t s = 0; s < n; ++s) {
+            cx[s] = sites[s].x;
+            cy[s] = sites[s].y;
+            invRx[s] = 1.0f / (sites[s].radiusX * sites[s].nearScale);
+            invRy[s] = 1.0f / (sites[s].radiusY * sites[s].nearScale);
+            pull[s] = sites[s].attractiveness;
+            invPull2[s] = pull[s] > 0.0f ? 1.0f / (pull[s] * pull[s]) : 0.0f;
+            maxPull = std::max(maxPull, pull[s]);
+            minCoord = std::min(minCoord, std::min(cx[s], cy[s]));
+            maxCoord = std::max(maxCoord, std::max(cx[s], cy[s]));
+        }
+        side = std::max(1, std::min((int)sqrtf(n / 2.0f), 256)); // About two sites per cell
+        origin = minCoord;
+        cell = (maxCoord - minCoord) / side;
+        invCell = 1.0f / cell;
+
+        // Centres, one cell each
+        bin(centres, [&](size_t s, int& x0, int& y0, int& x1, int& y1) {
+            x0 = x1 = cellCoord(cx[s]);
+            y0 = y1 = cellCoord(cy[s]);
+        });
+        // Near areas, every cell their box overlaps
+        bin(areas, [&](size_t s, int& x0, int& y0, int& x1, int& y1) {
+            x0 = cellCoord(cx[s] - 1.0f / invRx[s]);
+            x1 = cellCoord(cx[s] + 1.0f / invRx[s]);
+            y0 = cellCoord(cy[s] - 1.0f / invRy[s]);
+            y1 = cellCoord(cy[s] + 1.0f / invRy[s]);
+        });
+    }
+
+    // Lowest-numbered site whose near area holds (x, y), or -1
+    int containing(float x, float y) const {
+        if (cx.empty()) return -1;
+        size_t c = (size_t)cellCoord(y) * side + cellCoord(x);
+        for (uint32_t k = areas.start[c]; k < areas.start[c + 1]; ++k) {
+            uint32_t s = areas.items[k];
+            float nx = (x - cx[s]) * invRx[s];
+            float ny = (y - cy[s]) * invRy[s];
+            if (nx * nx + ny * ny <= 1.0f) return (int)s;
+        }
+        return -1;
+    }
+
+    // Site with the smallest distance / attractiveness below score, or -1.
+    // score is lowered to the winner's.
+    int nearest(float x, float y, float& score) const {
+        if (cx.empty() || maxPull <= 0.0f) return -1;
+        // Compared squared, so the search needs no square roots
+        int best = -1;
+        float best2 = score * score;
+        auto visit = [&](int gx, int gy) {
+            size_t c = (size_t)gy * side + gx;
+            for (uint32_t k = centres.start[c]; k < centres.start[c + 1]; ++k) {
+                uint32_t s = centres.items[k];
+                if (invPull2[s] == 0.0f) continue;
+                float dx = cx[s] - x, dy = cy[s] - y;
+                float d2 = (dx * dx + dy * dy) * invPull2[s];
+                if (d2 < best2 || (d2 == best2 && best >= 0 && (int)s < best)) { // Ties go to the lower index
+                    best2 = d2;
+                    best = (int)s;
+                }
+            }
+        };
+        int qx = cellCoord(x), qy = cellCoord(y);
+        visit(qx, qy);
+        // Ring r is (r - 1) cells plus the point's distance to its own cell's
+        // nearest edge away (0 for points clamped in from outside)
+        float ox = x - (origin + qx * cell), oy = y - (origin + qy * cell);
+        float edge = std::max(0.0f, std::min(std::min(ox, cell - ox), std::min(oy, cell - oy)));
+        const float maxPull2 = maxPull * maxPull;
+        for (int ring = 1; ring < side; ++ring) {
+            float gap = (ring - 1) * cell + edge;
+            if (gap * gap >= best2 * maxPull2) break;
+            int x0 = qx - ring, x1 = qx + ring, y0 = qy - ring, y1 = qy + ring;
+            for (int gy = std::max(y0, 0); gy <= std::min(y1, side - 1); ++gy) {
+                if (gy == y0 || gy == y1) {
+                    for (int gx = std::max(x0, 0); gx <= std::min(x1, side - 1); ++gx) visit(gx, gy);
+                } else {
+                    if (x0 >= 0) visit(x0, gy);
+                    if (x1 < side) visit(x1, gy);
+                }
+            }
+        }
+        if (best >= 0) score = sqrtf(best2);
+        return best;
+    }
+
+private:
+    struct Bins {
+        std::vector<uint32_t> start; // side*side + 1 prefix sums
+        std::vector<uint32_t> items; // Site indices grouped by cell, ascending within a cell
+    };
+
+    std::vector<float> cx, cy, invRx, invRy, pull;
+    std::vector<float> invPull2; // 1 / attractiveness^2, 0 for sites that never attract
+    float maxPull = 0.0f;
+    int side = 1;
+    float origin = 0.0f, cell = 1.0f, invCell = 1.0f;
+    Bins centres, areas;
+
+    int cellCoord(float v) const {
+        float c = (v - origin) * invCell; // Clamped before the cast, which overflows far out
+        return (int)std::max(0.0f, std::min(c, side - 1.0f));
+    }
+
+    // Counting sort of the sites into the cells range(s, ...) reports
+    template <class R>
+    void bin(Bins& b, R range) {
+        const size_t cells = (size_t)side * side;
+        b.start.assign(cells + 1, 0);
+        int x0, y0, x1, y1;
+        for (size_t s = 0; s < cx.size(); ++s) {
+            range(s, x0, y0, x1, y1);
+            for (int gy = y0; gy <= y1; ++gy)
+                for (int gx = x0; gx <= x1; ++gx) b.start[(size_t)gy * side + gx + 1]++;
+        }
+        for (size_t c = 0; c < cells; ++c) b.start[c + 1] += b.start[c];
+        b.items.resize(b.start[cells]);
+        std::vector<uint32_t> cursor(b.start.begin(), b.start.end() - 1);
+        for (size_t s = 0; s < cx.size(); ++s) {
+            range(s, x0, y0, x1, y1);
+            for (int gy = y0; gy <= y1; ++gy)
+                for (int gx = x0; gx <= x1; ++gx) b.items[cursor[(size_t)gy * side + gx]++] = (uint32_t)s;
+        }
+    }
+};
+
+#endif // MOSQUITO_BREEDING_SITES_H
@@ -0,0 +1,155 @@
+// ---------------------------------------------------------------------------
+// ConfigFields.h - WorldConfig fields by name
+//
+// A table of every tunable in WorldConfig with its name and type, so tools
+// can read and write parameters given as strings ("breedTicks=300") instead
+// of needing a rebuild per value. Each field also has the range World can
+// take: tools reject anything outside it (a zero tickMillis, a negative
+// capacity or radius, a chance above 1). Keep it in step with WorldConfig.
+// ---------------------------------------------------------------------------
+#ifndef MOSQUITO_CONFIG_FIELDS_H
+#define MOSQUITO_CONFIG_FIELDS_H
+
+#include <climits>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include "World.h"
+
+struct ConfigField {
+    const char* name;
+    int WorldConfig::*i;   // Exactly one of these is set
+    float WorldConfig::*f;
+    bool WorldConfig::*b;
+    double lo, hi;         // Accepted values, inclusive
+
+    bool isInt() const { return i != nullptr; }
+
+    // Whether set(c, v) would store a value in [lo, hi]
+    bool accepts(double v) const {
+        if (!std::isfinite(v)) return false;
+        if (i) v = std::round(v); // As lround, without its overflow
+        return v >= lo && v <= hi;
+    }
+
+    double get(const WorldConfig& c) const {
+        if (i) return c.*i;
+        if (f) return c.*f;
+        return (c.*b) ? 1.0 : 0.0;
+    }
+
+    // Integers round to nearest, booleans are v != 0
+    void set(WorldConfig& c, double v) const {
+        if (i) c.*i = (int)lround(v);
+        else if (f) c.*f = (float)v;
+        else c.*b = v != 0.0;
+    }
+};
+
+#define CONFIG_INT(n, lo) {#n, &WorldConfig::n, nullptr, nullptr, lo, INT_MAX}
+#define CONFIG_FLOAT(n, lo, hi) {#n, nullptr, &WorldConfig::n, nullptr, lo, hi}
+#define CONFIG_BOOL(n) {#n, nullptr, nullptr, &WorldConfig::n, 0.0, 1.0}
+#define CONFIG_COUNT(n) CONFIG_INT(n, 0)                // Counts and tick durations
+#define CONFIG_CHANCE(n) CONFIG_FLOAT(n, 0.0, 1.0)      // Probabilities and fractions
+#define CONFIG_LENGTH(n) CONFIG_FLOAT(n, 0.0, HUGE_VAL) // Sizes, radii, speeds, scales
+#define CONFIG_COORD(n) CONFIG_FLOAT(n, -HUGE_VAL, HUGE_VAL)
+
+inline const ConfigField* configFields(size_t& count) {
+    static const ConfigField fields[] = {
+        CONFIG_INT(tickMillis, 1),
+        CONFIG_COUNT(maxMosquitoes),
+        CONFIG_CHANCE(initialAliveChance),
+        CONFIG_CHANCE(initialAttractChance),
+        CONFIG_LENGTH(initialSpeed),
+        CONFIG_COUNT(initialSpawns),
+        CONFIG_LENGTH(bounds),
+        CONFIG_COORD(pondX),
+        CONFIG_COORD(pondY),
+        CONFIG_LENGTH(pondRadiusX),
+        CONFIG_LENGTH(pondRadiusY),
+        CONFIG_LENGTH(pondNearScaleX),
+        CONFIG_LENGTH(pondNearScaleY),
+        CONFIG_BOOL(pondNearLowerLeftOnly),
+        CONFIG_COORD(bowlX),
+        CONFIG_COORD(bowlY),
+        CONFIG_LENGTH(bowlRadius),
+        CONFIG_BOOL(bowlVisible),
+        CONFIG_LENGTH(bowlNearScale),
+        CONFIG_LENGTH(spawnArea),
+        CONFIG_LENGTH(spawnSpeed),
+        CONFIG_LENGTH(spawnSizeMin),
+        CONFIG_LENGTH(spawnSizeMax),
+        CONFIG_CHANCE(spawnAttractChance),
+        CONFIG_LENGTH(bowlSpawnScale),
+        CONFIG_LENGTH(pondSpawnScale),
+        CONFIG_LENGTH(pondSpawnJitterX),
+        CONFIG_LENGTH(pondSpawnJitterY),
+        CONFIG_COUNT(spawnIntervalNormal),
+        CONFIG_COUNT(spawnIntervalHigh),
+        CONFIG_CHANCE(secondSpawnChance),
+        CONFIG_COUNT(boostAliveThreshold),
+        CONFIG_COUNT(boostNearPond),
+        CONFIG_COUNT(boostNearBowl),
+        CONFIG_BOOL(respawnDead),
+        CONFIG_COUNT(minAlive),
+        CONFIG_COORD(attractAccel),
+        CONFIG_LENGTH(attractMinDist),
+        CONFIG_LENGTH(speedLimit),
+        CONFIG_CHANCE(jitterChance),
+        CONFIG_LENGTH(jitterAmount),
+        CONFIG_COUNT(breedTicks),
+        CONFIG_BOOL(breedAtBowl),
+        CONFIG_COUNT(maxLarvae),
+        CONFIG_LENGTH(larvaOffset),
+        CONFIG_LENGTH(larvaSize),
+        CONFIG_COORD(larvaGrowth),
+        CONFIG_LENGTH(larvaMaxSize),
+        CONFIG_COUNT(larvaMatureTicks),
+        CONFIG_CHANCE(rainChance),
+        CONFIG_COUNT(rainDuration),
+        CONFIG_COUNT(rainSpawnCount),
+        CONFIG_LENGTH(sprayStartRadius),
+        CONFIG_LENGTH(sprayGrowth),
+        CONFIG_LENGTH(sprayMaxRadius),
+        CONFIG_COUNT(sprayDuration),
+        CONFIG_COUNT(maxSprayCharges),
+        CONFIG_COUNT(sprayRefillInterval),
+        CONFIG_COUNT(deadTimerMin),
+        CONFIG_COUNT(deadTimerRange),
+        CONFIG_LENGTH(killScatter),
+        CONFIG_CHANCE(windChance),
+        CONFIG_COUNT(windDuration),
+        CONFIG_LENGTH(windMaxForce),
+        CONFIG_CHANCE(fogChance),
+        CONFIG_COUNT(fogDuration),
+        CONFIG_CHANCE(cleanupChance),
+        CONFIG_COUNT(cleanupDuration),
+        CONFIG_CHANCE(swarmChance),
+        CONFIG_COUNT(swarmMin),
+        CONFIG_COUNT(swarmRange),
+        CONFIG_COUNT(difficultyInterval),
+        CONFIG_COUNT(gameOverAlive),
+    };
+    count = sizeof(fields) / sizeof(fields[0]);
+    return fields;
+}
+
+#undef CONFIG_INT
+#undef CONFIG_FLOAT
+#undef CONFIG_BOOL
+#undef CONFIG_COUNT
+#undef CONFIG_CHANCE
+#undef CONFIG_LENGTH
+#undef CONFIG_COORD
+
+// nullptr if there is no such field
+inline const ConfigField* findConfigField(const char* name) {
+    size_t count;
+    const ConfigField* fields = configFields(count);
+    for (size_t k = 0; k < count; ++k) {
+        if (!strcmp(fields[k].name, name)) return &fields[k];
+    }
+    return nullptr;
+}
+
+#endif // MOSQUITO_CONFIG_FIELDS_H
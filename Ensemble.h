@@ -0,0 +1,140 @@
+// ---------------------------------------------------------------------------
+// Ensemble.h - Monte Carlo replicas of the headless model
+//
+// runEnsemble() runs one World per seed on a ThreadPool and reduces the
+// sampled counters (alive, killed, larvae) as it goes: every replica keeps
+// only its own short series of samples and folds it into one shared
+// IntDistribution per sample and metric when it finishes. No trajectory
+// outlives its replica.
+//
+// The counters are non-negative integers, so IntDistribution keeps an exact
+// sparse histogram: one entry per distinct value seen (at most one per
+// replica), however large the values get. Adding integers is
+// order-independent, and the spread is computed from the histogram, which
+// makes the mean, standard deviation and quantiles identical for any
+// thread count or completion order.
+// ---------------------------------------------------------------------------
+#ifndef MOSQUITO_ENSEMBLE_H
+#define MOSQUITO_ENSEMBLE_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <vector>
+#include "ThreadPool.h"
+#include "World.h"
+
+// Exact distribution of non-negative integers
+class IntDistribution {
+public:
+    void add(int v, uint64_t times = 1) {
+        if (v < 0) v = 0;
+        counts[v] += times;
+        n += times;
+        sum += (double)v * times;
+    }
+
+    void merge(const IntDistribution& o) {
+        for (const auto& c : o.counts) add(c.first, c.second);
+    }
+
+    uint64_t count() const { return n; }
+    double mean() const { return n ? sum / n : 0.0; }
+
+    // Second pass over the histogram: no cancellation, and the same order of
+    // additions however the samples were merged
+    double stddev() const {
+        if (n < 2) return 0.0;
+        double m = mean(), ss = 0.0;
+        for (const auto& c : counts) ss += (double)c.second * (c.first - m) * (c.first - m);
+        return sqrt(ss / (n - 1));
+    }
+
+    // Nearest-rank quantile, q in [0, 1]
+    int quantile(double q) const {
+        if (n == 0) return 0;
+        uint64_t rank = (uint64_t)ceil(q * n);
+        if (rank < 1) rank = 1;
+        uint64_t seen = 0;
+        for (const auto& c : counts) {
+            seen += c.second;
+            if (seen >= rank) return c.first;
+        }
+        return counts.rbegin()->first;
+    }
+
+private:
+    std::map<int, uint64_t> counts; // counts[v] = samples equal to v, only for values seen
+    uint64_t n = 0;
+    double sum = 0.0; // Exact while below 2^53
+};
+
+enum EnsembleMetric { METRIC_ALIVE, METRIC_KILLED, METRIC_LARVAE, METRIC_COUNT };
+
+inline const char* ensembleMetricName(int m) {
+    static const char* names[METRIC_COUNT] = {"alive", "killed", "larvae"};
+    return names[m];
+}
+
+// One replica's run: the world, plus what the operator does to it
+struct Scenario {
+    WorldConfig cfg;
+    long long ticks = 12000;
+    long long sampleEvery = 1200;
+    bool bowl = false;     // Water bowl shown from the start
+    int sprayEvery = 0;    // Spray a random spot every N ticks (0 = never)
+};
+
+// Run one replica, calling onSample(world) every s.sampleEvery ticks
+template <class F>
+inline void runReplica(const Scenario& s, unsigned seed, F onSample) {
+    World world(s.cfg, seed);
+    if (s.bowl && !world.waterBowlVisible) world.toggleBowl();
+    for (long long t = 0; t < s.ticks; ++t) {
+        if (s.sprayEvery > 0 && world.tick % s.sprayEvery == 0) {
+            float x = world.uniform(-world.cfg.bounds, world.cfg.bounds);
+            float y = world.uniform(-world.cfg.bounds, world.cfg.bounds);
+            world.spray(x, y);
+        }
+        world.step();
+        if (world.tick % s.sampleEvery == 0) onSample(world);
+    }
+}
+
+struct EnsembleStats {
+    long long sampleEvery = 0;
+    std::vector<IntDistribution> samples[METRIC_COUNT]; // samples[m][k] is tick (k + 1) * sampleEvery
+    unsigned replicas = 0;
+};
+
+// Seeds firstSeed .. firstSeed + replicas - 1, one pool task each
+inline EnsembleStats runEnsemble(const Scenario& s, unsigned replicas, unsigned firstSeed, ThreadPool& pool) {
+    const size_t points = (size_t)(s.ticks / s.sampleEvery);
+    EnsembleStats stats;
+    stats.sampleEvery = s.sampleEvery;
+    stats.replicas = replicas;
+    for (int m = 0; m < METRIC_COUNT; ++m) stats.samples[m].resize(points);
+    std::mutex merge;
+
+    auto replica = [&](size_t r) {
+        std::vector<int> series(points * METRIC_COUNT);
+        size_t k = 0;
+        runReplica(s, firstSeed + (unsigned)r, [&](const World& world) {
+            if (k == points) return;
+            series[k * METRIC_COUNT + METRIC_ALIVE] = world.totalAlive;
+            series[k * METRIC_COUNT + METRIC_KILLED] = world.totalKilled;
+            series[k * METRIC_COUNT + METRIC_LARVAE] = (int)world.larvae.count();
+            k++;
+        });
+        std::lock_guard<std::mutex> lock(merge);
+        for (size_t p = 0; p < points; ++p) {
+            for (int m = 0; m < METRIC_COUNT; ++m) stats.samples[m][p].add(series[p * METRIC_COUNT + m]);
+        }
+    };
+    pool.run(replicas, replica);
+    return stats;
+}
+
+#endif // MOSQUITO_ENSEMBLE_H
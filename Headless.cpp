@@ -0,0 +1,168 @@
+// Headless.cpp - run the mosquito simulation without a window
+//
+// Build: g++ -std=c++17 -O2 -pthread Headless.cpp -o headless
+// Usage: ./headless [--preset 2d|3d|arcade] [--seed N] [--ticks N | --minutes M]
+//                   [--report N] [--bowl] [--agents N] [--isa scalar|sse2|avx2]
+//                   [--threads N] [--load FILE] [--save FILE]
+//                   [--record FILE] [--record-every N] [--replay FILE]
+//                   [--sites N]
+//
+// Prints one CSV row every --report ticks (default: once per simulated
+// minute) and the achieved ticks/s on stderr at the end. --load starts from
+// a snapshot (its config replaces --preset/--agents) and --save writes one
+// after the last tick. --record writes every mosquito's position each
+// --record-every ticks (default 1) to a trajectory file (Trajectory.h).
+// --replay re-runs a session the front-ends logged (InputLog.h) from its
+// starting state, applying each input on its tick, until the session quit
+// (or for --ticks/--minutes if given). --sites scatters N extra breeding
+// sites (BreedingSites.h) over the arena, placed from --seed.
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "InputLog.h"
+#include "Snapshot.h"
+#include "Trajectory.h"
+#include "World.h"
+
+static void usage(const char* prog) {
+    fprintf(stderr,
+            "Usage: %s [--preset 2d|3d|arcade] [--seed N] [--ticks N | --minutes M]\n"
+            "          [--report N] [--bowl] [--agents N] [--isa scalar|sse2|avx2]\n"
+            "          [--threads N] [--load FILE] [--save FILE]\n"
+            "          [--record FILE] [--record-every N] [--replay FILE]\n"
+            "          [--sites N]\n", prog);
+}
+
+int main(int argc, char** argv) {
+    WorldConfig cfg = WorldConfig::classic2D();
+    unsigned seed = 1;
+    long long ticks = -1;
+    double minutes = -1.0;
+    long long report = 0;
+    bool bowl = false;
+    int agents = 0;
+    int threads = 1;
+    const char* loadPath = nullptr;
+    const char* savePath = nullptr;
+    const char* recordPath = nullptr;
+    const char* replayPath = nullptr;
+    long long recordEvery = 1;
+    int siteCount = 0;
+    MoveIsa isa = bestMoveIsa();
+
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (!strcmp(a, "--preset") && hasValue) {
+            const char* p = argv[++i];
+            if (!strcmp(p, "2d")) cfg = WorldConfig::classic2D();
+            else if (!strcmp(p, "3d")) cfg = WorldConfig::classic3D();
+            else if (!strcmp(p, "arcade")) cfg = WorldConfig::arcade();
+            else { usage(argv[0]); return 1; }
+        } else if (!strcmp(a, "--seed") && hasValue) {
+            seed = (unsigned)strtoul(argv[++i], nullptr, 10);
+        } else if (!strcmp(a, "--ticks") && hasValue) {
+            ticks = atoll(argv[++i]);
+        } else if (!strcmp(a, "--minutes") && hasValue) {
+            minutes = atof(argv[++i]);
+        } else if (!strcmp(a, "--report") && hasValue) {
+            report = atoll(argv[++i]);
+        } else if (!strcmp(a, "--agents") && hasValue) {
+            agents = atoi(argv[++i]);
+        } else if (!strcmp(a, "--isa") && hasValue) {
+            const char* name = argv[++i];
+            if (!strcmp(name, "scalar")) isa = MOVE_SCALAR;
+            else if (!strcmp(name, "sse2")) isa = MOVE_SSE2;
+            else if (!strcmp(name, "avx2")) isa = MOVE_AVX2;
+            else { usage(argv[0]); return 1; }
+            if (!moveIsaSupported(isa)) {
+                fprintf(stderr, "%s is not supported on this CPU\n", name);
+                return 1;
+            }
+        } else if (!strcmp(a, "--threads") && hasValue) {
+            threads = atoi(argv[++i]);
+        } else if (!strcmp(a, "--load") && hasValue) {
+            loadPath = argv[++i];
+        } else if (!strcmp(a, "--save") && hasValue) {
+            savePath = argv[++i];
+        } else if (!strcmp(a, "--record") && hasValue) {
+            recordPath = argv[++i];
+        } else if (!strcmp(a, "--record-every") && hasValue) {
+            recordEvery = atoll(argv[++i]);
+        } else if (!strcmp(a, "--replay") && hasValue) {
+            replayPath = argv[++i];
+        } else if (!strcmp(a, "--sites") && hasValue) {
+            siteCount = atoi(argv[++i]);
+        } else if (!strcmp(a, "--bowl")) {
+            bowl = true;
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (agents > 0) cfg.maxMosquitoes = agents;
+    World world(cfg, seed);
+    if (loadPath) {
+        if (!loadSnapshot(world, loadPath)) {
+            fprintf(stderr, "Cannot load snapshot %s\n", loadPath);
+            return 1;
+        }
+        cfg = world.cfg;
+    }
+    InputQueue inputs;
+    if (replayPath) {
+        if (!loadInputLog(replayPath, world, inputs)) {
+            fprintf(stderr, "Cannot load input log %s\n", replayPath);
+            return 1;
+        }
+        cfg = world.cfg;
+    }
+    world.moveIsa = isa;
+    world.setThreads(threads);
+    if (bowl && !world.waterBowlVisible) world.toggleBowl();
+    if (siteCount > 0) world.setSites(randomSites(siteCount, seed, cfg.bounds));
+    long long ticksPerMinute = 60000 / cfg.tickMillis;
+    bool untilQuit = replayPath && ticks < 0 && minutes < 0;
+    if (ticks < 0) ticks = untilQuit ? LLONG_MAX : (long long)((minutes < 0 ? 10.0 : minutes) * ticksPerMinute);
+    if (report <= 0) report = ticksPerMinute;
+    if (recordEvery <= 0) recordEvery = 1;
+    TrajectoryRecorder recorder;
+    if (recordPath && !recorder.open(recordPath, world.mosquitoes.capacity())) {
+        fprintf(stderr, "Cannot write trajectory %s\n", recordPath);
+        return 1;
+    }
+
+    printf("tick,sim_seconds,alive,killed,larvae,raining\n");
+    auto start = std::chrono::steady_clock::now();
+    long long steps = 0;
+    for (; steps < ticks; ++steps) {
+        if (replayPath) {
+            inputs.apply(world);
+            if (untilQuit && (inputs.ended() || inputs.empty())) break; // Quit, or a log cut short
+        }
+        world.step();
+        if (recordPath && world.tick % recordEvery == 0) recorder.capture(world);
+        if (world.tick % report == 0) {
+            printf("%lld,%.2f,%d,%d,%zu,%d\n", world.tick, world.simSeconds(),
+                   world.totalAlive, world.totalKilled, world.larvae.count(), world.rainActive ? 1 : 0);
+        }
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    fprintf(stderr, "%lld ticks in %.3fs (%.0f ticks/s)\n", steps, secs, secs > 0 ? steps / secs : 0.0);
+    if (recordPath) {
+        if (!recorder.close()) {
+            fprintf(stderr, "Cannot write trajectory %s\n", recordPath);
+            return 1;
+        }
+        fprintf(stderr, "Recorded %llu frames (%llu stalls)\n", (unsigned long long)recorder.frames,
+                (unsigned long long)recorder.stalls);
+    }
+    if (savePath && !saveSnapshot(world, savePath)) {
+        fprintf(stderr, "Cannot write snapshot %s\n", savePath);
+        return 1;
+    }
+    return 0;
+}
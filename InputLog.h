@@ -0,0 +1,262 @@
+// ---------------------------------------------------------------------------
+// InputLog.h - tick-stamped user input, recorded for exact replay
+//
+// The front-ends no longer call World's user actions from their GLUT
+// callbacks. Each input is pushed onto an InputQueue stamped with the tick it
+// applies on (the world's current tick, i.e. before the next step()), and
+// stepSimulation() applies everything due right before World::step(). A
+// random spray draws its target when applied, not when the key was pressed,
+// so the world stream advances at the same point on every run.
+//
+// While recording, every applied input is appended to a log file:
+//   "MOSQINPT", u32 version
+//   a snapshot of the world when recording started (Snapshot.h)
+//   per input: varint tick delta, u8 type, then the type's payload
+//              (f32 x, f32 y for sprays and bowl moves, i32 for the
+//              environment state or restart seed)
+// The tick delta counts from the previous input, or from 0 after a restart,
+// which resets the tick count; inputs queued in the frame of a restart apply
+// (and are logged) at tick 0 of the new run. A quit input marks where the session ended.
+// Recording restarts from the new state when a snapshot is loaded.
+//
+// loadInputLog() restores the starting world and fills a queue with the
+// logged inputs; stepping that world and applying the queue before each step
+// re-runs the session exactly (Headless.cpp --replay).
+// ---------------------------------------------------------------------------
+#ifndef MOSQUITO_INPUT_LOG_H
+#define MOSQUITO_INPUT_LOG_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "Snapshot.h"
+#include "World.h"
+
+const uint32_t inputLogVersion = 1;
+
+enum InputType {
+    INPUT_SPRAY,            // At (x, y)
+    INPUT_SPRAY_RANDOM,     // Anywhere in [-x, x] on both axes
+    INPUT_TOGGLE_BOWL,
+    INPUT_MOVE_BOWL,        // To (x, y)
+    INPUT_RAIN,
+    INPUT_ENVIRONMENT,      // Set to value
+    INPUT_RESTART,          // Reseed with value
+    INPUT_QUIT,
+    INPUT_TYPES
+};
+
+struct InputEvent {
+    long long tick;
+    int type;
+    float x, y;
+    int32_t value;
+    bool accepted; // Set when applied: false for a spray without charges or rain while raining
+};
+
+class InputQueue {
+public:
+    ~InputQueue() { stopRecording(); }
+
+    // Queue an input for the world's next step
+    void push(const World& world, int type, float x = 0.0f, float y = 0.0f, int32_t value = 0) {
+        // A drag sends many moves per tick; only the last one can matter
+        if (type == INPUT_MOVE_BOWL && pending.size() > next && pending.back().type == INPUT_MOVE_BOWL &&
+            pending.back().tick == world.tick) {
+            pending.back().x = x;
+            pending.back().y = y;
+            return;
+        }
+        InputEvent e = {world.tick, type, x, y, value, false};
+        pending.push_back(e);
+    }
+
+    // Queue an input exactly as logged
+    void schedule(const InputEvent& e) {
+        pending.push_back(e);
+        replaying = true;
+    }
+
+    bool empty() const { return next == pending.size(); }
+    bool ended() const { return quit; }
+
+    // Apply every input due at the world's current tick, in the order pushed,
+    // then call onApplied(event) for each (with accepted and, for a random
+    // spray, the chosen target filled in)
+    template <class F>
+    void apply(World& world, F onApplied) {
+        bool logged = false;
+        while (next < pending.size() && !quit && pending[next].tick <= world.tick) {
+            InputEvent e = pending[next++];
+            if (log) {
+                writeEvent(e);
+                logged = true;
+            }
+            e.accepted = true;
+            switch (e.type) {
+                case INPUT_SPRAY:
+                    e.accepted = world.spray(e.x, e.y);
+                    break;
+                case INPUT_SPRAY_RANDOM: {
+                    float range = e.x;
+                    e.x = world.uniform(-range, range);
+                    e.y = world.uniform(-range, range);
+                    e.accepted = world.spray(e.x, e.y);
+                    break;
+                }
+                case INPUT_TOGGLE_BOWL:
+                    world.toggleBowl();
+                    break;
+                case INPUT_MOVE_BOWL:
+                    world.moveBowl(e.x, e.y);
+                    break;
+                case INPUT_RAIN:
+                    e.accepted = world.triggerRain();
+                    break;
+                case INPUT_ENVIRONMENT:
+                    world.setEnvironment(e.value);
+                    break;
+                case INPUT_RESTART:
+                    world.reset((unsigned)e.value);
+                    lastTick = 0;
+                    // Inputs pushed in the same frame carry the old run's ticks;
+                    // they are due now. A log's are already in the new run's.
+                    if (!replaying)
+                        for (size_t k = next; k < pending.size(); ++k) pending[k].tick = world.tick;
+                    break;
+                case INPUT_QUIT:
+                    quit = true;
+                    break;
+            }
+            onApplied(e);
+        }
+        if (next == pending.size()) {
+            pending.clear();
+            next = 0;
+        }
+        if (logged) fflush(log);
+    }
+
+    void apply(World& world) {
+        apply(world, [](const InputEvent&) {});
+    }
+
+    // Start a log at path from world's current state; drops unapplied inputs
+    bool record(const char* path, const World& world) {
+        stopRecording();
+        pending.clear();
+        next = 0;
+        log = fopen(path, "wb");
+        if (!log) return false;
+        uint32_t version = inputLogVersion;
+        bool ok = fwrite("MOSQINPT", 1, 8, log) == 8 && fwrite(&version, 4, 1, log) == 1 && writeSnapshot(log, world);
+        lastTick = world.tick;
+        if (!ok || fflush(log) != 0) {
+            stopRecording();
+            return false;
+        }
+        return true;
+    }
+
+    // Log a quit at the world's current tick and close the log
+    void finish(const World& world) {
+        if (!log) return;
+        InputEvent e = {world.tick, INPUT_QUIT, 0.0f, 0.0f, 0, true};
+        writeEvent(e);
+        stopRecording();
+    }
+
+    void stopRecording() {
+        if (log) fclose(log);
+        log = nullptr;
+    }
+
+    bool recording() const { return log != nullptr; }
+
+private:
+    std::vector<InputEvent> pending; // [next, size) not applied yet
+    size_t next = 0;
+    bool quit = false;
+    bool replaying = false; // Filled by schedule(), not push()
+    FILE* log = nullptr;
+    long long lastTick = 0;
+
+    void writeEvent(const InputEvent& e) {
+        uint64_t delta = e.tick > lastTick ? (uint64_t)(e.tick - lastTick) : 0;
+        lastTick = e.tick;
+        unsigned char buf[32];
+        size_t n = 0;
+        do {
+            buf[n] = delta & 0x7f;
+            delta >>= 7;
+            if (delta) buf[n] |= 0x80;
+            n++;
+        } while (delta);
+        buf[n++] = (unsigned char)e.type;
+        n += writePayload(e, buf + n);
+        fwrite(buf, 1, n, log);
+    }
+
+    static size_t writePayload(const InputEvent& e, unsigned char* out) {
+        switch (e.type) {
+            case INPUT_SPRAY:
+            case INPUT_SPRAY_RANDOM:
+            case INPUT_MOVE_BOWL: {
+                float xy[2] = {e.x, e.y};
+                for (float& v : xy) v = hostIsLittleEndian() ? v : byteSwapped(v);
+                memcpy(out, xy, 8);
+                return 8;
+            }
+            case INPUT_ENVIRONMENT:
+            case INPUT_RESTART: {
+                int32_t v = hostIsLittleEndian() ? e.value : byteSwapped(e.value);
+                memcpy(out, &v, 4);
+                return 4;
+            }
+            default:
+                return 0;
+        }
+    }
+};
+
+// Restore the world a log starts from and queue its inputs. false (world
+// untouched) if the file is missing, not an input log, or from a newer build.
+// A log cut short keeps the inputs before the damage.
+inline bool loadInputLog(const char* path, World& world, InputQueue& queue) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+    char magic[8];
+    uint32_t version = 0;
+    bool ok = fread(magic, 1, 8, f) == 8 && !memcmp(magic, "MOSQINPT", 8) && fread(&version, 4, 1, f) == 1;
+    if (!hostIsLittleEndian()) version = byteSwapped(version);
+    ok = ok && version >= 1 && version <= inputLogVersion && readSnapshot(f, world);
+    long long tick = world.tick;
+    for (int c; ok && (c = fgetc(f)) != EOF;) {
+        uint64_t delta = 0;
+        for (int shift = 0;; shift += 7) {
+            delta |= (uint64_t)(c & 0x7f) << shift;
+            if (!(c & 0x80) || shift > 56) break;
+            if ((c = fgetc(f)) == EOF) break;
+        }
+        int type = fgetc(f);
+        if (c == EOF || type < 0 || type >= INPUT_TYPES) break;
+        InputEvent e = {tick + (long long)delta, type, 0.0f, 0.0f, 0, false};
+        if (type == INPUT_SPRAY || type == INPUT_SPRAY_RANDOM || type == INPUT_MOVE_BOWL) {
+            float xy[2];
+            if (fread(xy, 4, 2, f) != 2) break;
+            e.x = hostIsLittleEndian() ? xy[0] : byteSwapped(xy[0]);
+            e.y = hostIsLittleEndian() ? xy[1] : byteSwapped(xy[1]);
+        } else if (type == INPUT_ENVIRONMENT || type == INPUT_RESTART) {
+            int32_t v;
+            if (fread(&v, 4, 1, f) != 1) break;
+            e.value = hostIsLittleEndian() ? v : byteSwapped(v);
+        }
+        queue.schedule(e);
+        tick = type == INPUT_RESTART ? 0 : e.tick;
+    }
+    fclose(f);
+    return ok;
+}
+
+#endif // MOSQUITO_INPUT_LOG_H
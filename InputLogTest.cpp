@@ -0,0 +1,77 @@
+// InputLogTest.cpp - checks for the input queue and its log (InputLog.h)
+//
+// Build: g++ -std=c++17 -O2 -pthread InputLogTest.cpp -o inputlogtest
+// Usage: ./inputlogtest [scratch file]
+//
+// Prints one line per check and exits non-zero if any fails. The log is
+// written to the scratch file (default inputlogtest.bin) and removed after.
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "InputLog.h"
+#include "World.h"
+
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+    printf("%-52s %s\n", what, ok ? "ok" : "FAILED");
+    if (!ok) failures++;
+}
+
+// FNV-1a over the position columns, as Benchmark.cpp's thread check
+static uint64_t stateHash(const World& world) {
+    const Population& m = world.mosquitoes;
+    uint64_t h = 1469598103934665603ULL;
+    for (size_t i = 0; i < m.count(); ++i) {
+        uint32_t bits[2];
+        memcpy(&bits[0], &m.x[i], 4);
+        memcpy(&bits[1], &m.y[i], 4);
+        h = (h ^ bits[0]) * 1099511628211ULL;
+        h = (h ^ bits[1]) * 1099511628211ULL;
+    }
+    return (h ^ (uint64_t)world.tick) * 1099511628211ULL;
+}
+
+// A restart and a spray pressed in the same frame: the spray must land on
+// tick 0 of the new run, live and in the replay of the session's log
+static void restartThenSpray(const char* path) {
+    World world(WorldConfig::arcade(), 1);
+    InputQueue inputs;
+    for (int t = 0; t < 100; ++t) world.step();
+    check(inputs.record(path, world), "record starts");
+
+    inputs.push(world, INPUT_RESTART, 0.0f, 0.0f, 7);
+    inputs.push(world, INPUT_SPRAY, 0.2f, -0.1f);
+    std::vector<InputEvent> applied;
+    inputs.apply(world, [&](const InputEvent& e) { applied.push_back(e); });
+    check(applied.size() == 2, "restart and spray apply in one frame");
+    check(applied.size() == 2 && applied[1].tick == 0 && applied[1].accepted, "spray applies at the new run's tick 0");
+    check(inputs.empty(), "nothing left queued");
+
+    for (int t = 0; t < 200; ++t) {
+        if (t == 50) inputs.push(world, INPUT_SPRAY, -0.3f, 0.4f);
+        inputs.apply(world);
+        world.step();
+    }
+    inputs.finish(world);
+    uint64_t live = stateHash(world);
+
+    World replay(WorldConfig::arcade(), 99);
+    InputQueue logged;
+    check(loadInputLog(path, replay, logged), "log loads");
+    std::vector<long long> ticks;
+    while (true) {
+        logged.apply(replay, [&](const InputEvent& e) { ticks.push_back(replay.tick); });
+        if (logged.ended() || logged.empty()) break;
+        replay.step();
+    }
+    check(ticks.size() == 4 && ticks[1] == 0 && ticks[2] == 50, "replay applies inputs on the same ticks");
+    check(stateHash(replay) == live, "replay ends in the live state");
+}
+
+int main(int argc, char** argv) {
+    const char* path = argc > 1 ? argv[1] : "inputlogtest.bin";
+    restartThenSpray(path);
+    remove(path);
+    return failures ? 1 : 0;
+}
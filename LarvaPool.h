@@ -0,0 +1,123 @@
+// ---------------------------------------------------------------------------
+// LarvaPool.h - structure-of-arrays larva store
+//
+// One column per field, like Population.h, kept in laying order. Removing a
+// larva (hatched or sprayed) only clears its alive byte and costs O(1);
+// the tombstones are squeezed out by compact(), a single stable pass, once
+// they outnumber the live larvae or the slots run out. A spray that wipes
+// every larva is therefore one linear pass, never an erase per larva.
+//
+// Slots [0, used()) hold larvae in the order they were laid, tombstones
+// included; loops skip entries whose alive byte is 0. Keeping the order
+// means the larvae due to hatch are always the first live ones.
+//
+// Capacity is set by assign(); add() compacts when the slots are used up
+// and fails once every slot holds a live larva. A capacity of 0 means
+// unbounded (the columns grow on demand).
+// ---------------------------------------------------------------------------
+#ifndef MOSQUITO_LARVA_POOL_H
+#define MOSQUITO_LARVA_POOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct LarvaPool {
+    std::vector<float> x, y;
+    std::vector<float> size;          // When laid; World::larvaSize() has the grown size
+    std::vector<long long> laidTick;  // World::tick it was laid on
+    std::vector<int32_t> site;        // World's breeding site it was laid at, -1 for the pond and bowl
+    std::vector<unsigned char> alive; // 0 = removed, slot reclaimed by compact()
+    size_t front = 0;                 // Every slot before this one is a tombstone
+    unsigned layout = 0;              // Bumped whenever slots are moved or dropped, for indexes over them
+
+    size_t count() const { return live; }
+    size_t used() const { return n; }
+    size_t capacity() const { return bounded ? x.size() : 0; }
+    bool empty() const { return live == 0; }
+
+    // Empty pool of cap slots (0 = unbounded)
+    void assign(size_t cap) {
+        bounded = cap > 0;
+        x.assign(cap, 0.0f);
+        y.assign(cap, 0.0f);
+        size.assign(cap, 0.0f);
+        laidTick.assign(cap, 0);
+        site.assign(cap, -1);
+        alive.assign(cap, 0);
+        clear();
+    }
+
+    void clear() {
+        n = live = front = 0;
+        layout++;
+    }
+
+    // Append a larva; false if every slot holds a live one. May compact, so
+    // slot indices held across an add() are not stable.
+    bool add(float lx, float ly, float lsize, long long laid, int32_t lsite = -1) {
+        if (n == x.size()) {
+            if (live < n) compact();
+            else if (bounded) return false;
+            else grow();
+        }
+        x[n] = lx;
+        y[n] = ly;
+        size[n] = lsize;
+        laidTick[n] = laid;
+        site[n] = lsite;
+        alive[n] = 1;
+        n++;
+        live++;
+        return true;
+    }
+
+    void remove(size_t i) {
+        if (!alive[i]) return;
+        alive[i] = 0;
+        live--;
+    }
+
+    // compact() once tombstones outnumber live larvae: amortized O(1) per removal
+    bool wantsCompact() const { return n - live > live; }
+
+    // Close the gaps, keeping order. Returns whether anything moved.
+    bool compact() {
+        if (live == n) return false;
+        size_t out = 0;
+        for (size_t i = front; i < n; ++i) {
+            if (!alive[i]) continue;
+            if (out != i) {
+                x[out] = x[i];
+                y[out] = y[i];
+                size[out] = size[i];
+                laidTick[out] = laidTick[i];
+                site[out] = site[i];
+                alive[out] = 1;
+            }
+            out++;
+        }
+        for (size_t i = out; i < n; ++i) alive[i] = 0;
+        n = out;
+        front = 0;
+        layout++;
+        return true;
+    }
+
+private:
+    size_t n = 0;    // Slots in use
+    size_t live = 0; // Of which alive
+    bool bounded = false;
+
+    void grow() {
+        size_t cap = x.empty() ? 64 : x.size() * 2;
+        x.resize(cap, 0.0f);
+        y.resize(cap, 0.0f);
+        size.resize(cap, 0.0f);
+        laidTick.resize(cap, 0);
+        site.resize(cap, -1);
+        alive.resize(cap, 0);
+    }
+};
+
+#endif // MOSQUITO_LARVA_POOL_H
@@ -0,0 +1,401 @@
+// ---------------------------------------------------------------------------
+// MosquitoInstancer.h - instanced mosquito drawing for the 3D front-ends
+//
+// Draws a whole population with one glDrawElementsInstanced call instead of
+// one display list per agent. The mesh is the MosquitoMesh.h triangle list
+// the front-ends also compile into their display lists, so both paths draw
+// the same triangles and colours.
+//
+// Per-instance data comes straight from the engine's SoA columns: x, y,
+// size, an optional hover phase (e.g. Population::slot) and an optional
+// blood-fed byte are memcpy'd each frame into a persistently mapped buffer.
+// The buffer is split into three regions, each guarded by a fence, so the
+// CPU never overwrites instances the GPU may still be reading. The vertex
+// shader places each instance at (x, y, base + amplitude * sin(angle +
+// phase)), scales the mesh by size and switches to the blood-fed colours.
+//
+// Needs GL 3.3 with GL 4.4 or ARB_buffer_storage, in a compatibility
+// context for the GLSL 1.20 built-ins; Mesa's llvmpipe provides all of it.
+// init() returns false otherwise and the caller keeps its display lists.
+// So does reserve() if the GL cannot map a buffer for that many instances;
+// the instancer is then no longer ready() and draws nothing.
+// The mesh buffers are never freed; they live as long as the window's context.
+// ---------------------------------------------------------------------------
+#ifndef MOSQUITO_INSTANCER_H
+#define MOSQUITO_INSTANCER_H
+
+#include <GL/glut.h>
+// glutGetProcAddress is freeglut's; the entry point types come from glext.h.
+// Without either (plain GLUT, MSVC's GL 1.1 headers) the class below is a
+// stub whose init() fails, and the front-ends keep their display lists.
+#if defined(FREEGLUT) && defined(__has_include)
+#if __has_include(<GL/freeglut_ext.h>) && __has_include(<GL/glext.h>)
+#include <GL/freeglut_ext.h>
+#include <GL/glext.h>
+#endif
+#endif
+#if defined(FREEGLUT) && defined(GL_VERSION_4_4)
+#define MOSQUITO_INSTANCING 1
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <vector>
+#include "MosquitoMesh.h"
+
+#ifdef MOSQUITO_INSTANCING
+
+class MosquitoInstancer {
+public:
+    struct Hover {
+        float base, amplitude, angle; // z = base + amplitude * sin(angle + phase)
+    };
+
+    MosquitoInstancer() = default;
+    MosquitoInstancer(const MosquitoInstancer&) = delete;
+    MosquitoInstancer& operator=(const MosquitoInstancer&) = delete;
+
+    bool ready() const { return program != 0; }
+
+    // Upload the mesh (and its blood-fed colours, same triangles) and set up
+    // the shader. Needs a current GL context.
+    bool init(const std::vector<MeshVertex>& plain, const std::vector<MeshVertex>& fed) {
+        if (plain.empty() || fed.size() != plain.size() || !supported() || !load() || !compile()) return false;
+        // Interleaved position, normal, colour, blood-fed colour. Corners
+        // shared between triangles are stored once and indexed, so each is
+        // shaded once per instance.
+        static_assert(sizeof(MeshVertex) == 10 * sizeof(float), "MeshVertex is ten packed floats");
+        std::vector<float> mesh;
+        std::vector<GLuint> indices;
+        std::map<std::vector<float>, GLuint> seen;
+        std::vector<float> key(MESH_FLOATS);
+        for (size_t v = 0; v < plain.size(); ++v) {
+            memcpy(key.data(), &plain[v].x, 10 * sizeof(float));
+            memcpy(key.data() + 10, &fed[v].r, 4 * sizeof(float));
+            auto found = seen.emplace(key, (GLuint)seen.size());
+            if (found.second) mesh.insert(mesh.end(), key.begin(), key.end());
+            indices.push_back(found.first->second);
+        }
+        indexCount = (GLsizei)indices.size();
+        gl.GenBuffers(1, &meshBuffer);
+        gl.BindBuffer(GL_ARRAY_BUFFER, meshBuffer);
+        gl.BufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(mesh.size() * sizeof(float)), mesh.data(), GL_STATIC_DRAW);
+        gl.BindBuffer(GL_ARRAY_BUFFER, 0);
+        gl.GenBuffers(1, &indexBuffer);
+        gl.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+        gl.BufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)(indices.size() * sizeof(GLuint)), indices.data(),
+                      GL_STATIC_DRAW);
+        gl.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        return true;
+    }
+
+    // Make room for n instances; false (and no longer ready) if the GL cannot
+    bool reserve(size_t n) {
+        if (!ready()) return false;
+        if (n <= capacity) return true;
+        if (grow(n)) return true;
+        fprintf(stderr, "MosquitoInstancer: cannot map %zu instances\n", capacity);
+        releaseInstances();
+        capacity = 0;
+        gl.DeleteProgram(program);
+        program = 0;
+        return false;
+    }
+
+    // Draw n instances. phase and fed may be null (all 0).
+    void draw(const float* x, const float* y, const float* size, const uint32_t* phase,
+              const unsigned char* fed, size_t n, const Hover& hover) {
+        if (n == 0 || !reserve(n)) return;
+
+        // Wait until the GPU is done with the oldest region before refilling it
+        if (fences[region]) {
+            while (gl.ClientWaitSync(fences[region], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ULL) == GL_TIMEOUT_EXPIRED) {}
+            gl.DeleteSync(fences[region]);
+            fences[region] = 0;
+        }
+        size_t base = region * regionBytes;
+        unsigned char* out = mapped + base;
+        memcpy(out + offsetX(), x, n * sizeof(float));
+        memcpy(out + offsetY(), y, n * sizeof(float));
+        memcpy(out + offsetSize(), size, n * sizeof(float));
+        if (phase) memcpy(out + offsetPhase(), phase, n * sizeof(uint32_t));
+        if (fed) memcpy(out + offsetFed(), fed, n);
+
+        gl.UseProgram(program);
+        gl.Uniform3f(hoverLoc, hover.base, hover.amplitude, hover.angle);
+        gl.Uniform1f(litLoc, glIsEnabled(GL_LIGHTING) ? 1.0f : 0.0f);
+
+        gl.BindBuffer(GL_ARRAY_BUFFER, meshBuffer);
+        const GLsizei stride = MESH_FLOATS * sizeof(float);
+        meshAttrib(ATTR_POSITION, 3, stride, 0);
+        meshAttrib(ATTR_NORMAL, 3, stride, 3);
+        meshAttrib(ATTR_COLOUR, 4, stride, 6);
+        meshAttrib(ATTR_FED_COLOUR, 4, stride, 10);
+
+        gl.BindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+        instanceAttrib(ATTR_X, GL_FLOAT, base + offsetX());
+        instanceAttrib(ATTR_Y, GL_FLOAT, base + offsetY());
+        instanceAttrib(ATTR_SIZE, GL_FLOAT, base + offsetSize());
+        if (phase) instanceAttrib(ATTR_PHASE, GL_UNSIGNED_INT, base + offsetPhase());
+        else gl.VertexAttrib1f(ATTR_PHASE, 0.0f);
+        if (fed) instanceAttrib(ATTR_FED, GL_UNSIGNED_BYTE, base + offsetFed());
+        else gl.VertexAttrib1f(ATTR_FED, 0.0f);
+
+        gl.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+        gl.DrawElementsInstanced(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, nullptr, (GLsizei)n);
+        fences[region] = gl.FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        region = (region + 1) % REGIONS;
+
+        for (GLuint a = 0; a < ATTRIBS; ++a) {
+            gl.VertexAttribDivisor(a, 0);
+            gl.DisableVertexAttribArray(a);
+        }
+        gl.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        gl.BindBuffer(GL_ARRAY_BUFFER, 0);
+        gl.UseProgram(0);
+    }
+
+private:
+    enum {
+        ATTR_POSITION, ATTR_NORMAL, ATTR_COLOUR, ATTR_FED_COLOUR, // Per vertex
+        ATTR_X, ATTR_Y, ATTR_SIZE, ATTR_PHASE, ATTR_FED,          // Per instance
+        ATTRIBS
+    };
+    static const int MESH_FLOATS = 14; // Position, normal, colour, fed colour
+    static const size_t REGIONS = 3;
+
+    struct Functions {
+        PFNGLGENBUFFERSPROC GenBuffers;
+        PFNGLDELETEBUFFERSPROC DeleteBuffers;
+        PFNGLBINDBUFFERPROC BindBuffer;
+        PFNGLBUFFERDATAPROC BufferData;
+        PFNGLBUFFERSTORAGEPROC BufferStorage;
+        PFNGLMAPBUFFERRANGEPROC MapBufferRange;
+        PFNGLUNMAPBUFFERPROC UnmapBuffer;
+        PFNGLVERTEXATTRIBPOINTERPROC VertexAttribPointer;
+        PFNGLVERTEXATTRIB1FPROC VertexAttrib1f;
+        PFNGLVERTEXATTRIBDIVISORPROC VertexAttribDivisor;
+        PFNGLENABLEVERTEXATTRIBARRAYPROC EnableVertexAttribArray;
+        PFNGLDISABLEVERTEXATTRIBARRAYPROC DisableVertexAttribArray;
+        PFNGLDRAWELEMENTSINSTANCEDPROC DrawElementsInstanced;
+        PFNGLCREATESHADERPROC CreateShader;
+        PFNGLSHADERSOURCEPROC ShaderSource;
+        PFNGLCOMPILESHADERPROC CompileShader;
+        PFNGLGETSHADERIVPROC GetShaderiv;
+        PFNGLGETSHADERINFOLOGPROC GetShaderInfoLog;
+        PFNGLDELETESHADERPROC DeleteShader;
+        PFNGLCREATEPROGRAMPROC CreateProgram;
+        PFNGLATTACHSHADERPROC AttachShader;
+        PFNGLBINDATTRIBLOCATIONPROC BindAttribLocation;
+        PFNGLLINKPROGRAMPROC LinkProgram;
+        PFNGLGETPROGRAMIVPROC GetProgramiv;
+        PFNGLGETPROGRAMINFOLOGPROC GetProgramInfoLog;
+        PFNGLDELETEPROGRAMPROC DeleteProgram;
+        PFNGLUSEPROGRAMPROC UseProgram;
+        PFNGLGETUNIFORMLOCATIONPROC GetUniformLocation;
+        PFNGLUNIFORM1FPROC Uniform1f;
+        PFNGLUNIFORM3FPROC Uniform3f;
+        PFNGLFENCESYNCPROC FenceSync;
+        PFNGLCLIENTWAITSYNCPROC ClientWaitSync;
+        PFNGLDELETESYNCPROC DeleteSync;
+    };
+
+    Functions gl = {};
+    GLuint program = 0;
+    GLint hoverLoc = -1, litLoc = -1;
+    GLuint meshBuffer = 0, indexBuffer = 0, instanceBuffer = 0;
+    GLsizei indexCount = 0;
+    unsigned char* mapped = nullptr;
+    size_t capacity = 0;    // Instances per region
+    size_t regionBytes = 0;
+    size_t region = 0;
+    GLsync fences[REGIONS] = {};
+
+    // Column offsets within a region, each 16-byte aligned
+    static size_t align16(size_t v) { return (v + 15) & ~(size_t)15; }
+    size_t offsetX() const { return 0; }
+    size_t offsetY() const { return align16(capacity * 4); }
+    size_t offsetSize() const { return 2 * align16(capacity * 4); }
+    size_t offsetPhase() const { return 3 * align16(capacity * 4); }
+    size_t offsetFed() const { return 4 * align16(capacity * 4); }
+
+    static bool supported() {
+        const char* version = (const char*)glGetString(GL_VERSION);
+        const char* extensions = (const char*)glGetString(GL_EXTENSIONS);
+        int major = 0, minor = 0;
+        if (!version || sscanf(version, "%d.%d", &major, &minor) != 2) return false;
+        int v = major * 10 + minor;
+        return v >= 33 && (v >= 44 || (extensions && strstr(extensions, "GL_ARB_buffer_storage")));
+    }
+
+    template <class P>
+    static bool proc(P& out, const char* name) {
+        out = (P)glutGetProcAddress(name);
+        return out != nullptr;
+    }
+
+    bool load() {
+        return proc(gl.GenBuffers, "glGenBuffers") && proc(gl.DeleteBuffers, "glDeleteBuffers") &&
+               proc(gl.BindBuffer, "glBindBuffer") && proc(gl.BufferData, "glBufferData") &&
+               proc(gl.BufferStorage, "glBufferStorage") && proc(gl.MapBufferRange, "glMapBufferRange") &&
+               proc(gl.UnmapBuffer, "glUnmapBuffer") && proc(gl.VertexAttribPointer, "glVertexAttribPointer") &&
+               proc(gl.VertexAttrib1f, "glVertexAttrib1f") &&
+               proc(gl.VertexAttribDivisor, "glVertexAttribDivisor") &&
+               proc(gl.EnableVertexAttribArray, "glEnableVertexAttribArray") &&
+               proc(gl.DisableVertexAttribArray, "glDisableVertexAttribArray") &&
+               proc(gl.DrawElementsInstanced, "glDrawElementsInstanced") &&
+               proc(gl.CreateShader, "glCreateShader") && proc(gl.ShaderSource, "glShaderSource") &&
+               proc(gl.CompileShader, "glCompileShader") && proc(gl.GetShaderiv, "glGetShaderiv") &&
+               proc(gl.GetShaderInfoLog, "glGetShaderInfoLog") && proc(gl.DeleteShader, "glDeleteShader") &&
+               proc(gl.CreateProgram, "glCreateProgram") && proc(gl.AttachShader, "glAttachShader") &&
+               proc(gl.BindAttribLocation, "glBindAttribLocation") && proc(gl.LinkProgram, "glLinkProgram") &&
+               proc(gl.GetProgramiv, "glGetProgramiv") && proc(gl.GetProgramInfoLog, "glGetProgramInfoLog") &&
+               proc(gl.DeleteProgram, "glDeleteProgram") && proc(gl.UseProgram, "glUseProgram") &&
+               proc(gl.GetUniformLocation, "glGetUniformLocation") && proc(gl.Uniform1f, "glUniform1f") &&
+               proc(gl.Uniform3f, "glUniform3f") && proc(gl.FenceSync, "glFenceSync") &&
+               proc(gl.ClientWaitSync, "glClientWaitSync") && proc(gl.DeleteSync, "glDeleteSync");
+    }
+
+    GLuint shader(GLenum type, const char* source) {
+        GLuint s = gl.CreateShader(type);
+        gl.ShaderSource(s, 1, &source, nullptr);
+        gl.CompileShader(s);
+        GLint ok = 0;
+        gl.GetShaderiv(s, GL_COMPILE_STATUS, &ok);
+        if (!ok) {
+            char log[1024];
+            gl.GetShaderInfoLog(s, sizeof(log), nullptr, log);
+            fprintf(stderr, "MosquitoInstancer: shader: %s\n", log);
+            gl.DeleteShader(s);
+            return 0;
+        }
+        return s;
+    }
+
+    // Fixed-function lighting with GL_COLOR_MATERIAL, one light, no specular
+    bool compile() {
+        static const char* vertexSource =
+            "#version 120\n"
+            "attribute vec3 position;\n"
+            "attribute vec3 normal;\n"
+            "attribute vec4 colour;\n"
+            "attribute vec4 fedColour;\n"
+            "attribute float agentX, agentY, agentSize, agentPhase, agentFed;\n"
+            "uniform vec3 hover;\n"
+            "uniform float lit;\n"
+            "varying vec4 shade;\n"
+            "void main() {\n"
+            "    float z = hover.x + hover.y * sin(hover.z + agentPhase);\n"
+            "    vec4 p = vec4(position * agentSize + vec3(agentX, agentY, z), 1.0);\n"
+            "    vec4 eye = gl_ModelViewMatrix * p;\n"
+            "    gl_Position = gl_ProjectionMatrix * eye;\n"
+            "    vec4 c = mix(colour, fedColour, agentFed);\n"
+            "    if (lit > 0.5) {\n"
+            "        vec4 lp = gl_LightSource[0].position;\n"
+            "        vec3 l = normalize(lp.xyz - eye.xyz * lp.w);\n"
+            "        float d = max(dot(normalize(gl_NormalMatrix * normal), l), 0.0);\n"
+            "        c.rgb *= gl_LightModel.ambient.rgb + gl_LightSource[0].ambient.rgb +\n"
+            "                 gl_LightSource[0].diffuse.rgb * d;\n"
+            "    }\n"
+            "    shade = clamp(c, 0.0, 1.0);\n"
+            "}\n";
+        static const char* fragmentSource =
+            "#version 120\n"
+            "varying vec4 shade;\n"
+            "void main() { gl_FragColor = shade; }\n";
+        static const char* names[ATTRIBS] = {"position", "normal", "colour", "fedColour", "agentX",
+                                             "agentY", "agentSize", "agentPhase", "agentFed"};
+        GLuint vs = shader(GL_VERTEX_SHADER, vertexSource);
+        GLuint fs = shader(GL_FRAGMENT_SHADER, fragmentSource);
+        if (!vs || !fs) return false;
+        program = gl.CreateProgram();
+        gl.AttachShader(program, vs);
+        gl.AttachShader(program, fs);
+        for (GLuint a = 0; a < ATTRIBS; ++a) gl.BindAttribLocation(program, a, names[a]);
+        gl.LinkProgram(program);
+        gl.DeleteShader(vs);
+        gl.DeleteShader(fs);
+        GLint ok = 0;
+        gl.GetProgramiv(program, GL_LINK_STATUS, &ok);
+        if (!ok) {
+            char log[1024];
+            gl.GetProgramInfoLog(program, sizeof(log), nullptr, log);
+            fprintf(stderr, "MosquitoInstancer: link: %s\n", log);
+            gl.DeleteProgram(program);
+            program = 0;
+            return false;
+        }
+        hoverLoc = gl.GetUniformLocation(program, "hover");
+        litLoc = gl.GetUniformLocation(program, "lit");
+        return true;
+    }
+
+    void meshAttrib(GLuint a, GLint components, GLsizei stride, int firstFloat) {
+        gl.EnableVertexAttribArray(a);
+        gl.VertexAttribPointer(a, components, GL_FLOAT, GL_FALSE, stride,
+                               (const void*)(size_t)(firstFloat * sizeof(float)));
+    }
+
+    void instanceAttrib(GLuint a, GLenum type, size_t offset) {
+        gl.EnableVertexAttribArray(a);
+        gl.VertexAttribPointer(a, 1, type, GL_FALSE, 0, (const void*)offset);
+        gl.VertexAttribDivisor(a, 1);
+    }
+
+    // Immutable storage cannot be resized, so growing makes a new buffer
+    bool grow(size_t n) {
+        releaseInstances();
+        capacity = std::max(n, capacity * 2);
+        regionBytes = align16(offsetFed() + capacity);
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        gl.GenBuffers(1, &instanceBuffer);
+        gl.BindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+        gl.BufferStorage(GL_ARRAY_BUFFER, (GLsizeiptr)(regionBytes * REGIONS), nullptr, flags);
+        mapped = (unsigned char*)gl.MapBufferRange(GL_ARRAY_BUFFER, 0, (GLsizeiptr)(regionBytes * REGIONS), flags);
+        gl.BindBuffer(GL_ARRAY_BUFFER, 0);
+        region = 0;
+        return mapped != nullptr;
+    }
+
+    void releaseInstances() {
+        for (GLsync& f : fences) {
+            if (!f) continue;
+            gl.ClientWaitSync(f, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ULL);
+            gl.DeleteSync(f);
+            f = 0;
+        }
+        if (instanceBuffer) {
+            if (mapped) {
+                gl.BindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+                gl.UnmapBuffer(GL_ARRAY_BUFFER);
+                gl.BindBuffer(GL_ARRAY_BUFFER, 0);
+            }
+            gl.DeleteBuffers(1, &instanceBuffer);
+            instanceBuffer = 0;
+            mapped = nullptr;
+        }
+    }
+};
+
+#else
+
+class MosquitoInstancer {
+public:
+    struct Hover {
+        float base, amplitude, angle;
+    };
+
+    bool ready() const { return false; }
+    bool init(const std::vector<MeshVertex>&, const std::vector<MeshVertex>&) { return false; }
+    bool reserve(size_t) { return false; }
+    void draw(const float*, const float*, const float*, const uint32_t*, const unsigned char*, size_t,
+              const Hover&) {}
+};
+
+#endif // MOSQUITO_INSTANCING
+
+#endif // MOSQUITO_INSTANCER_H
@@ -0,0 +1,259 @@
+// ---------------------------------------------------------------------------
+// MosquitoMesh.h - the 3D mosquito as a plain triangle list
+//
+// The same parts drawMosquito used to emit through GLUT and GLU (ellipsoid
+// thorax, head and abdomen, tapered proboscis, antennae and legs, two wing
+// triangles), tessellated on the CPU at unit size with the slice and stack
+// counts glutSolidSphere and gluCylinder were given. Vertices carry smooth
+// normals and the part's colour. No GL here: the front-ends compile the
+// list into a display list, and MosquitoInstancer.h uploads it for
+// instanced drawing, so both paths draw the very same triangles.
+//
+// MeshBuilder mirrors the fixed-function calls it replaces (push, pop,
+// translate, rotate, scale), so the part list reads like the old code.
+// shadowMesh() is the ground shadow 3DProject.cpp draws under each one.
+// ---------------------------------------------------------------------------
+#ifndef MOSQUITO_MESH_H
+#define MOSQUITO_MESH_H
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include "UnitCircle.h"
+
+struct MeshVertex {
+    float x, y, z;
+    float nx, ny, nz;
+    float r, g, b, a;
+};
+
+class MeshBuilder {
+public:
+    std::vector<MeshVertex> vertices;
+
+    MeshBuilder() { stack.push_back(Affine()); }
+
+    void push() { stack.push_back(stack.back()); }
+    void pop() { stack.pop_back(); }
+
+    void translate(float x, float y, float z) {
+        Affine t;
+        t.m[3] = x;
+        t.m[7] = y;
+        t.m[11] = z;
+        apply(t);
+    }
+
+    // Degrees about (x, y, z), as glRotatef
+    void rotate(float degrees, float x, float y, float z) {
+        float len = sqrtf(x * x + y * y + z * z);
+        x /= len;
+        y /= len;
+        z /= len;
+        float a = degrees * 3.14159265f / 180.0f;
+        float c = cosf(a), s = sinf(a), k = 1.0f - c;
+        Affine r;
+        r.m[0] = x * x * k + c;     r.m[1] = x * y * k - z * s; r.m[2] = x * z * k + y * s;
+        r.m[4] = y * x * k + z * s; r.m[5] = y * y * k + c;     r.m[6] = y * z * k - x * s;
+        r.m[8] = z * x * k - y * s; r.m[9] = z * y * k + x * s; r.m[10] = z * z * k + c;
+        apply(r);
+    }
+
+    void scale(float x, float y, float z) {
+        Affine t;
+        t.m[0] = x;
+        t.m[5] = y;
+        t.m[10] = z;
+        apply(t);
+    }
+
+    void colour(float r, float g, float b, float a = 1.0f) {
+        rgba[0] = r;
+        rgba[1] = g;
+        rgba[2] = b;
+        rgba[3] = a;
+    }
+
+    // As glutSolidSphere: stacks from +z to -z, slices around z
+    void sphere(float radius, int slices, int stacks) {
+        for (int i = 0; i < stacks; ++i) {
+            float t0 = 3.14159265f * i / stacks, t1 = 3.14159265f * (i + 1) / stacks;
+            for (int j = 0; j < slices; ++j) {
+                float p0 = 2.0f * 3.14159265f * j / slices, p1 = 2.0f * 3.14159265f * (j + 1) / slices;
+                float n[4][3] = {{sinf(t0) * cosf(p0), sinf(t0) * sinf(p0), cosf(t0)},
+                                 {sinf(t1) * cosf(p0), sinf(t1) * sinf(p0), cosf(t1)},
+                                 {sinf(t1) * cosf(p1), sinf(t1) * sinf(p1), cosf(t1)},
+                                 {sinf(t0) * cosf(p1), sinf(t0) * sinf(p1), cosf(t0)}};
+                float p[4][3];
+                for (int k = 0; k < 4; ++k)
+                    for (int c = 0; c < 3; ++c) p[k][c] = n[k][c] * radius;
+                if (i > 0) quadHalf(p, n, 0, 1, 3); // The pole rows are fans
+                if (i < stacks - 1) quadHalf(p, n, 1, 2, 3);
+            }
+        }
+    }
+
+    // As gluCylinder with one stack: along +z from base radius to top radius
+    void cylinder(float base, float top, float height, int slices) {
+        float slope = (base - top) / height;
+        for (int j = 0; j < slices; ++j) {
+            float a0 = 2.0f * 3.14159265f * j / slices, a1 = 2.0f * 3.14159265f * (j + 1) / slices;
+            float n[4][3] = {{cosf(a0), sinf(a0), slope}, {cosf(a0), sinf(a0), slope},
+                             {cosf(a1), sinf(a1), slope}, {cosf(a1), sinf(a1), slope}};
+            float p[4][3] = {{base * cosf(a0), base * sinf(a0), 0.0f}, {top * cosf(a0), top * sinf(a0), height},
+                             {top * cosf(a1), top * sinf(a1), height}, {base * cosf(a1), base * sinf(a1), 0.0f}};
+            quadHalf(p, n, 0, 2, 1);
+            quadHalf(p, n, 0, 3, 2);
+        }
+    }
+
+    // One flat triangle, counter-clockwise
+    void triangle(const float* p0, const float* p1, const float* p2) {
+        float u[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+        float v[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+        float n[3] = {u[1] * v[2] - u[2] * v[1], u[2] * v[0] - u[0] * v[2], u[0] * v[1] - u[1] * v[0]};
+        emit(p0, n);
+        emit(p1, n);
+        emit(p2, n);
+    }
+
+private:
+    struct Affine {
+        float m[12] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0}; // Row-major 3x4
+    };
+    std::vector<Affine> stack;
+    float rgba[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+
+    void apply(const Affine& t) {
+        Affine& c = stack.back();
+        Affine out;
+        for (int r = 0; r < 3; ++r) {
+            for (int col = 0; col < 4; ++col) {
+                float v = col == 3 ? c.m[r * 4 + 3] : 0.0f;
+                for (int k = 0; k < 3; ++k) v += c.m[r * 4 + k] * t.m[k * 4 + col];
+                out.m[r * 4 + col] = v;
+            }
+        }
+        c = out;
+    }
+
+    void quadHalf(const float p[4][3], const float n[4][3], int a, int b, int c) {
+        emit(p[a], n[a]);
+        emit(p[b], n[b]);
+        emit(p[c], n[c]);
+    }
+
+    // Transform to mesh space; normals by the cofactor matrix (the inverse
+    // transpose up to scale), then renormalized
+    void emit(const float* p, const float* n) {
+        const float* m = stack.back().m;
+        MeshVertex v;
+        v.x = m[0] * p[0] + m[1] * p[1] + m[2] * p[2] + m[3];
+        v.y = m[4] * p[0] + m[5] * p[1] + m[6] * p[2] + m[7];
+        v.z = m[8] * p[0] + m[9] * p[1] + m[10] * p[2] + m[11];
+        float c[9] = {m[5] * m[10] - m[6] * m[9], m[6] * m[8] - m[4] * m[10], m[4] * m[9] - m[5] * m[8],
+                      m[2] * m[9] - m[1] * m[10], m[0] * m[10] - m[2] * m[8], m[1] * m[8] - m[0] * m[9],
+                      m[1] * m[6] - m[2] * m[5], m[2] * m[4] - m[0] * m[6], m[0] * m[5] - m[1] * m[4]};
+        float nx = c[0] * n[0] + c[1] * n[1] + c[2] * n[2];
+        float ny = c[3] * n[0] + c[4] * n[1] + c[5] * n[2];
+        float nz = c[6] * n[0] + c[7] * n[1] + c[8] * n[2];
+        float len = sqrtf(nx * nx + ny * ny + nz * nz);
+        if (len > 0.0f) {
+            nx /= len;
+            ny /= len;
+            nz /= len;
+        }
+        v.nx = nx;
+        v.ny = ny;
+        v.nz = nz;
+        memcpy(&v.r, rgba, sizeof(rgba));
+        vertices.push_back(v);
+    }
+};
+
+// A unit-size mosquito facing +x, body colour (r, g, b)
+inline std::vector<MeshVertex> mosquitoMesh(float r, float g, float b, bool bloodFed) {
+    MeshBuilder m;
+
+    // Thorax
+    m.push();
+    m.colour(r * 0.8f, g * 0.8f, b * 0.8f);
+    m.scale(0.15f, 0.1f, 0.1f);
+    m.sphere(1.0f, 12, 12);
+    m.pop();
+
+    // Head
+    m.push();
+    m.translate(0.15f, 0.0f, 0.0f);
+    m.colour(r * 0.5f, g * 0.5f, b * 0.5f);
+    m.sphere(0.08f, 10, 10);
+    m.pop();
+
+    // Proboscis
+    m.push();
+    m.translate(0.23f, 0.0f, 0.0f);
+    m.rotate(90.0f, 0.0f, 1.0f, 0.0f);
+    m.colour(r * 0.3f, g * 0.3f, b * 0.3f);
+    m.cylinder(0.01f, 0.005f, 0.1f, 8);
+    m.pop();
+
+    // Antennae
+    for (int i = -1; i <= 1; i += 2) {
+        m.push();
+        m.translate(0.15f, 0.05f * i, 0.05f);
+        m.rotate(45.0f, 0.0f, 0.0f, 1.0f);
+        m.colour(r * 0.4f, g * 0.4f, b * 0.4f);
+        m.cylinder(0.005f, 0.002f, 0.12f, 6);
+        m.pop();
+    }
+
+    // Abdomen, red once blood-fed
+    m.push();
+    m.translate(-0.15f, 0.0f, 0.0f);
+    if (bloodFed) m.colour(1.0f, 0.0f, 0.0f);
+    else m.colour(r, g, b);
+    m.scale(0.2f, 0.08f, 0.08f);
+    m.sphere(1.0f, 12, 12);
+    m.pop();
+
+    // Wings
+    for (int i = -1; i <= 1; i += 2) {
+        m.push();
+        m.translate(0.0f, 0.05f * i, 0.05f);
+        m.rotate(30.0f * i, 1.0f, 0.0f, 0.0f);
+        m.colour(1.0f, 1.0f, 1.0f, 0.6f);
+        const float p0[3] = {0.0f, 0.0f, 0.0f}, p1[3] = {0.3f, 0.1f, 0.0f}, p2[3] = {0.0f, 0.2f, 0.0f};
+        m.triangle(p0, p1, p2);
+        m.pop();
+    }
+
+    // Legs
+    const float legAngles[3] = {-45.0f, 0.0f, 45.0f};
+    for (int leg = 0; leg < 3; ++leg) {
+        for (int side = -1; side <= 1; side += 2) {
+            m.push();
+            m.translate(0.05f - leg * 0.1f, 0.05f * side, 0.0f);
+            m.rotate(legAngles[leg], 0.0f, 0.0f, 1.0f);
+            m.colour(r * 0.6f, g * 0.6f, b * 0.6f);
+            m.cylinder(0.01f, 0.005f, 0.3f, 6);
+            m.pop();
+        }
+    }
+    return m.vertices;
+}
+
+// The flat ground shadow under a unit-size mosquito
+inline std::vector<MeshVertex> shadowMesh(int segments = 48) {
+    MeshBuilder m;
+    m.colour(0.0f, 0.0f, 0.0f, 0.3f);
+    m.scale(0.2f, 0.1f, 1.0f);
+    const float centre[3] = {0.0f, 0.0f, 0.0f};
+    const float* t = unitCircle(segments);
+    for (int i = 0; i < segments; ++i) {
+        const float p0[3] = {t[2 * i], t[2 * i + 1], 0.0f}, p1[3] = {t[2 * i + 2], t[2 * i + 3], 0.0f};
+        m.triangle(centre, p0, p1);
+    }
+    return m.vertices;
+}
+
+#endif // MOSQUITO_MESH_H
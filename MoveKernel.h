@@ -0,0 +1,301 @@
+// ---------------------------------------------------------------------------
+// MoveKernel.h - mosquito movement pass over SoA columns, scalar and SIMD
+//
+// One tick of movement for mosquitoes [begin, end): pond/bowl attraction,
+// optional speed limit, integration with wind, reflection at the arena
+// bounds and random jitter. The random draws are taken from two words per
+// agent that the caller fills beforehand:
+//
+//   rand0: bit 0 picks the bowl over the pond as target (when the bowl is
+//          visible), bits 1-31 are compared with jitterThreshold
+//   rand1: low and high 16 bits are the x and y jitter
+//
+// so every lane does the same work and branches become masked blends. When
+// the world has extra breeding sites the caller also passes each agent's
+// home (the pond or whichever site pulls harder), which then stands in for
+// the pond as the non-bowl target.
+//
+// The SSE2 (4 lanes) and AVX2 (8 lanes) versions perform the same IEEE
+// operations in the same order as the scalar one, and none of them may be
+// contracted into FMA (GCC would otherwise fuse even the intrinsics under
+// -march=native), so all three agree bit for bit. moveAgents() picks the
+// widest kernel the CPU supports at runtime.
+// ---------------------------------------------------------------------------
+#ifndef MOSQUITO_MOVE_KERNEL_H
+#define MOSQUITO_MOVE_KERNEL_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define MOSQUITO_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+struct MoveParams {
+    float pondX, pondY;
+    float bowlX, bowlY;
+    bool bowlVisible;
+    float attractAccel, attractMinDist;
+    float speedLimit;        // 0 = unlimited
+    float bounds;
+    float wind;              // Added to x each tick
+    uint32_t jitterThreshold; // Jitter when (rand0 >> 1) < this, i.e. chance * 2^31; at most 2^31 - 1
+    float jitterAmount;
+};
+
+struct MoveColumns {
+    float* x;
+    float* y;
+    float* dx;
+    float* dy;
+    const unsigned char* attracted;
+    const uint32_t* rand0;
+    const uint32_t* rand1;
+    const float* homeX; // Per-agent non-bowl target, or null for the pond
+    const float* homeY;
+};
+
+enum MoveIsa { MOVE_SCALAR, MOVE_SSE2, MOVE_AVX2 };
+
+inline const char* moveIsaName(MoveIsa isa) {
+    switch (isa) {
+        case MOVE_AVX2: return "avx2";
+        case MOVE_SSE2: return "sse2";
+        default: return "scalar";
+    }
+}
+
+inline bool moveIsaSupported(MoveIsa isa) {
+#ifdef MOSQUITO_X86_KERNELS
+    if (isa == MOVE_AVX2) return __builtin_cpu_supports("avx2");
+    if (isa == MOVE_SSE2) return __builtin_cpu_supports("sse2");
+    return true;
+#else
+    return isa == MOVE_SCALAR;
+#endif
+}
+
+inline MoveIsa bestMoveIsa() {
+    if (moveIsaSupported(MOVE_AVX2)) return MOVE_AVX2;
+    if (moveIsaSupported(MOVE_SSE2)) return MOVE_SSE2;
+    return MOVE_SCALAR;
+}
+
+#if defined(__clang__)
+#define MOVE_NO_CONTRACT
+#elif defined(__GNUC__)
+#define MOVE_NO_CONTRACT __attribute__((optimize("fp-contract=off")))
+#else
+#define MOVE_NO_CONTRACT
+#endif
+
+// Jitter in [-1, 1] from 16 random bits
+static const float moveJitterScale = 2.0f / 65535.0f;
+
+MOVE_NO_CONTRACT
+inline void moveScalar(const MoveParams& p, const MoveColumns& c, size_t begin, size_t end) {
+#if defined(__clang__)
+#pragma clang fp contract(off)
+#endif
+    for (size_t i = begin; i < end; ++i) {
+        uint32_t r0 = c.rand0[i], r1 = c.rand1[i];
+        float vx = c.dx[i], vy = c.dy[i];
+        if (c.attracted[i]) {
+            bool useBowl = p.bowlVisible && (r0 & 1u);
+            float homeX = c.homeX ? c.homeX[i] : p.pondX;
+            float homeY = c.homeY ? c.homeY[i] : p.pondY;
+            float targetX = useBowl ? p.bowlX : homeX;
+            float targetY = useBowl ? p.bowlY : homeY;
+            float dx = targetX - c.x[i];
+            float dy = targetY - c.y[i];
+            float dist = sqrtf(dx * dx + dy * dy);
+            if (dist > p.attractMinDist) {
+                vx += (dx / dist) * p.attractAccel;
+                vy += (dy / dist) * p.attractAccel;
+                if (p.speedLimit > 0.0f) {
+                    float speed = sqrtf(vx * vx + vy * vy);
+                    if (speed > p.speedLimit) {
+                        vx = (vx / speed) * p.speedLimit;
+                        vy = (vy / speed) * p.speedLimit;
+                    }
+                }
+            }
+        }
+        float x = c.x[i] + (vx + p.wind);
+        float y = c.y[i] + vy;
+        if (x < -p.bounds || x > p.bounds) vx = -vx;
+        if (y < -p.bounds || y > p.bounds) vy = -vy;
+        if ((r0 >> 1) < p.jitterThreshold) {
+            vx += ((float)(r1 & 0xFFFFu) * moveJitterScale - 1.0f) * p.jitterAmount;
+            vy += ((float)(r1 >> 16) * moveJitterScale - 1.0f) * p.jitterAmount;
+        }
+        c.x[i] = x;
+        c.y[i] = y;
+        c.dx[i] = vx;
+        c.dy[i] = vy;
+    }
+}
+
+#ifdef MOSQUITO_X86_KERNELS
+// ---------------- SSE2, 4 lanes ----------------
+__attribute__((target("sse2")))
+inline __m128 moveSelect4(__m128 mask, __m128 a, __m128 b) { // mask ? a : b
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+__attribute__((target("sse2"))) MOVE_NO_CONTRACT
+inline void moveSSE2(const MoveParams& p, const MoveColumns& c, size_t begin, size_t end) {
+#if defined(__clang__)
+#pragma clang fp contract(off)
+#endif
+    const __m128 pondX = _mm_set1_ps(p.pondX), pondY = _mm_set1_ps(p.pondY);
+    const __m128 bowlX = _mm_set1_ps(p.bowlX), bowlY = _mm_set1_ps(p.bowlY);
+    const __m128i bowlBit = _mm_set1_epi32(p.bowlVisible ? 1 : 0);
+    const __m128 accel = _mm_set1_ps(p.attractAccel), minDist = _mm_set1_ps(p.attractMinDist);
+    const __m128 limit = _mm_set1_ps(p.speedLimit);
+    const __m128 hi = _mm_set1_ps(p.bounds), lo = _mm_set1_ps(-p.bounds);
+    const __m128 wind = _mm_set1_ps(p.wind);
+    const __m128 signBit = _mm_set1_ps(-0.0f);
+    // Signed compare of (rand0 >> 1) is safe: both sides fit in 31 bits
+    const __m128i threshold = _mm_set1_epi32((int)p.jitterThreshold);
+    const __m128i low16 = _mm_set1_epi32(0xFFFF);
+    const __m128 jitterScale = _mm_set1_ps(moveJitterScale), one = _mm_set1_ps(1.0f);
+    const __m128 jitterAmount = _mm_set1_ps(p.jitterAmount);
+    const __m128i zero = _mm_setzero_si128();
+    const bool limited = p.speedLimit > 0.0f;
+    size_t i = begin;
+    for (; i + 4 <= end; i += 4) {
+        __m128 x = _mm_loadu_ps(c.x + i), y = _mm_loadu_ps(c.y + i);
+        __m128 vx = _mm_loadu_ps(c.dx + i), vy = _mm_loadu_ps(c.dy + i);
+        __m128i r0 = _mm_loadu_si128((const __m128i*)(c.rand0 + i));
+        __m128i r1 = _mm_loadu_si128((const __m128i*)(c.rand1 + i));
+        int32_t flags;
+        memcpy(&flags, c.attracted + i, sizeof(flags));
+        __m128i att = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(flags), zero), zero);
+        __m128 attracted = _mm_castsi128_ps(_mm_cmpgt_epi32(att, zero));
+
+        __m128 homeX = c.homeX ? _mm_loadu_ps(c.homeX + i) : pondX;
+        __m128 homeY = c.homeY ? _mm_loadu_ps(c.homeY + i) : pondY;
+        __m128 useBowl = _mm_castsi128_ps(_mm_cmpgt_epi32(_mm_and_si128(r0, bowlBit), zero));
+        __m128 dx = _mm_sub_ps(moveSelect4(useBowl, bowlX, homeX), x);
+        __m128 dy = _mm_sub_ps(moveSelect4(useBowl, bowlY, homeY), y);
+        __m128 dist = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)));
+        __m128 pull = _mm_and_ps(attracted, _mm_cmpgt_ps(dist, minDist));
+        __m128 ax = _mm_add_ps(vx, _mm_mul_ps(_mm_div_ps(dx, dist), accel));
+        __m128 ay = _mm_add_ps(vy, _mm_mul_ps(_mm_div_ps(dy, dist), accel));
+        if (limited) {
+            __m128 speed = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(ax, ax), _mm_mul_ps(ay, ay)));
+            __m128 over = _mm_cmpgt_ps(speed, limit);
+            ax = moveSelect4(over, _mm_mul_ps(_mm_div_ps(ax, speed), limit), ax);
+            ay = moveSelect4(over, _mm_mul_ps(_mm_div_ps(ay, speed), limit), ay);
+        }
+        vx = moveSelect4(pull, ax, vx);
+        vy = moveSelect4(pull, ay, vy);
+
+        x = _mm_add_ps(x, _mm_add_ps(vx, wind));
+        y = _mm_add_ps(y, vy);
+        __m128 outX = _mm_or_ps(_mm_cmplt_ps(x, lo), _mm_cmpgt_ps(x, hi));
+        __m128 outY = _mm_or_ps(_mm_cmplt_ps(y, lo), _mm_cmpgt_ps(y, hi));
+        vx = _mm_xor_ps(vx, _mm_and_ps(outX, signBit));
+        vy = _mm_xor_ps(vy, _mm_and_ps(outY, signBit));
+
+        __m128 jitter = _mm_castsi128_ps(_mm_cmplt_epi32(_mm_srli_epi32(r0, 1), threshold));
+        __m128 jx = _mm_cvtepi32_ps(_mm_and_si128(r1, low16));
+        __m128 jy = _mm_cvtepi32_ps(_mm_srli_epi32(r1, 16));
+        jx = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(jx, jitterScale), one), jitterAmount);
+        jy = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(jy, jitterScale), one), jitterAmount);
+        vx = moveSelect4(jitter, _mm_add_ps(vx, jx), vx);
+        vy = moveSelect4(jitter, _mm_add_ps(vy, jy), vy);
+
+        _mm_storeu_ps(c.x + i, x);
+        _mm_storeu_ps(c.y + i, y);
+        _mm_storeu_ps(c.dx + i, vx);
+        _mm_storeu_ps(c.dy + i, vy);
+    }
+    moveScalar(p, c, i, end);
+}
+
+// ---------------- AVX2, 8 lanes ----------------
+__attribute__((target("avx2"))) MOVE_NO_CONTRACT
+inline void moveAVX2(const MoveParams& p, const MoveColumns& c, size_t begin, size_t end) {
+#if defined(__clang__)
+#pragma clang fp contract(off)
+#endif
+    const __m256 pondX = _mm256_set1_ps(p.pondX), pondY = _mm256_set1_ps(p.pondY);
+    const __m256 bowlX = _mm256_set1_ps(p.bowlX), bowlY = _mm256_set1_ps(p.bowlY);
+    const __m256i bowlBit = _mm256_set1_epi32(p.bowlVisible ? 1 : 0);
+    const __m256 accel = _mm256_set1_ps(p.attractAccel), minDist = _mm256_set1_ps(p.attractMinDist);
+    const __m256 limit = _mm256_set1_ps(p.speedLimit);
+    const __m256 hi = _mm256_set1_ps(p.bounds), lo = _mm256_set1_ps(-p.bounds);
+    const __m256 wind = _mm256_set1_ps(p.wind);
+    const __m256 signBit = _mm256_set1_ps(-0.0f);
+    const __m256i threshold = _mm256_set1_epi32((int)p.jitterThreshold);
+    const __m256i low16 = _mm256_set1_epi32(0xFFFF);
+    const __m256 jitterScale = _mm256_set1_ps(moveJitterScale), one = _mm256_set1_ps(1.0f);
+    const __m256 jitterAmount = _mm256_set1_ps(p.jitterAmount);
+    const __m256i zero = _mm256_setzero_si256();
+    const bool limited = p.speedLimit > 0.0f;
+    size_t i = begin;
+    for (; i + 8 <= end; i += 8) {
+        __m256 x = _mm256_loadu_ps(c.x + i), y = _mm256_loadu_ps(c.y + i);
+        __m256 vx = _mm256_loadu_ps(c.dx + i), vy = _mm256_loadu_ps(c.dy + i);
+        __m256i r0 = _mm256_loadu_si256((const __m256i*)(c.rand0 + i));
+        __m256i r1 = _mm256_loadu_si256((const __m256i*)(c.rand1 + i));
+        __m256i att = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(c.attracted + i)));
+        __m256 attracted = _mm256_castsi256_ps(_mm256_cmpgt_epi32(att, zero));
+
+        __m256 homeX = c.homeX ? _mm256_loadu_ps(c.homeX + i) : pondX;
+        __m256 homeY = c.homeY ? _mm256_loadu_ps(c.homeY + i) : pondY;
+        __m256 useBowl = _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_and_si256(r0, bowlBit), zero));
+        __m256 dx = _mm256_sub_ps(_mm256_blendv_ps(homeX, bowlX, useBowl), x);
+        __m256 dy = _mm256_sub_ps(_mm256_blendv_ps(homeY, bowlY, useBowl), y);
+        __m256 dist = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)));
+        __m256 pull = _mm256_and_ps(attracted, _mm256_cmp_ps(dist, minDist, _CMP_GT_OQ));
+        __m256 ax = _mm256_add_ps(vx, _mm256_mul_ps(_mm256_div_ps(dx, dist), accel));
+        __m256 ay = _mm256_add_ps(vy, _mm256_mul_ps(_mm256_div_ps(dy, dist), accel));
+        if (limited) {
+            __m256 speed = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(ax, ax), _mm256_mul_ps(ay, ay)));
+            __m256 over = _mm256_cmp_ps(speed, limit, _CMP_GT_OQ);
+            ax = _mm256_blendv_ps(ax, _mm256_mul_ps(_mm256_div_ps(ax, speed), limit), over);
+            ay = _mm256_blendv_ps(ay, _mm256_mul_ps(_mm256_div_ps(ay, speed), limit), over);
+        }
+        vx = _mm256_blendv_ps(vx, ax, pull);
+        vy = _mm256_blendv_ps(vy, ay, pull);
+
+        x = _mm256_add_ps(x, _mm256_add_ps(vx, wind));
+        y = _mm256_add_ps(y, vy);
+        __m256 outX = _mm256_or_ps(_mm256_cmp_ps(x, lo, _CMP_LT_OQ), _mm256_cmp_ps(x, hi, _CMP_GT_OQ));
+        __m256 outY = _mm256_or_ps(_mm256_cmp_ps(y, lo, _CMP_LT_OQ), _mm256_cmp_ps(y, hi, _CMP_GT_OQ));
+        vx = _mm256_xor_ps(vx, _mm256_and_ps(outX, signBit));
+        vy = _mm256_xor_ps(vy, _mm256_and_ps(outY, signBit));
+
+        __m256 jitter = _mm256_castsi256_ps(_mm256_cmpgt_epi32(threshold, _mm256_srli_epi32(r0, 1)));
+        __m256 jx = _mm256_cvtepi32_ps(_mm256_and_si256(r1, low16));
+        __m256 jy = _mm256_cvtepi32_ps(_mm256_srli_epi32(r1, 16));
+        jx = _mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(jx, jitterScale), one), jitterAmount);
+        jy = _mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(jy, jitterScale), one), jitterAmount);
+        vx = _mm256_blendv_ps(vx, _mm256_add_ps(vx, jx), jitter);
+        vy = _mm256_blendv_ps(vy, _mm256_add_ps(vy, jy), jitter);
+
+        _mm256_storeu_ps(c.x + i, x);
+        _mm256_storeu_ps(c.y + i, y);
+        _mm256_storeu_ps(c.dx + i, vx);
+        _mm256_storeu_ps(c.dy + i, vy);
+    }
+    moveScalar(p, c, i, end);
+}
+#endif // MOSQUITO_X86_KERNELS
+
+inline void moveAgents(MoveIsa isa, const MoveParams& p, const MoveColumns& c, size_t begin, size_t end) {
+#ifdef MOSQUITO_X86_KERNELS
+    if (isa == MOVE_AVX2) { moveAVX2(p, c, begin, end); return; }
+    if (isa == MOVE_SSE2) { moveSSE2(p, c, begin, end); return; }
+#endif
+    (void)isa;
+    moveScalar(p, c, begin, end);
+}
+
+#endif // MOSQUITO_MOVE_KERNEL_H
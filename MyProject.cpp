@@ -6,130 +6,95 @@ void displayText(const char* text, float x, float y, void* font);
 #include <ctime>
 #include <cstring>
 #include <cstdio>
+#include <random>
 #include <vector>
+#include "InputLog.h"
+#include "SimClock.h"
+#include "Snapshot.h"
+#include "UnitCircle.h"
+#include "World.h"
 #ifdef _WIN32
 #include <windows.h> // For Beep sound
 #endif
 
 // ---------------- Configuration ----------------
-const int NUM_MOSQUITOES = 30;
 const int WINDOW_W = 900;
 const int WINDOW_H = 650;
-// Pond position (bottom-left)
-const float pondX = -0.7f;
-const float pondY = -0.85f;
-const float pondRadiusX = 0.25f;
-const float pondRadiusY = 0.12f;
-// Water bowl position
-float waterBowlX = -0.4f, waterBowlY = -0.9f, waterBowlRadius = 0.05f;
-bool waterBowlVisible = false;
+// Simulation state lives in the engine; see WorldConfig::classic2D()
+World world(WorldConfig::classic2D());
+// Fixed-timestep clock: the window redraws every FRAME_MILLIS and runs
+// however many world ticks of cfg.tickMillis have elapsed since
+const int FRAME_MILLIS = 16;
+SimClock simClock(world.cfg.tickMillis);
+// User input reaches the world through this queue, one tick at a time, and
+// is logged to INPUT_LOG_FILE for Headless --replay
+InputQueue inputs;
+const char* INPUT_LOG_FILE = "mosquito.input";
 bool draggingBowl = false;
-// Spray variables
-bool spraying = false;
-float sprayX = 0.0f, sprayY = 0.0f, sprayRadius = 0.02f;
-const float maxSprayRadius = 0.15f;
-const float sprayGrowth = 0.018f;
-int sprayCharges = 5; // Limited spray resource
-const int maxSprayCharges = 5;
-int sprayRefillTimer = 0;
-const int sprayRefillInterval = 600; // 30s at 50ms per frame
-
 //hello 
-// Spawn control (frames)
-int spawnCounter = 0;
-int spawnIntervalNormal = 180;
-int spawnIntervalHigh = 50;
-int currentSpawnInterval = spawnIntervalNormal;
-// Rain event
-bool rainActive = false;
-int rainTimer = 0;
-const int rainDuration = 200; // 10s at 50ms
-const int rainSpawnCount = 5; // Mosquitoes spawned during rain
-// Score
-int totalAlive = 0;
-int totalKilled = 0;
-// Larva tracking
-struct Larva {
-    float x, y;
-    int timer; // Frames spent near pond
-};
-std::vector<Larva> larvae;
 // Educational popup
 char popupText[256] = "";
 int popupTimer = 0;
-const int popupDuration = 80;
-// Histogram data (kills per minute, assuming 1200 frames = 1 minute at 50ms)
+const int popupDuration = 250; // Rendered frames, about 4 s; not ticks, so warp cannot skip it
+// Histogram data (kills per simulated minute)
 std::vector<int> killsPerMinute;
-int frameCounter = 0;
-const int framesPerMinute = 1200;
 // Menu IDs
-enum MenuOptions { MENU_RESTART, MENU_TOGGLE_BOWL, MENU_EXIT, MENU_TRIGGER_RAIN };
-// Utility random
+enum MenuOptions { MENU_RESTART, MENU_TOGGLE_BOWL, MENU_EXIT, MENU_TRIGGER_RAIN, MENU_SAVE, MENU_LOAD };
+const char* SNAPSHOT_FILE = "mosquito.snap";
+// Utility random (cosmetic only; the simulation has its own generator)
 float randFloat(float a, float b) {
     return a + static_cast<float>(rand()) / RAND_MAX * (b - a);
 }
-// ---------------- Mosquito struct ----------------
-struct Mosquito {
-    float x, y;
-    float dx, dy;
-    float size;
-    bool alive;
-    int deadTimer;
-    bool attractedToPond;
-    int pondTime; // For larva spawning
-};
-Mosquito mosquitoes[NUM_MOSQUITOES];
 // Initialize mosquitoes
 void initializeMosquitoes() {
     srand(static_cast<unsigned>(time(0)));
-    totalAlive = 0;
-    totalKilled = 0;
-    larvae.clear();
+    world.reset(static_cast<unsigned>(time(0)));
     killsPerMinute.clear();
     killsPerMinute.push_back(0);
-    sprayCharges = maxSprayCharges;
-    rainActive = false;
-    rainTimer = 0;
-    for (int i = 0; i < NUM_MOSQUITOES; ++i) {
-        mosquitoes[i].x = randFloat(-0.9f, 0.9f);
-        mosquitoes[i].y = randFloat(-0.9f, 0.9f);
-        mosquitoes[i].dx = randFloat(-0.003f, 0.003f);
-        mosquitoes[i].dy = randFloat(-0.003f, 0.003f);
-        mosquitoes[i].size = randFloat(0.035f, 0.05f);
-        mosquitoes[i].alive = (rand() % 2 == 0);
-        mosquitoes[i].deadTimer = 0;
-        mosquitoes[i].attractedToPond = (rand() % 3 == 0);
-        mosquitoes[i].pondTime = 0;
-        if (mosquitoes[i].alive) totalAlive++;
-    }
 }
 // ---------------- Drawing helpers ----------------
 void drawCircle(float cx, float cy, float rx, float ry, int segments = 48) {
+    const float* t = unitCircle(segments);
     glBegin(GL_POLYGON);
-    for (int i = 0; i < segments; ++i) {
-        float a = 2.0f * 3.1415926f * i / segments;
-        glVertex2f(cx + cosf(a) * rx, cy + sinf(a) * ry);
-    }
+    for (int i = 0; i < segments; ++i) glVertex2f(cx + t[2 * i] * rx, cy + t[2 * i + 1] * ry);
     glEnd();
 }
-void drawMosquito(float x, float y, float size) {
+// Mosquitoes and larvae are gathered into one vertex array per colour each
+// frame, then drawn with one call apiece
+std::vector<float> bodyLines, wingTriangles;
+CircleBatch headBatch, larvaBatch;
+void drawBatch(GLenum mode, const std::vector<float>& xy) {
+    if (xy.empty()) return;
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(2, GL_FLOAT, 0, xy.data());
+    glDrawArrays(mode, 0, (GLsizei)(xy.size() / 2));
+    glDisableClientState(GL_VERTEX_ARRAY);
+}
+void drawMosquitoes(const Population& m) {
+    bodyLines.clear();
+    headBatch.clear();
+    wingTriangles.clear();
+    for (size_t i = 0; i < m.count(); ++i) {
+        float x = m.x[i], y = m.y[i], size = m.size[i];
+        bodyLines.insert(bodyLines.end(), {x - size / 2.0f, y, x + size / 2.0f, y});
+        headBatch.add(x + size / 2.0f, y, size * 0.18f, size * 0.18f, 16);
+        wingTriangles.insert(wingTriangles.end(), {x - size * 0.1f, y + size * 0.15f,
+                                                   x - size * 0.45f, y + size * 0.45f,
+                                                   x + size * 0.15f, y + size * 0.2f});
+    }
     glColor3f(0.0f, 0.0f, 0.0f);
-    glBegin(GL_LINES);
-    glVertex2f(x - size / 2.0f, y);
-    glVertex2f(x + size / 2.0f, y);
-    glEnd();
+    drawBatch(GL_LINES, bodyLines);
     glColor3f(0.12f, 0.12f, 0.12f);
-    drawCircle(x + size / 2.0f, y, size * 0.18f, size * 0.18f, 16);
+    drawBatch(GL_TRIANGLES, headBatch.xy);
     glColor3f(0.6f, 0.6f, 0.6f);
-    glBegin(GL_TRIANGLES);
-    glVertex2f(x - size * 0.1f, y + size * 0.15f);
-    glVertex2f(x - size * 0.45f, y + size * 0.45f);
-    glVertex2f(x + size * 0.15f, y + size * 0.2f);
-    glEnd();
+    drawBatch(GL_TRIANGLES, wingTriangles);
 }
-void drawLarva(float x, float y) {
+void drawLarvae(const LarvaPool& larvae) {
+    larvaBatch.clear();
+    for (size_t i = larvae.front; i < larvae.used(); ++i)
+        if (larvae.alive[i]) larvaBatch.add(larvae.x[i], larvae.y[i], 0.01f, 0.01f, 16);
     glColor3f(0.2f, 0.2f, 0.2f);
-    drawCircle(x, y, 0.01f, 0.01f, 16);
+    drawBatch(GL_TRIANGLES, larvaBatch.xy);
 }
 void drawHouse(float x, float y, float w, float h) {
     glColor3f(0.55f, 0.27f, 0.07f);
@@ -171,26 +136,40 @@ void drawGrass(float x, float y) {
     glVertex2f(x + 0.04f, y);
     glEnd();
 }
+// The grass along the bottom edge is placed once, from its own fixed seed,
+// and replayed from a display list
+const int GRASS_CLUMPS = 20;
+GLuint grassList = 0;
+// Needs a current GL context; called from initGL()
+void buildGrass() {
+    std::mt19937 field(2024);
+    std::uniform_real_distribution<float> x(-1.0f, 1.0f);
+    grassList = glGenLists(1);
+    glNewList(grassList, GL_COMPILE);
+    for (int i = 0; i < GRASS_CLUMPS; ++i) drawGrass(x(field), -0.95f);
+    glEndList();
+}
 void drawPond() {
     glColor3f(0.05f, 0.35f, 0.9f);
-    drawCircle(pondX, pondY, pondRadiusX, pondRadiusY, 72);
+    const WorldConfig& c = world.cfg;
+    drawCircle(c.pondX, c.pondY, c.pondRadiusX, c.pondRadiusY, 72);
     glColor3f(0.1f, 0.4f, 0.95f);
+    const float* t = unitCircle(36);
     glBegin(GL_LINE_LOOP);
-    for (int i = 0; i < 36; ++i) {
-        float a = 2.0f * 3.1415926f * i / 36;
-        glVertex2f(pondX + cosf(a) * pondRadiusX * 0.8f, pondY + sinf(a) * pondRadiusY * 0.8f);
-    }
+    for (int i = 0; i < 36; ++i)
+        glVertex2f(c.pondX + t[2 * i] * c.pondRadiusX * 0.8f, c.pondY + t[2 * i + 1] * c.pondRadiusY * 0.8f);
     glEnd();
 }
 void drawWaterBowl() {
-    if (!waterBowlVisible) return;
+    if (!world.waterBowlVisible) return;
+    float r = world.cfg.bowlRadius;
     glColor3f(0.45f, 0.22f, 0.07f);
-    drawCircle(waterBowlX, waterBowlY, waterBowlRadius, waterBowlRadius, 32);
+    drawCircle(world.waterBowlX, world.waterBowlY, r, r, 32);
     glColor3f(0.4f, 0.75f, 0.95f);
-    drawCircle(waterBowlX, waterBowlY, waterBowlRadius * 0.8f, waterBowlRadius * 0.8f, 32);
+    drawCircle(world.waterBowlX, world.waterBowlY, r * 0.8f, r * 0.8f, 32);
 }
 void drawRain() {
-    if (!rainActive) return;
+    if (!world.rainActive) return;
     glColor4f(0.0f, 0.0f, 1.0f, 0.5f);
     for (int i = 0; i < 50; ++i) {
         float x = randFloat(-1.0f, 1.0f);
@@ -263,183 +242,15 @@ void drawHistogram() {
     glDisable(GL_BLEND);
 }
 
-void updateHistogram(int killedThisFrame) {
-    frameCounter++;
-    killsPerMinute.back() += killedThisFrame;
-    if (frameCounter >= framesPerMinute) {
-        killsPerMinute.push_back(0);
-        frameCounter = 0;
-        if (killsPerMinute.size() > 5) killsPerMinute.erase(killsPerMinute.begin());
-    }
-}
-// ---------------- Logic ----------------
-bool isNearPondArea(float x, float y) {
-    float rx = pondRadiusX * 1.8f;
-    float ry = pondRadiusY * 2.5f;
-    float nx = (x - pondX) / rx;
-    float ny = (y - pondY) / ry;
-    return (nx * nx + ny * ny) <= 1.0f;
-}
-bool isNearWaterBowl(float x, float y) {
-    if (!waterBowlVisible) return false;
-    float dx = x - waterBowlX;
-    float dy = y - waterBowlY;
-    return sqrtf(dx*dx + dy*dy) <= waterBowlRadius * 2.0f;
-}
-void spawnOneMosquito(bool pondBoost) {
-    for (int i = 0; i < NUM_MOSQUITOES; ++i) {
-        if (!mosquitoes[i].alive) {
-            bool useBowl = waterBowlVisible && (rand() % 2 == 0);
-            float angle = randFloat(0.0f, 2.0f * 3.1415926f);
-            if (pondBoost && useBowl) {
-                mosquitoes[i].x = waterBowlX + cosf(angle) * waterBowlRadius * 1.2f;
-                mosquitoes[i].y = waterBowlY + sinf(angle) * waterBowlRadius * 1.2f;
-            } else if (pondBoost) {
-                float rx = pondRadiusX * 0.9f + randFloat(0.0f, 0.04f);
-                float ry = pondRadiusY * 0.9f + randFloat(0.0f, 0.03f);
-                mosquitoes[i].x = pondX + cosf(angle) * rx;
-                mosquitoes[i].y = pondY + sinf(angle) * ry;
-            } else {
-                mosquitoes[i].x = randFloat(-0.9f, 0.9f);
-                mosquitoes[i].y = randFloat(-0.9f, 0.9f);
-            }
-            mosquitoes[i].dx = randFloat(-0.004f, 0.004f);
-            mosquitoes[i].dy = randFloat(-0.004f, 0.004f);
-            mosquitoes[i].size = randFloat(0.035f, 0.05f);
-            mosquitoes[i].alive = true;
-            mosquitoes[i].deadTimer = 0;
-            mosquitoes[i].attractedToPond = (rand() % 2 == 0);
-            mosquitoes[i].pondTime = 0;
-            totalAlive++;
-            return;
-        }
-    }
-}
-void updateMosquitoesLogic() {
-    for (int i = 0; i < NUM_MOSQUITOES; ++i) {
-        if (mosquitoes[i].alive) {
-            if (mosquitoes[i].attractedToPond) {
-                float targetX = pondX, targetY = pondY;
-                if (waterBowlVisible && rand() % 2 == 0) {
-                    targetX = waterBowlX;
-                    targetY = waterBowlY;
-                }
-                float dx = targetX - mosquitoes[i].x;
-                float dy = targetY - mosquitoes[i].y;
-                float dist = sqrtf(dx*dx + dy*dy);
-                if (dist > 0.01f) {
-                    mosquitoes[i].dx += (dx / dist) * 0.001f;
-                    mosquitoes[i].dy += (dy / dist) * 0.001f;
-                }
-            }
-            mosquitoes[i].x += mosquitoes[i].dx;
-            mosquitoes[i].y += mosquitoes[i].dy;
-            if (mosquitoes[i].x < -0.98f || mosquitoes[i].x > 0.98f) mosquitoes[i].dx = -mosquitoes[i].dx;
-            if (mosquitoes[i].y < -0.98f || mosquitoes[i].y > 0.98f) mosquitoes[i].dy = -mosquitoes[i].dy;
-            if ((rand() % 1000) < 8) {
-                mosquitoes[i].dx += randFloat(-0.002f, 0.002f);
-                mosquitoes[i].dy += randFloat(-0.002f, 0.002f);
-            }
-            // Larva spawning logic
-            if (isNearPondArea(mosquitoes[i].x, mosquitoes[i].y)) {
-                mosquitoes[i].pondTime++;
-                if (mosquitoes[i].pondTime > 200) { // ~10s
-                    Larva larva = {mosquitoes[i].x + randFloat(-0.02f, 0.02f), mosquitoes[i].y + randFloat(-0.02f, 0.02f), 0};
-                    larvae.push_back(larva);
-                    mosquitoes[i].pondTime = 0;
-                }
-            } else {
-                mosquitoes[i].pondTime = 0;
-            }
-        } else if (mosquitoes[i].deadTimer > 0) {
-            mosquitoes[i].deadTimer--;
-        }
-    }
-    // Larva update
-    for (size_t i = 0; i < larvae.size(); ++i) {
-        larvae[i].timer++;
-        if (larvae[i].timer > 400) { // ~20s, then larva matures
-            spawnOneMosquito(true);
-            larvae.erase(larvae.begin() + i);
-            --i;
-        }
-    }
-    // Rain event
-    if (rainActive) {
-        rainTimer--;
-        if (rainTimer <= 0) {
-            rainActive = false;
-            snprintf(popupText, sizeof(popupText), "Rain stopped. Watch for breeding sites!");
-            popupTimer = popupDuration;
-        }
-    } else if (rand() % 1000 < 2 && !rainActive) { // Random rain trigger
-        rainActive = true;
-        rainTimer = rainDuration;
-        for (int i = 0; i < rainSpawnCount; ++i) spawnOneMosquito(true);
-        snprintf(popupText, sizeof(popupText), "Rain event! Mosquitoes spawning!");
-        popupTimer = popupDuration;
-#ifdef _WIN32
-        Beep(500, 300);
-#endif
-    }
-    // Spawn logic
-    bool boost = waterBowlVisible || totalAlive > 5 || rainActive;
-    int nearPondCount = 0, nearBowlCount = 0;
-    for (int i = 0; i < NUM_MOSQUITOES; ++i) {
-        if (mosquitoes[i].alive) {
-            if (isNearPondArea(mosquitoes[i].x, mosquitoes[i].y)) nearPondCount++;
-            if (isNearWaterBowl(mosquitoes[i].x, mosquitoes[i].y)) nearBowlCount++;
-        }
-    }
-    if (nearPondCount > 2 || nearBowlCount > 1) boost = true;
-    currentSpawnInterval = boost ? spawnIntervalHigh : spawnIntervalNormal;
-    spawnCounter++;
-    if (spawnCounter >= currentSpawnInterval) {
-        spawnOneMosquito(boost);
-        if (rand() % 100 < 60) spawnOneMosquito(boost);
-        spawnCounter = 0;
-    }
+void updateHistogram(int killed) {
+    killsPerMinute.back() += killed;
 }
-// ---------------- Spray & collision ----------------
-void checkSprayCollisions() {
-    if (!spraying) return;
-    int killedThisSpray = 0;
-    for (int i = 0; i < NUM_MOSQUITOES; ++i) {
-        if (!mosquitoes[i].alive) continue;
-        float dx = mosquitoes[i].x - sprayX;
-        float dy = mosquitoes[i].y - sprayY;
-        float dist = sqrtf(dx*dx + dy*dy);
-        if (dist <= sprayRadius + mosquitoes[i].size * 0.5f) {
-            mosquitoes[i].alive = false;
-            mosquitoes[i].deadTimer = 150 + (rand() % 150);
-            totalAlive--;
-            totalKilled++;
-            killedThisSpray++;
-            updateHistogram(1);
-            mosquitoes[i].x += randFloat(-0.04f, 0.04f);
-            mosquitoes[i].y += randFloat(-0.04f, 0.04f);
-        }
-    }
-    // Spray larvae too
-    for (size_t i = 0; i < larvae.size(); ++i) {
-        float dx = larvae[i].x - sprayX;
-        float dy = larvae[i].y - sprayY;
-        float dist = sqrtf(dx*dx + dy*dy);
-        if (dist <= sprayRadius) {
-            larvae.erase(larvae.begin() + i);
-            --i;
-            totalKilled++;
-            killedThisSpray++;
-            updateHistogram(1);
-        }
-    }
-    if (killedThisSpray > 0) {
-#ifdef _WIN32
-        Beep(800, 100);
-#endif
-        snprintf(popupText, sizeof(popupText), "Killed %d mosquitoes/larvae!", killedThisSpray);
-        popupTimer = popupDuration;
-    }
+
+// Start a new bar each simulated minute
+void advanceHistogram() {
+    if (world.tick % (60000 / world.cfg.tickMillis) != 0) return;
+    killsPerMinute.push_back(0);
+    if (killsPerMinute.size() > 5) killsPerMinute.erase(killsPerMinute.begin());
 }
 // ---------------- Display ----------------
 void displayText(const char* text, float x, float y, void* font = GLUT_BITMAP_HELVETICA_18) {
@@ -452,21 +263,23 @@ void displayUI() {
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     glColor4f(1.0f, 1.0f, 1.0f, 0.7f);
     glBegin(GL_QUADS);
-    glVertex2f(-0.98f, 0.85f);
-    glVertex2f(-0.5f, 0.85f);
+    glVertex2f(-0.98f, 0.80f);
+    glVertex2f(-0.5f, 0.80f);
     glVertex2f(-0.5f, 0.98f);
     glVertex2f(-0.98f, 0.98f);
     glEnd();
     glDisable(GL_BLEND);
     char buf[128];
-    snprintf(buf, sizeof(buf), "Alive: %d", totalAlive);
+    snprintf(buf, sizeof(buf), "Alive: %d", world.totalAlive);
     displayText(buf, -0.95f, 0.94f);
-    snprintf(buf, sizeof(buf), "Killed: %d", totalKilled);
+    snprintf(buf, sizeof(buf), "Killed: %d", world.totalKilled);
     displayText(buf, -0.95f, 0.89f);
-    snprintf(buf, sizeof(buf), "Spawn Rate: %s", (currentSpawnInterval == spawnIntervalHigh ? "High" : "Normal"));
+    snprintf(buf, sizeof(buf), "Spawn Rate: %s", (world.currentSpawnInterval == world.cfg.spawnIntervalHigh ? "High" : "Normal"));
     displayText(buf, -0.7f, 0.94f);
-    snprintf(buf, sizeof(buf), "Spray Charges: %d/%d", sprayCharges, maxSprayCharges);
+    snprintf(buf, sizeof(buf), "Spray Charges: %d/%d", world.sprayCharges, world.cfg.maxSprayCharges);
     displayText(buf, -0.7f, 0.89f);
+    simClock.formatSpeed(buf, sizeof(buf));
+    displayText(buf, -0.95f, 0.84f);
 }
 void displayInstructions() {
     const char* lines[] = {
@@ -475,6 +288,7 @@ void displayInstructions() {
         "S: Random Spray",
         "R: Toggle Water Bowl",
         "T: Trigger Rain Event",
+        "F: Fast-Forward (x1/x10/x100/max)",
         "Drag Bowl: Right-Click & Move",
         "Right-Click: Menu",
         "ESC: Exit"
@@ -516,7 +330,7 @@ void display() {
     drawCircle(-0.8f, 0.75f, 0.08f, 0.04f, 24);
     drawCircle(-0.55f, 0.8f, 0.07f, 0.035f, 24);
     drawCircle(0.3f, 0.7f, 0.09f, 0.045f, 24);
-    for (int i = 0; i < 20; ++i) drawGrass(randFloat(-1.0f, 1.0f), -0.95f);
+    glCallList(grassList);
     drawHouse(-0.9f, -0.8f, 0.3f, 0.3f);
     drawHouse(-0.5f, -0.8f, 0.4f, 0.4f);
     drawHouse(0.6f, -0.85f, 0.25f, 0.25f);
@@ -525,15 +339,13 @@ void display() {
     drawTree(0.2f, -0.75f);
     drawPond();
     drawWaterBowl();
-    for (size_t i = 0; i < larvae.size(); ++i) drawLarva(larvae[i].x, larvae[i].y);
-    for (int i = 0; i < NUM_MOSQUITOES; ++i) {
-        if (mosquitoes[i].alive) drawMosquito(mosquitoes[i].x, mosquitoes[i].y, mosquitoes[i].size);
-    }
-    if (spraying) {
+    drawLarvae(world.larvae);
+    drawMosquitoes(world.mosquitoes);
+    if (world.spraying) {
         glEnable(GL_BLEND);
         glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
         glColor4f(0.08f, 0.5f, 1.0f, 0.45f);
-        drawCircle(sprayX, sprayY, sprayRadius, sprayRadius, 36);
+        drawCircle(world.sprayX, world.sprayY, world.sprayRadius, world.sprayRadius, 36);
         glDisable(GL_BLEND);
     }
     drawRain();
@@ -545,78 +357,111 @@ void display() {
     glutSwapBuffers();
 }
 // ---------------- Input & Timer ----------------
-void timerFunc(int value) {
-    updateMosquitoesLogic();
-    if (spraying) {
-        checkSprayCollisions();
-        sprayRadius += sprayGrowth;
-        if (sprayRadius > maxSprayRadius) {
-            spraying = false;
-            sprayRadius = 0.02f;
-        }
+void handleSimEvent(const SimEvent& e) {
+    switch (e.type) {
+        case EVENT_RAIN_STARTED:
+            snprintf(popupText, sizeof(popupText), "Rain event! Mosquitoes spawning!");
+            popupTimer = popupDuration;
 #ifdef _WIN32
-        Beep(600, 50);
+            Beep(500, 300);
 #endif
-    }
-    sprayRefillTimer++;
-    if (sprayRefillTimer >= sprayRefillInterval && sprayCharges < maxSprayCharges) {
-        sprayCharges++;
-        sprayRefillTimer = 0;
-        snprintf(popupText, sizeof(popupText), "Spray charge refilled! %d/%d", sprayCharges, maxSprayCharges);
-        popupTimer = popupDuration;
+            break;
+        case EVENT_RAIN_STOPPED:
+            snprintf(popupText, sizeof(popupText), "Rain stopped. Watch for breeding sites!");
+            popupTimer = popupDuration;
+            break;
+        case EVENT_SPRAY_KILLS:
+            for (int i = 0; i < e.count; ++i) updateHistogram(1);
 #ifdef _WIN32
-        Beep(1200, 200);
+            Beep(800, 100);
 #endif
+            snprintf(popupText, sizeof(popupText), "Killed %d mosquitoes/larvae!", e.count);
+            popupTimer = popupDuration;
+            break;
+        case EVENT_SPRAY_REFILLED:
+            snprintf(popupText, sizeof(popupText), "Spray charge refilled! %d/%d", e.count, world.cfg.maxSprayCharges);
+            popupTimer = popupDuration;
+#ifdef _WIN32
+            Beep(1200, 200);
+#endif
+            break;
+        default:
+            break;
     }
-    for (int i = 0; i < NUM_MOSQUITOES; ++i) {
-        if (!mosquitoes[i].alive && mosquitoes[i].deadTimer <= 0) {
-            if (totalAlive < 5) spawnOneMosquito(false);
-        } else if (!mosquitoes[i].alive) {
-            int dec = (waterBowlVisible || isNearPondArea(mosquitoes[i].x, mosquitoes[i].y)) ? 2 : 1;
-            mosquitoes[i].deadTimer -= dec;
-            if (mosquitoes[i].deadTimer <= 0) spawnOneMosquito(false);
-        }
-    }
-    if (popupTimer > 0) popupTimer--;
-    glutPostRedisplay();
-    glutTimerFunc(50, timerFunc, 0);
 }
-void keyboard(unsigned char key, int x, int y) {
-    if (key == 's' || key == 'S') {
-        if (sprayCharges > 0) {
-            sprayX = randFloat(-0.9f, 0.9f);
-            sprayY = randFloat(-0.9f, 0.9f);
-            sprayRadius = 0.02f;
-            spraying = true;
-            sprayCharges--;
-            snprintf(popupText, sizeof(popupText), "Random spray! Charges left: %d", sprayCharges);
+// Popups and sounds for an input once the world has applied it
+void handleInput(const InputEvent& e) {
+    switch (e.type) {
+        case INPUT_SPRAY:
+        case INPUT_SPRAY_RANDOM:
+            if (e.accepted) {
+                snprintf(popupText, sizeof(popupText), e.type == INPUT_SPRAY ? "Spray at mouse! Charges left: %d" :
+                         "Random spray! Charges left: %d", world.sprayCharges);
+            } else {
+                snprintf(popupText, sizeof(popupText), "No spray charges! Wait for refill.");
+#ifdef _WIN32
+                Beep(400, 200);
+#endif
+            }
             popupTimer = popupDuration;
-        } else {
-            snprintf(popupText, sizeof(popupText), "No spray charges! Wait for refill.");
+            break;
+        case INPUT_TOGGLE_BOWL:
+            snprintf(popupText, sizeof(popupText), world.waterBowlVisible ? "Water bowl added: Increases breeding!" : "Water bowl removed: Reduces spawning.");
             popupTimer = popupDuration;
 #ifdef _WIN32
-            Beep(400, 200);
+            Beep(1000, 200);
 #endif
-        }
-    } else if (key == 'r' || key == 'R') {
-        waterBowlVisible = !waterBowlVisible;
-        snprintf(popupText, sizeof(popupText), waterBowlVisible ? "Water bowl added: Increases breeding!" : "Water bowl removed: Reduces spawning.");
-        popupTimer = popupDuration;
+            break;
+        case INPUT_RAIN:
+            if (e.accepted) {
+                snprintf(popupText, sizeof(popupText), "Rain event triggered!");
+                popupTimer = popupDuration;
 #ifdef _WIN32
-        Beep(1000, 200);
+                Beep(500, 300);
 #endif
-    } else if (key == 't' || key == 'T') {
-        if (!rainActive) {
-            rainActive = true;
-            rainTimer = rainDuration;
-            for (int i = 0; i < rainSpawnCount; ++i) spawnOneMosquito(true);
-            snprintf(popupText, sizeof(popupText), "Manual rain event triggered!");
+            }
+            break;
+        case INPUT_RESTART:
+            killsPerMinute.clear();
+            killsPerMinute.push_back(0);
+            snprintf(popupText, sizeof(popupText), "Simulation Restarted!");
             popupTimer = popupDuration;
+            break;
+        default:
+            break;
+    }
+}
+// One simulation tick
+void stepSimulation() {
+    inputs.apply(world, handleInput);
+    world.step();
+    for (size_t i = 0; i < world.events.size(); ++i) handleSimEvent(world.events[i]);
+    advanceHistogram();
+}
+
+void timerFunc(int value) {
 #ifdef _WIN32
-            Beep(500, 300);
+    if (world.spraying && simClock.warp == 1.0) Beep(600, 50);
 #endif
-        }
-    } else if (key == 27) exit(0);
+    int steps = simClock.advance(glutGet(GLUT_ELAPSED_TIME));
+    for (int i = 0; i < steps; ++i) stepSimulation();
+    if (popupTimer > 0) popupTimer--; // Once per frame, however many ticks ran
+    glutPostRedisplay();
+    glutTimerFunc(FRAME_MILLIS, timerFunc, 0);
+}
+void keyboard(unsigned char key, int x, int y) {
+    if (key == 's' || key == 'S') {
+        inputs.push(world, INPUT_SPRAY_RANDOM, 0.9f); // Target drawn from the sim stream when applied
+    } else if (key == 'r' || key == 'R') {
+        inputs.push(world, INPUT_TOGGLE_BOWL);
+    } else if (key == 'f' || key == 'F') {
+        simClock.cycleWarp();
+    } else if (key == 't' || key == 'T') {
+        inputs.push(world, INPUT_RAIN);
+    } else if (key == 27) {
+        inputs.finish(world);
+        exit(0);
+    }
 }
 void mouse(int button, int state, int mx, int my) {
     int winW = glutGet(GLUT_WINDOW_WIDTH);
@@ -624,26 +469,12 @@ void mouse(int button, int state, int mx, int my) {
     float nx = (2.0f * mx / winW) - 1.0f;
     float ny = 1.0f - (2.0f * my / winH);
     if (button == GLUT_LEFT_BUTTON && state == GLUT_DOWN) {
-        if (sprayCharges > 0) {
-            sprayX = nx;
-            sprayY = ny;
-            sprayRadius = 0.02f;
-            spraying = true;
-            sprayCharges--;
-            snprintf(popupText, sizeof(popupText), "Spray at mouse! Charges left: %d", sprayCharges);
-            popupTimer = popupDuration;
-        } else {
-            snprintf(popupText, sizeof(popupText), "No spray charges! Wait for refill.");
-            popupTimer = popupDuration;
-#ifdef _WIN32
-            Beep(400, 200);
-#endif
-        }
+        inputs.push(world, INPUT_SPRAY, nx, ny);
     } else if (button == GLUT_RIGHT_BUTTON && state == GLUT_DOWN) {
-        if (waterBowlVisible) {
-            float dx = nx - waterBowlX;
-            float dy = ny - waterBowlY;
-            if (sqrtf(dx*dx + dy*dy) < waterBowlRadius * 1.5f) {
+        if (world.waterBowlVisible) {
+            float dx = nx - world.waterBowlX;
+            float dy = ny - world.waterBowlY;
+            if (sqrtf(dx*dx + dy*dy) < world.cfg.bowlRadius * 1.5f) {
                 draggingBowl = true;
             }
         }
@@ -655,36 +486,39 @@ void motion(int mx, int my) {
     if (draggingBowl) {
         int winW = glutGet(GLUT_WINDOW_WIDTH);
         int winH = glutGet(GLUT_WINDOW_HEIGHT);
-        waterBowlX = (2.0f * mx / winW) - 1.0f;
-        waterBowlY = 1.0f - (2.0f * my / winH);
-        glutPostRedisplay();
+        inputs.push(world, INPUT_MOVE_BOWL, (2.0f * mx / winW) - 1.0f, 1.0f - (2.0f * my / winH));
     }
 }
 void menuFunc(int option) {
     switch (option) {
         case MENU_RESTART:
-            initializeMosquitoes();
-            snprintf(popupText, sizeof(popupText), "Simulation Restarted!");
-            popupTimer = popupDuration;
+            inputs.push(world, INPUT_RESTART, 0.0f, 0.0f, (int32_t)time(0));
             break;
         case MENU_TOGGLE_BOWL:
-            waterBowlVisible = !waterBowlVisible;
-            snprintf(popupText, sizeof(popupText), waterBowlVisible ? "Water Bowl Toggled On" : "Water Bowl Toggled Off");
-            popupTimer = popupDuration;
+            inputs.push(world, INPUT_TOGGLE_BOWL);
             break;
         case MENU_TRIGGER_RAIN:
-            if (!rainActive) {
-                rainActive = true;
-                rainTimer = rainDuration;
-                for (int i = 0; i < rainSpawnCount; ++i) spawnOneMosquito(true);
-                snprintf(popupText, sizeof(popupText), "Rain event triggered!");
-                popupTimer = popupDuration;
-#ifdef _WIN32
-                Beep(500, 300);
-#endif
+            inputs.push(world, INPUT_RAIN);
+            break;
+        case MENU_SAVE:
+            snprintf(popupText, sizeof(popupText), saveSnapshot(world, SNAPSHOT_FILE, &killsPerMinute) ?
+                     "Saved to %s" : "Could not write %s", SNAPSHOT_FILE);
+            popupTimer = popupDuration;
+            break;
+        case MENU_LOAD:
+            if (loadSnapshot(world, SNAPSHOT_FILE, &killsPerMinute)) {
+                if (killsPerMinute.empty()) killsPerMinute.push_back(0);
+                simClock.stepMillis = world.cfg.tickMillis;
+                simClock.reset();
+                inputs.record(INPUT_LOG_FILE, world); // A replay starts from the loaded state
+                snprintf(popupText, sizeof(popupText), "Loaded %s", SNAPSHOT_FILE);
+            } else {
+                snprintf(popupText, sizeof(popupText), "Could not load %s", SNAPSHOT_FILE);
             }
+            popupTimer = popupDuration;
             break;
         case MENU_EXIT:
+            inputs.finish(world);
             exit(0);
             break;
     }
@@ -695,7 +529,9 @@ void initGL() {
     glMatrixMode(GL_PROJECTION);
     glLoadIdentity();
     gluOrtho2D(-1,1,-1,1);
+    buildGrass();
     initializeMosquitoes();
+    inputs.record(INPUT_LOG_FILE, world);
 }
 int main(int argc, char** argv) {
     glutInit(&argc, argv);
@@ -707,11 +543,13 @@ int main(int argc, char** argv) {
     glutKeyboardFunc(keyboard);
     glutMouseFunc(mouse);
     glutMotionFunc(motion);
-    glutTimerFunc(50, timerFunc, 0);
+    glutTimerFunc(FRAME_MILLIS, timerFunc, 0);
     glutCreateMenu(menuFunc);
     glutAddMenuEntry("Restart", MENU_RESTART);
     glutAddMenuEntry("Toggle Water Bowl", MENU_TOGGLE_BOWL);
     glutAddMenuEntry("Trigger Rain", MENU_TRIGGER_RAIN);
+    glutAddMenuEntry("Save Snapshot", MENU_SAVE);
+    glutAddMenuEntry("Load Snapshot", MENU_LOAD);
     glutAddMenuEntry("Exit", MENU_EXIT);
     glutAttachMenu(GLUT_RIGHT_BUTTON);
     glutMainLoop();
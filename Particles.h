@@ -0,0 +1,120 @@
+// ---------------------------------------------------------------------------
+// Particles.h - fixed-capacity cosmetic particles (spray mist, rain, bursts)
+//
+// Purely visual and kept apart from World: nothing here is saved, replayed
+// or counted, and the caller supplies every position and velocity (from its
+// own cosmetic random numbers). Columns are SoA like Population.h. Each step
+// moves every particle by its velocity plus wind * drift, counts its life
+// down and then swap-removes the ones that ran out; the move runs four
+// lanes at a time with SSE2 where available. emit() drops the particle when
+// all slots are taken.
+// ---------------------------------------------------------------------------
+#ifndef MOSQUITO_PARTICLES_H
+#define MOSQUITO_PARTICLES_H
+
+#include <cstddef>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+enum ParticleKind { PARTICLE_MIST, PARTICLE_RAIN, PARTICLE_BURST, PARTICLE_KINDS };
+
+class ParticleSystem {
+public:
+    std::vector<float> x, y, vx, vy;
+    std::vector<float> drift;              // Share of the wind added to x each step
+    std::vector<float> life;               // Steps left
+    std::vector<float> fade;               // 1 / starting life, for alpha = life * fade
+    std::vector<unsigned char> kind;       // ParticleKind
+
+    explicit ParticleSystem(size_t capacity)
+        : x(capacity), y(capacity), vx(capacity), vy(capacity), drift(capacity), life(capacity),
+          fade(capacity), kind(capacity) {}
+
+    size_t count() const { return n; }
+    size_t capacity() const { return x.size(); }
+    size_t count(ParticleKind k) const { return perKind[k]; }
+
+    void clear() {
+        n = 0;
+        for (size_t& c : perKind) c = 0;
+    }
+
+    // false if every slot is taken
+    bool emit(ParticleKind k, float px, float py, float pvx, float pvy, float steps, float windDrift = 0.0f) {
+        if (n == x.size() || steps <= 0.0f) return false;
+        x[n] = px;
+        y[n] = py;
+        vx[n] = pvx;
+        vy[n] = pvy;
+        drift[n] = windDrift;
+        life[n] = steps;
+        fade[n] = 1.0f / steps;
+        kind[n] = (unsigned char)k;
+        perKind[k]++;
+        n++;
+        return true;
+    }
+
+    // One step: integrate, then drop the particles whose life ran out
+    void step(float wind) {
+        if (integrate(wind)) expire();
+    }
+
+private:
+    size_t n = 0;
+    size_t perKind[PARTICLE_KINDS] = {};
+
+    // Returns whether any particle ran out
+    bool integrate(float wind) {
+        float* px = x.data();
+        float* py = y.data();
+        float* pl = life.data();
+        const float* pvx = vx.data();
+        const float* pvy = vy.data();
+        const float* pd = drift.data();
+        size_t i = 0;
+        bool expired = false;
+#if defined(__SSE2__)
+        const __m128 w = _mm_set1_ps(wind);
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 zero = _mm_setzero_ps();
+        for (; i + 4 <= n; i += 4) {
+            __m128 dx = _mm_add_ps(_mm_loadu_ps(pvx + i), _mm_mul_ps(_mm_loadu_ps(pd + i), w));
+            _mm_storeu_ps(px + i, _mm_add_ps(_mm_loadu_ps(px + i), dx));
+            _mm_storeu_ps(py + i, _mm_add_ps(_mm_loadu_ps(py + i), _mm_loadu_ps(pvy + i)));
+            __m128 l = _mm_sub_ps(_mm_loadu_ps(pl + i), one);
+            _mm_storeu_ps(pl + i, l);
+            expired |= _mm_movemask_ps(_mm_cmple_ps(l, zero)) != 0;
+        }
+#endif
+        for (; i < n; ++i) {
+            px[i] += pvx[i] + pd[i] * wind;
+            py[i] += pvy[i];
+            pl[i] -= 1.0f;
+            expired |= pl[i] <= 0.0f;
+        }
+        return expired;
+    }
+
+    // Swap-remove from the back; draw order is not significant
+    void expire() {
+        for (size_t i = n; i-- > 0;) {
+            if (life[i] > 0.0f) continue;
+            perKind[kind[i]]--;
+            n--;
+            x[i] = x[n];
+            y[i] = y[n];
+            vx[i] = vx[n];
+            vy[i] = vy[n];
+            drift[i] = drift[n];
+            life[i] = life[n];
+            fade[i] = fade[n];
+            kind[i] = kind[n];
+        }
+    }
+};
+
+#endif // MOSQUITO_PARTICLES_H
@@ -0,0 +1,128 @@
+// ---------------------------------------------------------------------------
+// Population.h - structure-of-arrays mosquito store
+//
+// One column per field instead of one record per mosquito. The movement pass
+// only streams x, y, dx, dy (plus the flag byte), so a tick over a large
+// population touches 17 bytes per agent instead of a whole record. Capacity
+// is set at runtime from WorldConfig::maxMosquitoes.
+//
+// The columns are packed: indices [0, count()) are exactly the live
+// mosquitoes, so loops never test an alive flag. spawn() appends and kill()
+// swap-removes, both O(1). Each mosquito also owns a slot from a free list;
+// slots are stable for the mosquito's lifetime and carry a generation that is
+// bumped on death, so an AgentHandle held across ticks can tell whether its
+// mosquito is still the one in that slot.
+//
+// Dead mosquitoes keep counting down to a respawn (deadTimer in the old
+// record); they live in the separate corpses list since nothing but that
+// countdown needs them. The countdown itself is scheduled on World's timing
+// wheels, so a waiting corpse is not touched until it runs out.
+// ---------------------------------------------------------------------------
+#ifndef MOSQUITO_POPULATION_H
+#define MOSQUITO_POPULATION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct AgentHandle {
+    uint32_t slot;
+    uint32_t generation;
+};
+
+struct Corpse {
+    float x, y;
+    uint32_t timer; // World's countdown entry for this corpse
+};
+
+struct Population {
+    // Hot: read and written every tick by the movement pass
+    std::vector<float> x, y;
+    std::vector<float> dx, dy;
+    std::vector<unsigned char> attractedToPond;
+    // Cold
+    std::vector<float> size;
+    std::vector<int> pondTime; // For larva spawning
+    std::vector<unsigned char> site; // Breeding sites it was last counted at (World's SITE_* bits)
+    std::vector<uint32_t> slot; // Owning slot of each packed index
+    // Dead, waiting to respawn
+    std::vector<Corpse> corpses;
+
+    size_t capacity() const { return x.size(); }
+    size_t count() const { return n; }
+    bool full() const { return n == x.size(); }
+
+    // Resize to n empty slots
+    void assign(size_t cap) {
+        x.assign(cap, 0.0f);
+        y.assign(cap, 0.0f);
+        dx.assign(cap, 0.0f);
+        dy.assign(cap, 0.0f);
+        attractedToPond.assign(cap, 0);
+        size.assign(cap, 0.0f);
+        pondTime.assign(cap, 0);
+        site.assign(cap, 0);
+        slot.assign(cap, 0);
+        corpses.clear();
+        corpses.reserve(cap);
+        generation.assign(cap, 0);
+        packedIndex.assign(cap, 0);
+        freeSlots.resize(cap);
+        for (size_t s = 0; s < cap; ++s) freeSlots[s] = (uint32_t)(cap - 1 - s); // Pop lowest first
+        n = 0;
+    }
+
+    // Append a mosquito and return its packed index. Columns are left for the
+    // caller to fill. Must not be called when full().
+    size_t spawn() {
+        uint32_t s = freeSlots.back();
+        freeSlots.pop_back();
+        size_t i = n++;
+        slot[i] = s;
+        packedIndex[s] = (uint32_t)i;
+        return i;
+    }
+
+    // Remove the mosquito at packed index i. The last one moves into i, so a
+    // loop that kills should revisit i rather than advance.
+    void kill(size_t i) {
+        uint32_t s = slot[i];
+        generation[s]++;
+        freeSlots.push_back(s);
+        size_t last = --n;
+        if (i != last) {
+            x[i] = x[last];
+            y[i] = y[last];
+            dx[i] = dx[last];
+            dy[i] = dy[last];
+            attractedToPond[i] = attractedToPond[last];
+            size[i] = size[last];
+            pondTime[i] = pondTime[last];
+            site[i] = site[last];
+            slot[i] = slot[last];
+            packedIndex[slot[i]] = (uint32_t)i;
+        }
+    }
+
+    AgentHandle handle(size_t i) const {
+        AgentHandle h = {slot[i], generation[slot[i]]};
+        return h;
+    }
+
+    bool valid(AgentHandle h) const {
+        return h.slot < generation.size() && generation[h.slot] == h.generation &&
+               packedIndex[h.slot] < n && slot[packedIndex[h.slot]] == h.slot;
+    }
+
+    // Packed index of a live handle; check valid() first
+    size_t indexOf(AgentHandle h) const { return packedIndex[h.slot]; }
+
+private:
+    friend struct SnapshotIO;
+    size_t n = 0;
+    std::vector<uint32_t> generation;
+    std::vector<uint32_t> packedIndex;
+    std::vector<uint32_t> freeSlots;
+};
+
+#endif // MOSQUITO_POPULATION_H
@@ -0,0 +1,115 @@
+// ---------------------------------------------------------------------------
+// SimClock.h - fixed-timestep clock for the GLUT front-ends
+//
+// The simulation advances in ticks of exactly stepMillis (WorldConfig::
+// tickMillis), however often the window is redrawn. Each frame the front-end
+// passes the wall time to advance() and runs World::step() as many times as
+// it returns. Wall time accumulates between frames, so a slow frame is made
+// up by running more steps on the next one, up to the catch-up budget; time
+// beyond the budget is dropped and the simulation falls behind wall time
+// instead of spiralling.
+//
+// warp scales simulated time against wall time (x10 runs ten ticks where x1
+// runs one, and the catch-up budget scales with it). A warp of 0 means as
+// fast as possible: the per-frame batch grows while frames come back within
+// maxWarpFrameMillis and shrinks when they don't. Either way the front-end
+// draws once per frame, after the whole batch.
+// ---------------------------------------------------------------------------
+#ifndef MOSQUITO_SIM_CLOCK_H
+#define MOSQUITO_SIM_CLOCK_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+class SimClock {
+public:
+    explicit SimClock(double stepMillis = 50.0, double maxCatchUpMillis = 250.0)
+        : stepMillis(stepMillis), maxCatchUpMillis(maxCatchUpMillis) {}
+
+    // Forget any backlog; the next advance() starts counting from its own time
+    void reset() {
+        started = false;
+        accumulator = 0.0;
+    }
+
+    // Steps due at wall time nowMillis
+    int advance(double nowMillis) {
+        if (!started) {
+            started = true;
+            last = rateStart = nowMillis;
+            rateTicks = ticks;
+            return 0;
+        }
+        double elapsed = nowMillis - last;
+        last = nowMillis;
+        int steps;
+        if (warp > 0.0) {
+            if (elapsed > 0.0) accumulator += elapsed * warp;
+            steps = (int)(accumulator / stepMillis);
+            accumulator -= steps * stepMillis;
+            int budget = maxSteps();
+            if (steps > budget) {
+                dropped += steps - budget;
+                steps = budget;
+            }
+        } else {
+            if (elapsed < maxWarpFrameMillis) batch = std::min(batch + batch / 4 + 1, 1 << 20);
+            else batch = std::max(batch * 3 / 4, 1);
+            steps = batch;
+            accumulator = 0.0;
+        }
+        ticks += steps;
+        measure(nowMillis);
+        return steps;
+    }
+
+    // Fraction of the next step already elapsed, for interpolating between ticks
+    double alpha() const { return accumulator / stepMillis; }
+
+    // Simulated seconds to draw the world at when it has run tick steps:
+    // World::simSeconds() plus alpha(), so animations driven by it move
+    // smoothly between ticks and pause and warp with the simulation
+    double renderSeconds(long long tick) const { return (tick + alpha()) * stepMillis / 1000.0; }
+
+    // x1 -> x10 -> x100 -> max -> x1
+    void cycleWarp() { warp = warp == 0.0 ? 1.0 : warp >= 100.0 ? 0.0 : warp * 10.0; }
+
+    // HUD line, e.g. "Speed: x10 (200 ticks/s)"
+    void formatSpeed(char* buf, size_t size) const {
+        if (warp > 0.0) snprintf(buf, size, "Speed: x%.0f (%.0f ticks/s)", warp, ticksPerSecond);
+        else snprintf(buf, size, "Speed: max (%.0f ticks/s)", ticksPerSecond);
+    }
+
+    // Most steps a single frame may run at the current warp
+    int maxSteps() const {
+        int n = (int)(maxCatchUpMillis * warp / stepMillis);
+        return n < 1 ? 1 : n;
+    }
+
+    double stepMillis;       // Simulated time per tick
+    double maxCatchUpMillis; // Largest backlog one frame will work off
+    uint64_t ticks = 0;      // Steps handed out so far
+    uint64_t dropped = 0;    // Steps skipped because a frame was over budget
+    double warp = 1.0;       // Simulated ms per wall ms; 0 = as fast as possible
+    double maxWarpFrameMillis = 50.0;
+    double ticksPerSecond = 0.0; // Measured over the last half second of wall time
+
+private:
+    bool started = false;
+    double last = 0.0;
+    double accumulator = 0.0;
+    int batch = 1;           // Steps per frame at warp 0
+    double rateStart = 0.0;
+    uint64_t rateTicks = 0;
+
+    void measure(double nowMillis) {
+        if (nowMillis - rateStart < 500.0) return;
+        ticksPerSecond = (ticks - rateTicks) * 1000.0 / (nowMillis - rateStart);
+        rateStart = nowMillis;
+        rateTicks = ticks;
+    }
+};
+
+#endif // MOSQUITO_SIM_CLOCK_H
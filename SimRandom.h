@@ -0,0 +1,123 @@
+// ---------------------------------------------------------------------------
+// SimRandom.h - counter-based random numbers for the simulation
+//
+// Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2,
+// 3", SC'11). There is no generator state to advance: at() hashes a 128-bit
+// counter under a 64-bit key straight to four random words. The simulation
+// uses (agent, tick, stream) as the counter and the seed as the key, so an
+// agent's draws do not depend on which other agents were updated first, or
+// on which thread or SIMD lane updated it. fill2() evaluates the counter for
+// a whole column of agents, eight lanes at a time with AVX2.
+// ---------------------------------------------------------------------------
+#ifndef MOSQUITO_SIM_RANDOM_H
+#define MOSQUITO_SIM_RANDOM_H
+
+#include <cstddef>
+#include <cstdint>
+
+#if !defined(MOSQUITO_X86_KERNELS) && (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define MOSQUITO_X86_KERNELS 1
+#endif
+#ifdef MOSQUITO_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+struct RandomWords {
+    uint32_t w[4];
+};
+
+class SimRandom {
+public:
+    explicit SimRandom(uint64_t seed = 1) { setSeed(seed); }
+
+    void setSeed(uint64_t seed) {
+        key0 = (uint32_t)seed;
+        key1 = (uint32_t)(seed >> 32);
+    }
+
+    uint64_t seed() const { return ((uint64_t)key1 << 32) | key0; }
+
+    RandomWords at(uint32_t agent, uint64_t tick, uint32_t stream) const {
+        uint32_t c0 = agent, c1 = (uint32_t)tick, c2 = (uint32_t)(tick >> 32), c3 = stream;
+        uint32_t k0 = key0, k1 = key1;
+        for (int round = 0; round < 10; ++round) {
+            uint64_t p0 = (uint64_t)0xD2511F53u * c0;
+            uint64_t p1 = (uint64_t)0xCD9E8D57u * c2;
+            uint32_t n0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+            uint32_t n2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+            c1 = (uint32_t)p1;
+            c3 = (uint32_t)p0;
+            c0 = n0;
+            c2 = n2;
+            k0 += 0x9E3779B9u; // Weyl key schedule
+            k1 += 0xBB67AE85u;
+        }
+        RandomWords r = {{c0, c1, c2, c3}};
+        return r;
+    }
+
+    // out0[i], out1[i] = first two words of at(agents[i], tick, stream)
+    void fill2(const uint32_t* agents, size_t n, uint64_t tick, uint32_t stream,
+               uint32_t* out0, uint32_t* out1, bool useAvx2) const {
+        size_t i = 0;
+#ifdef MOSQUITO_X86_KERNELS
+        if (useAvx2) i = fill2AVX2(agents, n, tick, stream, out0, out1);
+#else
+        (void)useAvx2;
+#endif
+        for (; i < n; ++i) {
+            RandomWords r = at(agents[i], tick, stream);
+            out0[i] = r.w[0];
+            out1[i] = r.w[1];
+        }
+    }
+
+    // [0, 1) with 24 bits, the full precision of a float
+    static float unit(uint32_t word) { return (word >> 8) * (1.0f / 16777216.0f); }
+
+private:
+    uint32_t key0, key1;
+
+#ifdef MOSQUITO_X86_KERNELS
+    // 32x32 -> 64 multiply of all eight lanes by m, split into hi and lo words
+    __attribute__((target("avx2")))
+    static void mulHiLo8(__m256i a, __m256i m, __m256i& hi, __m256i& lo) {
+        __m256i even = _mm256_mul_epu32(a, m);                        // Lanes 0, 2, 4, 6
+        __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), m);  // Lanes 1, 3, 5, 7
+        hi = _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xAA);
+        lo = _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xAA);
+    }
+
+    // Returns how many agents it handled (a multiple of eight)
+    __attribute__((target("avx2")))
+    size_t fill2AVX2(const uint32_t* agents, size_t n, uint64_t tick, uint32_t stream,
+                     uint32_t* out0, uint32_t* out1) const {
+        const __m256i m0 = _mm256_set1_epi32((int)0xD2511F53u), m1 = _mm256_set1_epi32((int)0xCD9E8D57u);
+        const __m256i tickLo = _mm256_set1_epi32((int)(uint32_t)tick);
+        const __m256i tickHi = _mm256_set1_epi32((int)(uint32_t)(tick >> 32));
+        const __m256i streamV = _mm256_set1_epi32((int)stream);
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            __m256i c0 = _mm256_loadu_si256((const __m256i*)(agents + i));
+            __m256i c1 = tickLo, c2 = tickHi, c3 = streamV;
+            uint32_t k0 = key0, k1 = key1;
+            for (int round = 0; round < 10; ++round) {
+                __m256i hi0, lo0, hi1, lo1;
+                mulHiLo8(c0, m0, hi0, lo0);
+                mulHiLo8(c2, m1, hi1, lo1);
+                c0 = _mm256_xor_si256(_mm256_xor_si256(hi1, c1), _mm256_set1_epi32((int)k0));
+                c2 = _mm256_xor_si256(_mm256_xor_si256(hi0, c3), _mm256_set1_epi32((int)k1));
+                c1 = lo1;
+                c3 = lo0;
+                k0 += 0x9E3779B9u;
+                k1 += 0xBB67AE85u;
+            }
+            _mm256_storeu_si256((__m256i*)(out0 + i), c0);
+            _mm256_storeu_si256((__m256i*)(out1 + i), c1);
+        }
+        return i;
+    }
+#endif
+};
+
+#endif // MOSQUITO_SIM_RANDOM_H
@@ -0,0 +1,444 @@
+// ---------------------------------------------------------------------------
+// Snapshot.h - save and restore a World to a binary file
+//
+// Layout, all little-endian:
+//   "MOSQSNAP"  magic
+//   u32         format version (snapshotVersion)
+//   config      u32 count, then per field: u8 name length, name, f64 value
+//   world       scalars, RNG key and world-stream position
+//   population  u64 capacity, u64 count, each column as a raw array
+//               (x, y, dx, dy, attracted, size, pondTime, slot for the
+//               live count; generation and packedIndex for every slot),
+//               free slot list, corpses
+//   sites       u64 count, then the x, y, radiusX, radiusY, nearScale,
+//               capacity and attractiveness columns (from version 3)
+//   larvae      u64 count, then the x, y, size, timer (age in ticks,
+//               counting the tick it was laid on as 1) and, from version
+//               3, site columns of the live larvae in laying order
+//               (version 1: x, y, size, timer, alive per larva)
+//   front-end   u64 count, i32 values the front-end wants kept (e.g. its
+//               kills-per-minute histogram)
+//
+// Config fields are stored by name (ConfigFields.h), so a snapshot still
+// loads after fields are added; missing ones keep the current preset's
+// value. Population columns go to and from the file with one fwrite/fread
+// each on little-endian hosts. Everything the next step() reads is stored,
+// including the free slot order and the world random stream position, so a
+// restored world continues bit-identically. Spatial grids and scratch
+// buffers are rebuilt; events are not kept (they only live for one tick).
+// ---------------------------------------------------------------------------
+#ifndef MOSQUITO_SNAPSHOT_H
+#define MOSQUITO_SNAPSHOT_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "ConfigFields.h"
+#include "World.h"
+
+const uint32_t snapshotVersion = 3;
+
+inline bool hostIsLittleEndian() {
+    const uint16_t one = 1;
+    unsigned char first;
+    memcpy(&first, &one, 1);
+    return first == 1;
+}
+
+template <class T>
+inline T byteSwapped(T v) {
+    unsigned char b[sizeof(T)];
+    memcpy(b, &v, sizeof(T));
+    for (size_t k = 0; k < sizeof(T) / 2; ++k) std::swap(b[k], b[sizeof(T) - 1 - k]);
+    memcpy(&v, b, sizeof(T));
+    return v;
+}
+
+// Writer and reader share one description of the format (SnapshotIO::world)
+class SnapshotWriter {
+public:
+    static const bool reading = false;
+    explicit SnapshotWriter(FILE* f) : f(f) {}
+    bool ok = true;
+
+    template <class T>
+    void value(T& v) {
+        static_assert(std::is_arithmetic<T>::value, "scalars only");
+        T le = hostIsLittleEndian() ? v : byteSwapped(v);
+        ok = ok && fwrite(&le, sizeof(T), 1, f) == 1;
+    }
+
+    void flag(bool& v) {
+        uint8_t b = v ? 1 : 0;
+        value(b);
+    }
+
+    // The first n elements of v
+    template <class T>
+    void column(std::vector<T>& v, size_t n) {
+        if (!hostIsLittleEndian()) {
+            for (size_t i = 0; i < n; ++i) value(v[i]);
+            return;
+        }
+        ok = ok && fwrite(v.data(), sizeof(T), n, f) == n;
+    }
+
+    void text(std::string& s) {
+        uint8_t len = (uint8_t)std::min(s.size(), (size_t)255);
+        value(len);
+        ok = ok && fwrite(s.data(), 1, len, f) == len;
+    }
+
+    bool plausible(uint64_t, uint64_t) { return ok; }
+
+private:
+    FILE* f;
+};
+
+class SnapshotReader {
+public:
+    static const bool reading = true;
+    explicit SnapshotReader(FILE* f) : f(f) {}
+    bool ok = true;
+
+    template <class T>
+    void value(T& v) {
+        static_assert(std::is_arithmetic<T>::value, "scalars only");
+        T le = T();
+        ok = ok && fread(&le, sizeof(T), 1, f) == 1;
+        v = hostIsLittleEndian() ? le : byteSwapped(le);
+    }
+
+    void flag(bool& v) {
+        uint8_t b = 0;
+        value(b);
+        v = b != 0;
+    }
+
+    // Fills the first n elements; v must already hold at least n
+    template <class T>
+    void column(std::vector<T>& v, size_t n) {
+        if (!ok || n > v.size()) {
+            ok = false;
+            return;
+        }
+        if (!hostIsLittleEndian()) {
+            for (size_t i = 0; i < n; ++i) value(v[i]);
+            return;
+        }
+        ok = fread(v.data(), sizeof(T), n, f) == n;
+    }
+
+    void text(std::string& s) {
+        uint8_t len = 0;
+        value(len);
+        s.resize(len);
+        ok = ok && fread(&s[0], 1, len, f) == len;
+    }
+
+    // Sanity bound for counts read from the file
+    bool plausible(uint64_t n, uint64_t limit) {
+        if (n > limit) ok = false;
+        return ok;
+    }
+
+private:
+    FILE* f;
+};
+
+struct SnapshotIO {
+    // Move a loaded world into target, keeping target's runtime settings
+    static void adopt(World& target, World& loaded) {
+        loaded.moveIsa = target.moveIsa;
+        loaded.pool = std::move(target.pool);
+        target = std::move(loaded);
+    }
+
+    template <class A>
+    static void config(A& a, WorldConfig& cfg) {
+        size_t count;
+        const ConfigField* fields = configFields(count);
+        uint32_t stored = (uint32_t)count;
+        a.value(stored);
+        for (uint32_t k = 0; k < stored && a.ok; ++k) {
+            std::string name = A::reading ? std::string() : fields[k].name;
+            double v = A::reading ? 0.0 : fields[k].get(cfg);
+            a.text(name);
+            a.value(v);
+            if (A::reading) {
+                const ConfigField* field = findConfigField(name.c_str());
+                if (field) field->set(cfg, v); // Unknown names come from a newer build; skip them
+            }
+        }
+    }
+
+    template <class A>
+    static void world(A& a, World& w, std::vector<int32_t>& frontEnd, uint32_t version) {
+        config(a, w.cfg);
+        // Engine scalars
+        a.value(w.tick);
+        uint64_t seed = w.rng.seed();
+        a.value(seed);
+        if (A::reading) w.rng.setSeed(seed);
+        a.value(w.worldDraws);
+        for (int k = 0; k < 4; ++k) a.value(w.worldBlock.w[k]);
+        a.value(w.waterBowlX);
+        a.value(w.waterBowlY);
+        a.flag(w.waterBowlVisible);
+        a.flag(w.spraying);
+        a.value(w.sprayX);
+        a.value(w.sprayY);
+        a.value(w.sprayRadius);
+        a.value(w.sprayTimer);
+        a.value(w.sprayCharges);
+        a.value(w.sprayRefillTimer);
+        a.value(w.spawnCounter);
+        a.value(w.currentSpawnInterval);
+        a.value(w.difficultyTimer);
+        a.flag(w.rainActive);
+        a.value(w.rainTimer);
+        a.flag(w.windActive);
+        a.value(w.windTimer);
+        a.value(w.windForce);
+        a.flag(w.fogActive);
+        a.value(w.fogTimer);
+        a.value(w.cleanupTimer);
+        a.value(w.environmentState);
+        a.value(w.totalAlive);
+        a.value(w.totalKilled);
+        a.value(w.killedThisTick);
+        a.value(w.spawnedThisTick);
+        population(a, w.mosquitoes);
+        corpses(a, w);
+        if (version >= 3) sites(a, w);
+        else if (A::reading) w.setSites(std::vector<BreedingSite>());
+        if (version >= 2) larvae(a, w, version);
+        else larvaRecords(a, w);
+        uint64_t n = frontEnd.size();
+        a.value(n);
+        if (A::reading) {
+            if (!a.plausible(n, 1u << 24)) return;
+            frontEnd.resize(n);
+        }
+        a.column(frontEnd, n);
+        if (A::reading) {
+            w.mosquitoGridValid = w.larvaGridValid = false;
+            w.nearPondCount = w.nearBowlCount = 0; // Every site byte starts cleared; the next pass recounts
+            w.events.clear();
+        }
+    }
+
+    template <class A>
+    static void population(A& a, Population& m) {
+        uint64_t cap = m.capacity(), n = m.count();
+        a.value(cap);
+        a.value(n);
+        if (A::reading) {
+            if (!a.plausible(cap, 1u << 30) || !a.plausible(n, cap)) return;
+            m.assign(cap);
+            m.n = n;
+        }
+        a.column(m.x, n);
+        a.column(m.y, n);
+        a.column(m.dx, n);
+        a.column(m.dy, n);
+        a.column(m.attractedToPond, n);
+        a.column(m.size, n);
+        a.column(m.pondTime, n);
+        a.column(m.slot, n);
+        a.column(m.generation, cap);
+        a.column(m.packedIndex, cap);
+        uint64_t freeCount = m.freeSlots.size();
+        a.value(freeCount);
+        if (A::reading) {
+            if (!a.plausible(freeCount, cap)) return;
+            m.freeSlots.resize(freeCount);
+        }
+        a.column(m.freeSlots, freeCount);
+        if (A::reading && a.ok && !slotsConsistent(m)) a.ok = false;
+    }
+
+    // Every slot either owned by exactly one live mosquito that its packed
+    // index points back to, or free exactly once. kill() and the handles
+    // index by these without checks, so a file that breaks this is rejected.
+    static bool slotsConsistent(const Population& m) {
+        const size_t cap = m.capacity();
+        if (m.count() + m.freeSlots.size() != cap) return false;
+        std::vector<unsigned char> taken(cap, 0);
+        for (size_t i = 0; i < m.count(); ++i) {
+            uint32_t s = m.slot[i];
+            if (s >= cap || taken[s] || m.packedIndex[s] != i) return false;
+            taken[s] = 1;
+        }
+        for (uint32_t s : m.freeSlots) {
+            if (s >= cap || taken[s]) return false;
+            taken[s] = 1;
+        }
+        return true;
+    }
+
+    // Position and ticks left; the timing wheels are rebuilt on load
+    template <class A>
+    static void corpses(A& a, World& w) {
+        Population& m = w.mosquitoes;
+        uint64_t n = m.corpses.size();
+        a.value(n);
+        if (A::reading) {
+            if (!a.plausible(n, m.capacity())) return;
+            w.clearCorpses();
+        }
+        for (uint64_t c = 0; c < n && a.ok; ++c) {
+            float x = A::reading ? 0.0f : m.corpses[c].x;
+            float y = A::reading ? 0.0f : m.corpses[c].y;
+            int32_t ticks = A::reading ? 0 : w.corpseTicksLeft(c);
+            a.value(x);
+            a.value(y);
+            a.value(ticks);
+            if (A::reading) w.addCorpse(x, y, ticks);
+        }
+    }
+
+    template <class A>
+    static void sites(A& a, World& w) {
+        std::vector<BreedingSite>& s = w.sites;
+        uint64_t n = s.size();
+        a.value(n);
+        if (A::reading && !a.plausible(n, 1u << 24)) return;
+        std::vector<float> x(n), y(n), rx(n), ry(n), scale(n), pull(n);
+        std::vector<int32_t> capacity(n);
+        for (size_t k = 0; k < n && !A::reading; ++k) {
+            x[k] = s[k].x;
+            y[k] = s[k].y;
+            rx[k] = s[k].radiusX;
+            ry[k] = s[k].radiusY;
+            scale[k] = s[k].nearScale;
+            capacity[k] = s[k].capacity;
+            pull[k] = s[k].attractiveness;
+        }
+        a.column(x, n);
+        a.column(y, n);
+        a.column(rx, n);
+        a.column(ry, n);
+        a.column(scale, n);
+        a.column(capacity, n);
+        a.column(pull, n);
+        if (A::reading && a.ok) {
+            std::vector<BreedingSite> list(n);
+            for (size_t k = 0; k < n; ++k) list[k] = {x[k], y[k], rx[k], ry[k], scale[k], capacity[k], pull[k]};
+            w.setSites(list);
+        }
+    }
+
+    // Live larvae as columns; the pool is refilled in order on load
+    template <class A>
+    static void larvae(A& a, World& w, uint32_t version) {
+        LarvaPool& l = w.larvae;
+        uint64_t n = l.count();
+        a.value(n);
+        if (A::reading && !a.plausible(n, 1u << 30)) return;
+        std::vector<float> x(n), y(n), size(n);
+        std::vector<int32_t> timer(n), site(n, -1);
+        if (!A::reading) {
+            size_t k = 0;
+            for (size_t i = l.front; i < l.used(); ++i) {
+                if (!l.alive[i]) continue;
+                x[k] = l.x[i];
+                y[k] = l.y[i];
+                size[k] = l.size[i];
+                timer[k] = (int32_t)(w.tick - l.laidTick[i] + 1);
+                site[k] = l.site[i];
+                k++;
+            }
+        }
+        a.column(x, n);
+        a.column(y, n);
+        a.column(size, n);
+        a.column(timer, n);
+        if (version >= 3) a.column(site, n);
+        if (A::reading && a.ok) {
+            l.assign(w.cfg.maxLarvae > 0 ? std::max((size_t)w.cfg.maxLarvae, (size_t)n) : 0);
+            for (size_t k = 0; k < n && a.plausible((uint64_t)(site[k] + 1), w.sites.size()); ++k) {
+                l.add(x[k], y[k], size[k], w.tick + 1 - timer[k], site[k]);
+                if (site[k] >= 0) w.siteLarvaCount[site[k]]++;
+            }
+        }
+    }
+
+    // Version 1 larvae, one record each (read only)
+    template <class A>
+    static void larvaRecords(A& a, World& w) {
+        uint64_t n = 0;
+        a.value(n);
+        if (!a.plausible(n, 1u << 30)) return;
+        LarvaPool& l = w.larvae;
+        l.assign(w.cfg.maxLarvae > 0 ? std::max((size_t)w.cfg.maxLarvae, (size_t)n) : 0);
+        for (uint64_t k = 0; k < n && a.ok; ++k) {
+            float x, y, size;
+            int32_t timer;
+            bool alive;
+            a.value(x);
+            a.value(y);
+            a.value(size);
+            a.value(timer);
+            a.flag(alive);
+            if (alive) l.add(x, y, size, w.tick + 1 - timer);
+        }
+    }
+};
+
+// Write a snapshot at f's position, e.g. as the start of a longer file
+inline bool writeSnapshot(FILE* f, const World& world, const std::vector<int32_t>* frontEnd = nullptr) {
+    SnapshotWriter w(f);
+    char magic[8] = {'M', 'O', 'S', 'Q', 'S', 'N', 'A', 'P'};
+    w.ok = fwrite(magic, 1, 8, f) == 8;
+    uint32_t version = snapshotVersion;
+    w.value(version);
+    std::vector<int32_t> extra = frontEnd ? *frontEnd : std::vector<int32_t>();
+    SnapshotIO::world(w, const_cast<World&>(world), extra, snapshotVersion); // The writer only reads from it
+    return w.ok;
+}
+
+// Read a snapshot at f's position into world; on failure world is untouched
+// (the snapshot is read into a separate World first)
+inline bool readSnapshot(FILE* f, World& world, std::vector<int32_t>* frontEnd = nullptr) {
+    SnapshotReader r(f);
+    char magic[8];
+    uint32_t version = 0;
+    r.ok = fread(magic, 1, 8, f) == 8 && !memcmp(magic, "MOSQSNAP", 8);
+    r.value(version);
+    if (!r.ok || version < 1 || version > snapshotVersion) return false;
+    std::vector<int32_t> extra;
+    WorldConfig empty = world.cfg;
+    empty.maxMosquitoes = 0; // Skip the random fill; the snapshot brings its own population
+    World loaded(empty);
+    SnapshotIO::world(r, loaded, extra, version);
+    if (!r.ok) return false;
+    SnapshotIO::adopt(world, loaded);
+    if (frontEnd) *frontEnd = extra;
+    return true;
+}
+
+// Write world (and optional front-end values) to path. false on I/O error.
+inline bool saveSnapshot(const World& world, const char* path, const std::vector<int32_t>* frontEnd = nullptr) {
+    FILE* f = fopen(path, "wb");
+    if (!f) return false;
+    bool ok = writeSnapshot(f, world, frontEnd);
+    return fclose(f) == 0 && ok;
+}
+
+// Replace world's state with the snapshot at path. On failure (missing file,
+// wrong magic, newer version, truncation) returns false and leaves world
+// untouched.
+inline bool loadSnapshot(World& world, const char* path, std::vector<int32_t>* frontEnd = nullptr) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+    bool ok = readSnapshot(f, world, frontEnd);
+    fclose(f);
+    return ok;
+}
+
+#endif // MOSQUITO_SNAPSHOT_H
@@ -0,0 +1,76 @@
+// ---------------------------------------------------------------------------
+// SpatialGrid.h - uniform grid over 2D points, rebuilt by counting sort
+//
+// build() bins n points into side x side square cells covering
+// [minCoord, maxCoord] on both axes; points outside are clamped into the
+// edge cells. It is two linear passes (count, then scatter) with no
+// per-cell allocation, cheap enough to redo every tick. query() visits the
+// indices in every cell overlapping a rectangle; callers still do the exact
+// distance test.
+// ---------------------------------------------------------------------------
+#ifndef MOSQUITO_SPATIAL_GRID_H
+#define MOSQUITO_SPATIAL_GRID_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class SpatialGrid {
+public:
+    // Cells per side for n points: about four points per cell
+    static int sideFor(size_t n) {
+        int side = (int)sqrtf(n / 4.0f);
+        return std::max(1, std::min(side, 512));
+    }
+
+    void build(const float* x, const float* y, size_t n, float minCoord, float maxCoord, int cellsPerSide) {
+        side = cellsPerSide;
+        origin = minCoord;
+        invCell = side / (maxCoord - minCoord);
+        const size_t cells = (size_t)side * side;
+        cellStart.assign(cells + 1, 0);
+        cellOfItem.resize(n);
+        items.resize(n);
+        for (size_t i = 0; i < n; ++i) {
+            uint32_t c = (uint32_t)(cellCoord(y[i]) * side + cellCoord(x[i]));
+            cellOfItem[i] = c;
+            cellStart[c + 1]++;
+        }
+        for (size_t c = 0; c < cells; ++c) cellStart[c + 1] += cellStart[c];
+        // Scatter, using the cell's running end as the write cursor
+        std::vector<uint32_t>& cursor = scratch;
+        cursor.assign(cellStart.begin(), cellStart.end() - 1);
+        for (size_t i = 0; i < n; ++i) items[cursor[cellOfItem[i]]++] = (uint32_t)i;
+    }
+
+    size_t size() const { return items.size(); }
+
+    // Call f(index) for every point binned into a cell overlapping the rectangle
+    template <class F>
+    void query(float x0, float y0, float x1, float y1, F f) const {
+        if (items.empty()) return;
+        int cx0 = cellCoord(x0), cx1 = cellCoord(x1);
+        int cy0 = cellCoord(y0), cy1 = cellCoord(y1);
+        for (int cy = cy0; cy <= cy1; ++cy) {
+            const uint32_t* row = cellStart.data() + (size_t)cy * side;
+            for (uint32_t k = row[cx0]; k < row[cx1 + 1]; ++k) f(items[k]); // Cells of a row are contiguous
+        }
+    }
+
+private:
+    int side = 1;
+    float origin = 0.0f, invCell = 1.0f;
+    std::vector<uint32_t> cellStart; // side*side + 1 prefix sums
+    std::vector<uint32_t> items;     // Point indices grouped by cell
+    std::vector<uint32_t> cellOfItem;
+    std::vector<uint32_t> scratch;
+
+    int cellCoord(float v) const {
+        float c = (v - origin) * invCell; // Clamped before the cast, which overflows far out
+        return (int)std::max(0.0f, std::min(c, side - 1.0f));
+    }
+};
+
+#endif // MOSQUITO_SPATIAL_GRID_H
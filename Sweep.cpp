@@ -0,0 +1,229 @@
+// Sweep.cpp - parameter sweep over WorldConfig
+//
+// Build: g++ -std=c++17 -O2 -pthread Sweep.cpp -o sweep
+// Usage: ./sweep [--preset 2d|3d|arcade] --param NAME=LO:HI[:N] | --param NAME=V1,V2,...
+//                [--param ...] [--lhs N] [--seeds K] [--seed N] [--ticks N | --minutes M]
+//                [--bowl] [--spray-every N] [--threads N] [--list]
+//
+// Each --param names a WorldConfig field (--list prints them) and either N
+// evenly spaced values from LO to HI (N defaults to 2) or an explicit list.
+// The configs are the Cartesian product of all --param values, or with
+// --lhs N a Latin hypercube of N configs over each parameter's [LO, HI].
+// Values outside a field's range (ConfigFields.h) are rejected. Every config
+// runs with seeds --seed .. --seed + K - 1 for --minutes of simulated time at
+// its own tickMillis, or for --ticks; all runs share one thread pool.
+//
+// Prints one CSV row per config: its parameter values, the mean, median and
+// 95th percentile of the final alive count over the seeds, the alive count
+// averaged over every tick, and the mean final kills and larvae.
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ConfigFields.h"
+#include "Ensemble.h"
+
+struct SweepAxis {
+    const ConfigField* field;
+    std::vector<double> values; // Grid points
+    double lo, hi;              // Range for --lhs
+};
+
+struct ConfigResult {
+    IntDistribution alive, killed, larvae; // Final values, one per seed
+    uint64_t aliveTicks = 0;               // Sum of the alive count over every tick of every seed
+    long long ticks = 0;                   // Per seed
+};
+
+static void usage(const char* prog) {
+    fprintf(stderr,
+            "Usage: %s [--preset 2d|3d|arcade] --param NAME=LO:HI[:N] | --param NAME=V1,V2,...\n"
+            "          [--param ...] [--lhs N] [--seeds K] [--seed N] [--ticks N | --minutes M]\n"
+            "          [--bowl] [--spray-every N] [--threads N] [--list]\n", prog);
+}
+
+// Every grid point and, for --lhs, the whole [lo, hi] must be a value the
+// field accepts; the ends decide that, as each field's range is an interval
+static bool inRange(const SweepAxis& axis) {
+    for (double v : {axis.lo, axis.hi}) {
+        if (!axis.field->accepts(v)) {
+            fprintf(stderr, "%s=%g is out of range [%g, %g]\n", axis.field->name, v, axis.field->lo, axis.field->hi);
+            return false;
+        }
+    }
+    return true;
+}
+
+// "breedTicks=100:400:4", "breedTicks=100:400" (the ends) or "breedTicks=100,200,400"
+static bool parseAxis(const char* arg, SweepAxis& axis) {
+    const char* eq = strchr(arg, '=');
+    if (!eq) return false;
+    std::string name(arg, eq - arg);
+    axis.field = findConfigField(name.c_str());
+    if (!axis.field) {
+        fprintf(stderr, "Unknown parameter '%s' (see --list)\n", name.c_str());
+        return false;
+    }
+    const char* spec = eq + 1;
+    if (strchr(spec, ':')) {
+        int n = 2;
+        if (sscanf(spec, "%lf:%lf:%d", &axis.lo, &axis.hi, &n) < 2 || n < 1) return false;
+        for (int k = 0; k < n; ++k) axis.values.push_back(n == 1 ? axis.lo : axis.lo + (axis.hi - axis.lo) * k / (n - 1));
+        return inRange(axis);
+    }
+    for (const char* p = spec; *p;) {
+        char* end;
+        axis.values.push_back(strtod(p, &end));
+        if (end == p) return false;
+        p = *end == ',' ? end + 1 : end;
+    }
+    if (axis.values.empty()) return false;
+    axis.lo = *std::min_element(axis.values.begin(), axis.values.end());
+    axis.hi = *std::max_element(axis.values.begin(), axis.values.end());
+    return inRange(axis);
+}
+
+int main(int argc, char** argv) {
+    Scenario s;
+    s.cfg = WorldConfig::classic2D();
+    std::vector<SweepAxis> axes;
+    long long lhs = 0;
+    unsigned seeds = 8;
+    unsigned seed = 1;
+    long long ticks = -1;
+    double minutes = 10.0;
+    int threads = (int)std::thread::hardware_concurrency();
+
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (!strcmp(a, "--preset") && hasValue) {
+            const char* p = argv[++i];
+            if (!strcmp(p, "2d")) s.cfg = WorldConfig::classic2D();
+            else if (!strcmp(p, "3d")) s.cfg = WorldConfig::classic3D();
+            else if (!strcmp(p, "arcade")) s.cfg = WorldConfig::arcade();
+            else { usage(argv[0]); return 1; }
+        } else if (!strcmp(a, "--param") && hasValue) {
+            SweepAxis axis;
+            if (!parseAxis(argv[++i], axis)) { usage(argv[0]); return 1; }
+            axes.push_back(axis);
+        } else if (!strcmp(a, "--lhs") && hasValue) {
+            lhs = atoll(argv[++i]);
+        } else if (!strcmp(a, "--seeds") && hasValue) {
+            seeds = (unsigned)strtoul(argv[++i], nullptr, 10);
+        } else if (!strcmp(a, "--seed") && hasValue) {
+            seed = (unsigned)strtoul(argv[++i], nullptr, 10);
+        } else if (!strcmp(a, "--ticks") && hasValue) {
+            ticks = atoll(argv[++i]);
+        } else if (!strcmp(a, "--minutes") && hasValue) {
+            minutes = atof(argv[++i]);
+        } else if (!strcmp(a, "--spray-every") && hasValue) {
+            s.sprayEvery = atoi(argv[++i]);
+        } else if (!strcmp(a, "--threads") && hasValue) {
+            threads = atoi(argv[++i]);
+        } else if (!strcmp(a, "--bowl")) {
+            s.bowl = true;
+        } else if (!strcmp(a, "--list")) {
+            size_t count;
+            const ConfigField* fields = configFields(count);
+            for (size_t k = 0; k < count; ++k) printf("%s = %g\n", fields[k].name, fields[k].get(s.cfg));
+            return 0;
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (axes.empty() || seeds == 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    s.sampleEvery = 1;
+    // --minutes is simulated time, so a config that sweeps tickMillis runs its own number of ticks
+    auto ticksFor = [&](const WorldConfig& c) {
+        return ticks >= 0 ? ticks : (long long)(minutes * 60000 / c.tickMillis);
+    };
+
+    // Config k's value for axis a is point[k * axes.size() + a]
+    std::vector<double> point;
+    size_t configs = 1;
+    if (lhs > 0) {
+        configs = (size_t)lhs;
+        point.resize(configs * axes.size());
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<double> unit(0.0, 1.0);
+        std::vector<size_t> strata(configs);
+        for (size_t a = 0; a < axes.size(); ++a) {
+            for (size_t k = 0; k < configs; ++k) strata[k] = k;
+            std::shuffle(strata.begin(), strata.end(), rng);
+            for (size_t k = 0; k < configs; ++k) {
+                double u = (strata[k] + unit(rng)) / configs; // One sample per stratum
+                point[k * axes.size() + a] = axes[a].lo + u * (axes[a].hi - axes[a].lo);
+            }
+        }
+    } else {
+        for (const SweepAxis& axis : axes) configs *= axis.values.size();
+        point.resize(configs * axes.size());
+        for (size_t k = 0; k < configs; ++k) {
+            size_t rest = k; // Mixed radix, last axis fastest
+            for (size_t a = axes.size(); a-- > 0;) {
+                point[k * axes.size() + a] = axes[a].values[rest % axes[a].values.size()];
+                rest /= axes[a].values.size();
+            }
+        }
+    }
+
+    std::vector<ConfigResult> results(configs);
+    std::mutex merge;
+    auto run = [&](size_t task) {
+        size_t k = task / seeds;
+        Scenario config = s;
+        for (size_t a = 0; a < axes.size(); ++a) axes[a].field->set(config.cfg, point[k * axes.size() + a]);
+        config.ticks = ticksFor(config.cfg);
+        int alive = 0, killed = 0, larvae = 0;
+        uint64_t aliveTicks = 0;
+        runReplica(config, seed + (unsigned)(task % seeds), [&](const World& world) {
+            alive = world.totalAlive;
+            killed = world.totalKilled;
+            larvae = (int)world.larvae.count();
+            aliveTicks += world.totalAlive;
+        });
+        std::lock_guard<std::mutex> lock(merge);
+        ConfigResult& r = results[k];
+        r.alive.add(alive);
+        r.killed.add(killed);
+        r.larvae.add(larvae);
+        r.aliveTicks += aliveTicks;
+        r.ticks = config.ticks;
+    };
+    ThreadPool pool(threads);
+    auto start = std::chrono::steady_clock::now();
+    pool.run(configs * seeds, run);
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    printf("config");
+    for (const SweepAxis& axis : axes) printf(",%s", axis.field->name);
+    printf(",alive_mean,alive_p50,alive_p95,alive_avg,killed_mean,larvae_mean\n");
+    long long totalTicks = 0;
+    for (size_t k = 0; k < configs; ++k) {
+        printf("%zu", k);
+        WorldConfig c = s.cfg;
+        for (size_t a = 0; a < axes.size(); ++a) {
+            axes[a].field->set(c, point[k * axes.size() + a]);
+            printf(",%g", axes[a].field->get(c)); // As the run saw it, e.g. rounded for ints
+        }
+        const ConfigResult& r = results[k];
+        printf(",%.3f,%d,%d,%.3f,%.3f,%.3f\n", r.alive.mean(), r.alive.quantile(0.5), r.alive.quantile(0.95),
+               r.ticks > 0 ? (double)r.aliveTicks / ((double)r.ticks * seeds) : 0.0, r.killed.mean(), r.larvae.mean());
+        totalTicks += r.ticks * seeds;
+    }
+    fprintf(stderr, "%zu configs x %u seeds, %lld ticks on %d threads in %.3fs (%.0f ticks/s)\n", configs, seeds,
+            totalTicks, pool.size(), secs, secs > 0 ? totalTicks / secs : 0.0);
+    return 0;
+}
@@ -0,0 +1,125 @@
+// ---------------------------------------------------------------------------
+// ThreadPool.h - fork/join pool with work stealing
+//
+// run(tasks, f) calls f(task) for every task in [0, tasks) and returns when
+// all of them are done. The calling thread works too, so a pool of size N
+// starts N - 1 threads. Each thread is handed a contiguous block of tasks
+// and takes them front to back; a thread that runs dry steals from the back
+// of another thread's block. Which thread runs a task is therefore not
+// fixed: callers that need a reproducible result give each task its own
+// output and combine the outputs in task order afterwards.
+// ---------------------------------------------------------------------------
+#ifndef MOSQUITO_THREAD_POOL_H
+#define MOSQUITO_THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool {
+public:
+    explicit ThreadPool(int threads) : queues(threads < 1 ? 1 : threads) {
+        for (size_t w = 1; w < queues.size(); ++w) workers.emplace_back([this, w] { workerLoop(w); });
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            quit = true;
+        }
+        wake.notify_all();
+        for (std::thread& t : workers) t.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int size() const { return (int)queues.size(); }
+
+    template <class F>
+    void run(size_t tasks, F& f) {
+        if (queues.size() == 1 || tasks <= 1) {
+            for (size_t t = 0; t < tasks; ++t) f(t);
+            return;
+        }
+        job = &f;
+        call = [](void* ctx, size_t task) { (*static_cast<F*>(ctx))(task); };
+        const size_t threads = queues.size();
+        for (size_t w = 0; w < threads; ++w) {
+            queues[w].head = tasks * w / threads;
+            queues[w].tail = tasks * (w + 1) / threads;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            busy.store(threads - 1, std::memory_order_relaxed);
+            generation++;
+        }
+        wake.notify_all();
+        work(0);
+        // Every worker must be back to sleep before the next run() rewrites the queues
+        while (busy.load(std::memory_order_acquire) != 0) std::this_thread::yield();
+    }
+
+private:
+    struct alignas(64) Queue {
+        std::mutex lock;
+        size_t head = 0, tail = 0; // Tasks not yet taken
+    };
+
+    std::vector<Queue> queues; // One per thread; index 0 is the caller
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    uint64_t generation = 0; // Bumped by each run(), under mutex
+    bool quit = false;
+    std::atomic<size_t> busy{0}; // Workers still inside the current run()
+    void* job = nullptr;
+    void (*call)(void*, size_t) = nullptr;
+
+    bool takeFront(size_t w, size_t& task) {
+        Queue& q = queues[w];
+        std::lock_guard<std::mutex> lock(q.lock);
+        if (q.head == q.tail) return false;
+        task = q.head++;
+        return true;
+    }
+
+    bool stealBack(size_t w, size_t& task) {
+        Queue& q = queues[w];
+        std::lock_guard<std::mutex> lock(q.lock);
+        if (q.head == q.tail) return false;
+        task = --q.tail;
+        return true;
+    }
+
+    void work(size_t w) {
+        const size_t threads = queues.size();
+        size_t task;
+        for (;;) {
+            bool found = takeFront(w, task);
+            for (size_t k = 1; !found && k < threads; ++k) found = stealBack((w + k) % threads, task);
+            if (!found) return;
+            call(job, task);
+        }
+    }
+
+    void workerLoop(size_t w) {
+        uint64_t seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return quit || generation != seen; });
+                if (quit) return;
+                seen = generation;
+            }
+            work(w);
+            busy.fetch_sub(1, std::memory_order_release);
+        }
+    }
+};
+
+#endif // MOSQUITO_THREAD_POOL_H
@@ -0,0 +1,112 @@
+// ---------------------------------------------------------------------------
+// TimingWheel.h - hierarchical timing wheel for countdowns
+//
+// Entries are scheduled at an absolute deadline on the wheel's own clock and
+// fire when advance() reaches it. Four levels of 64 slots cover deadlines
+// up to 2^24 steps ahead (anything further waits in an overflow list).
+// Level 0 holds the next 64 steps one slot per step; each higher level holds
+// 64 times coarser spans and is cascaded into the level below when the
+// clock enters its span. A step therefore costs one slot plus, every 64th
+// step, one cascade, no matter how many entries are waiting: an entry is
+// only touched when it is placed, cascaded (at most three times) or fired.
+//
+// There is no cancel; owners tag the payload (e.g. with a generation) and
+// ignore entries that went stale. Slot vectors keep their capacity, so a
+// wheel that has reached its working size no longer allocates.
+// ---------------------------------------------------------------------------
+#ifndef MOSQUITO_TIMING_WHEEL_H
+#define MOSQUITO_TIMING_WHEEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class TimingWheel {
+public:
+    TimingWheel() : slots(levels * slotsPerLevel) {}
+
+    uint64_t now() const { return time; }
+    size_t size() const { return pending; } // Scheduled and not yet fired, stale ones included
+
+    // Drop every entry and set the clock
+    void clear(uint64_t start = 0) {
+        for (std::vector<Entry>& s : slots) s.clear();
+        overflow.clear();
+        time = start;
+        pending = 0;
+    }
+
+    // Fire payload once the clock reaches deadline; deadlines not after now()
+    // fire on the next step
+    void schedule(uint64_t deadline, uint64_t payload) {
+        Entry e = {deadline > time ? deadline : time + 1, payload};
+        place(e);
+        pending++;
+    }
+
+    // Step the clock to `to`, calling fire(payload) for every entry due on the
+    // way, in deadline order
+    template <class F>
+    void advance(uint64_t to, F fire) {
+        while (time < to) {
+            time++;
+            if ((time & levelMask) == 0) cascade();
+            std::vector<Entry>& due = slots[time & levelMask];
+            if (due.empty()) continue;
+            pending -= due.size();
+            for (size_t k = 0; k < due.size(); ++k) fire(due[k].payload); // fire() may schedule more
+            due.clear();
+        }
+    }
+
+private:
+    struct Entry {
+        uint64_t deadline;
+        uint64_t payload;
+    };
+
+    static const int levelBits = 6;
+    static const int levels = 4;
+    static const uint64_t slotsPerLevel = 1u << levelBits;
+    static const uint64_t levelMask = slotsPerLevel - 1;
+
+    std::vector<std::vector<Entry>> slots; // slots[level * slotsPerLevel + k]
+    std::vector<Entry> overflow;           // More than 2^24 steps ahead
+    std::vector<Entry> moving;             // Scratch for cascades
+    uint64_t time = 0;
+    size_t pending = 0;
+
+    // The lowest level whose span around now() contains the deadline
+    void place(const Entry& e) {
+        uint64_t diff = e.deadline ^ time;
+        for (int level = 0; level < levels; ++level) {
+            if (diff >> (levelBits * (level + 1)) == 0) {
+                slots[level * slotsPerLevel + ((e.deadline >> (levelBits * level)) & levelMask)].push_back(e);
+                return;
+            }
+        }
+        overflow.push_back(e);
+    }
+
+    // The clock just entered a new level-0 span: bring down every level whose
+    // span it also entered, highest first
+    void cascade() {
+        int top = 1;
+        while (top < levels && ((time >> (levelBits * top)) & levelMask) == 0) top++;
+        if (top == levels) {
+            moving.swap(overflow);
+            for (const Entry& e : moving) place(e);
+            moving.clear();
+            top = levels - 1;
+        }
+        for (int level = top; level >= 1; --level) {
+            std::vector<Entry>& s = slots[level * slotsPerLevel + ((time >> (levelBits * level)) & levelMask)];
+            if (s.empty()) continue;
+            moving.swap(s);
+            for (const Entry& e : moving) place(e);
+            moving.clear();
+        }
+    }
+};
+
+#endif // MOSQUITO_TIMING_WHEEL_H
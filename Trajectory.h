@@ -0,0 +1,435 @@
+// ---------------------------------------------------------------------------
+// Trajectory.h - append-only recording of every mosquito's position
+//
+// Two files per recording:
+//   <path>      64-byte header, then fixed-size frames. A frame holds, per
+//               population slot, int16 x and int16 y (position / scale *
+//               32767) followed by one alive bit per slot, so slot s of
+//               frame k is always at the same offset.
+//   <path>.idx  one i64 tick per frame
+// All values are little-endian. The header is magic "MOSQTRAJ", then u32
+// version, u32 capacity, u32 frameBytes, f32 scale and, from version 2,
+// u64 frames: the count of frames fully written, updated after each one.
+// Both files are grown ahead of the data, so readers trust that count
+// rather than the file sizes.
+// Frame k starts at 64 + k * frameBytes, and the index is sorted as long as
+// the recorded World is not reset(), so a reader finds tick T with a binary
+// search over the index and one seek, without touching other frames.
+//
+// TrajectoryRecorder::capture() quantizes the population into one of a
+// fixed ring of preallocated frame buffers and returns; a background thread
+// copies full buffers into the memory-mapped files, growing them in large
+// steps. Nothing on the tick path allocates. If the writer falls behind by
+// the whole ring, capture() waits for it (counted in stalls) rather than
+// dropping frames.
+// ---------------------------------------------------------------------------
+#ifndef MOSQUITO_TRAJECTORY_H
+#define MOSQUITO_TRAJECTORY_H
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Snapshot.h"
+#include "World.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+const uint32_t trajectoryVersion = 2;
+const size_t trajectoryHeaderBytes = 64;
+const size_t trajectoryFramesOffset = 24; // Where the header keeps its frame count
+
+struct TrajectoryHeader {
+    char magic[8];         // "MOSQTRAJ"
+    uint32_t version;
+    uint32_t capacity;     // Slots per frame
+    uint32_t frameBytes;
+    float scale;           // Coordinate that maps to +32767
+    uint64_t frames;       // Frames committed; version 2 on
+};
+
+template <class T>
+inline void storeLittleEndian(char* p, T v) {
+    if (!hostIsLittleEndian()) v = byteSwapped(v);
+    memcpy(p, &v, sizeof(T));
+}
+
+template <class T>
+inline T loadLittleEndian(const char* p) {
+    T v;
+    memcpy(&v, p, sizeof(T));
+    return hostIsLittleEndian() ? v : byteSwapped(v);
+}
+
+inline void encodeTrajectoryHeader(const TrajectoryHeader& h, char* out) {
+    memset(out, 0, trajectoryHeaderBytes);
+    memcpy(out, h.magic, 8);
+    storeLittleEndian(out + 8, h.version);
+    storeLittleEndian(out + 12, h.capacity);
+    storeLittleEndian(out + 16, h.frameBytes);
+    storeLittleEndian(out + 20, h.scale);
+    storeLittleEndian(out + trajectoryFramesOffset, h.frames);
+}
+
+inline TrajectoryHeader decodeTrajectoryHeader(const char* in) {
+    TrajectoryHeader h;
+    memcpy(h.magic, in, 8);
+    h.version = loadLittleEndian<uint32_t>(in + 8);
+    h.capacity = loadLittleEndian<uint32_t>(in + 12);
+    h.frameBytes = loadLittleEndian<uint32_t>(in + 16);
+    h.scale = loadLittleEndian<float>(in + 20);
+    h.frames = h.version >= 2 ? loadLittleEndian<uint64_t>(in + trajectoryFramesOffset) : 0;
+    return h;
+}
+
+inline size_t trajectoryFrameBytes(size_t capacity) {
+    return capacity * 2 * sizeof(int16_t) + (capacity + 63) / 64 * sizeof(uint64_t);
+}
+
+// A file written through a growing shared mapping (plain writes on Windows)
+class MappedFile {
+public:
+    ~MappedFile() { close(size); }
+
+    bool open(const char* path) {
+#ifdef _WIN32
+        f = fopen(path, "wb");
+        return f != nullptr;
+#else
+        fd = ::open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+        return fd >= 0;
+#endif
+    }
+
+    bool write(size_t offset, const void* data, size_t n) {
+#ifdef _WIN32
+        if (!f || fseek(f, (long)offset, SEEK_SET) != 0) return false;
+        if (fwrite(data, 1, n, f) != n) return false;
+#else
+        if (offset + n > mapped && !grow(offset + n)) return false;
+        memcpy(base + offset, data, n);
+#endif
+        size = std::max(size, offset + n);
+        return true;
+    }
+
+    // Unmap and cut the file to what was written
+    bool close(size_t finalSize) {
+        bool ok = true;
+#ifdef _WIN32
+        if (f) ok = fclose(f) == 0;
+        f = nullptr;
+        (void)finalSize;
+#else
+        if (base) munmap(base, mapped);
+        base = nullptr;
+        mapped = 0;
+        if (fd >= 0) {
+            ok = ftruncate(fd, (off_t)finalSize) == 0;
+            ok = ::close(fd) == 0 && ok;
+        }
+        fd = -1;
+#endif
+        return ok;
+    }
+
+    size_t written() const { return size; }
+
+private:
+    size_t size = 0;
+#ifdef _WIN32
+    FILE* f = nullptr;
+#else
+    int fd = -1;
+    char* base = nullptr;
+    size_t mapped = 0;
+
+    bool grow(size_t needed) {
+        size_t next = std::max(needed, mapped + std::max(mapped, (size_t)64 << 20)); // Double, at least 64 MB
+        if (ftruncate(fd, (off_t)next) != 0) return false;
+        if (base) munmap(base, mapped);
+        void* p = mmap(nullptr, next, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED) {
+            base = nullptr;
+            mapped = 0;
+            return false;
+        }
+        base = static_cast<char*>(p);
+        mapped = next;
+        return true;
+    }
+#endif
+};
+
+class TrajectoryRecorder {
+public:
+    ~TrajectoryRecorder() { close(); }
+
+    // Start a recording for worlds of this capacity. Positions beyond +-scale
+    // are clamped; the default covers mosquitoes blown well off screen and
+    // still resolves 1/2000 of the window.
+    bool open(const char* path, size_t capacity, float scale = 16.0f, int ringFrames = 8) {
+        close();
+        if (!data.open(path) || !index.open((std::string(path) + ".idx").c_str())) return false;
+        slots = capacity;
+        this->scale = scale;
+        frameBytes = trajectoryFrameBytes(capacity);
+        TrajectoryHeader h = {{'M', 'O', 'S', 'Q', 'T', 'R', 'A', 'J'}, trajectoryVersion, (uint32_t)capacity,
+                              (uint32_t)frameBytes, scale, 0};
+        char header[trajectoryHeaderBytes];
+        encodeTrajectoryHeader(h, header);
+        if (!data.write(0, header, sizeof(header))) return false;
+        ring.assign(ringFrames, Frame());
+        for (Frame& f : ring) f.bytes.assign(frameBytes, 0);
+        head = tail = 0;
+        frames = 0;
+        stalls = 0;
+        failed = false;
+        stopping = false;
+        writer = std::thread([this] { writeLoop(); });
+        return true;
+    }
+
+    // Record the world's current state as the next frame
+    void capture(const World& world) {
+        if (!writer.joinable()) return;
+        std::unique_lock<std::mutex> lock(mutex);
+        if (head - tail == ring.size()) {
+            stalls++;
+            drained.wait(lock, [&] { return head - tail < ring.size(); });
+        }
+        Frame& f = ring[head % ring.size()];
+        lock.unlock();
+
+        const Population& m = world.mosquitoes;
+        int16_t* xs = reinterpret_cast<int16_t*>(f.bytes.data());
+        int16_t* ys = xs + slots;
+        // Little-endian u64 words, set a byte at a time: no alignment or host order to care about
+        unsigned char* alive = f.bytes.data() + slots * 2 * sizeof(int16_t);
+        memset(f.bytes.data(), 0, frameBytes);
+        const float q = 32767.0f / scale;
+        const size_t n = std::min(m.count(), slots);
+        for (size_t i = 0; i < n; ++i) {
+            uint32_t s = m.slot[i];
+            if (s >= slots) continue;
+            xs[s] = quantize(m.x[i] * q);
+            ys[s] = quantize(m.y[i] * q);
+            alive[s / 8] |= (unsigned char)(1u << (s % 8));
+        }
+        if (!hostIsLittleEndian()) {
+            for (size_t s = 0; s < 2 * slots; ++s) xs[s] = byteSwapped(xs[s]);
+        }
+        f.tick = world.tick;
+
+        lock.lock();
+        head++;
+        lock.unlock();
+        filled.notify_one();
+    }
+
+    // Flush every captured frame and close both files; false if any write failed
+    bool close() {
+        if (!writer.joinable()) return !failed;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        filled.notify_one();
+        writer.join();
+        bool ok = data.close(trajectoryHeaderBytes + frames * frameBytes);
+        ok = index.close(frames * sizeof(int64_t)) && ok;
+        return ok && !failed;
+    }
+
+    uint64_t frames = 0; // Written so far
+    uint64_t stalls = 0; // Captures that had to wait for the writer
+
+private:
+    struct Frame {
+        std::vector<unsigned char> bytes;
+        long long tick = 0;
+    };
+
+    MappedFile data, index;
+    size_t slots = 0, frameBytes = 0;
+    float scale = 16.0f;
+    std::vector<Frame> ring;
+    uint64_t head = 0, tail = 0; // Frames captured / written; ring[k % size] holds frame k
+    bool stopping = false, failed = false;
+    std::mutex mutex;
+    std::condition_variable filled, drained;
+    std::thread writer;
+
+    static int16_t quantize(float v) {
+        return (int16_t)lrintf(std::max(-32767.0f, std::min(v, 32767.0f)));
+    }
+
+    void writeLoop() {
+        for (;;) {
+            std::unique_lock<std::mutex> lock(mutex);
+            filled.wait(lock, [&] { return stopping || head != tail; });
+            if (head == tail) return; // Stopping and drained
+            Frame& f = ring[tail % ring.size()];
+            lock.unlock();
+
+            int64_t tick = hostIsLittleEndian() ? f.tick : byteSwapped((int64_t)f.tick);
+            bool ok = data.write(trajectoryHeaderBytes + frames * frameBytes, f.bytes.data(), frameBytes) &&
+                      index.write(frames * sizeof(int64_t), &tick, sizeof(tick));
+            if (ok) {
+                // Publish the frame only once it and its index entry are in place
+                char count[sizeof(uint64_t)];
+                storeLittleEndian(count, (uint64_t)(frames + 1));
+                std::atomic_thread_fence(std::memory_order_release);
+                ok = data.write(trajectoryFramesOffset, count, sizeof(count));
+            }
+            lock.lock();
+            if (ok) frames++;
+            else failed = true;
+            tail++;
+            lock.unlock();
+            drained.notify_one();
+        }
+    }
+};
+
+// Random access to a finished recording, or to the frames of one still being
+// written that were committed by the time of open()
+class TrajectoryReader {
+public:
+    ~TrajectoryReader() { close(); }
+
+    bool open(const char* path) {
+        close();
+        if (!load(path, data, dataBytes) || !load((std::string(path) + ".idx").c_str(), index, indexBytes)) {
+            close();
+            return false;
+        }
+        if (dataBytes < trajectoryHeaderBytes) return fail();
+        header = decodeTrajectoryHeader(data);
+        if (memcmp(header.magic, "MOSQTRAJ", 8) != 0 || header.version > trajectoryVersion ||
+            header.frameBytes == 0 || header.frameBytes != trajectoryFrameBytes(header.capacity)) {
+            return fail();
+        }
+        // A recording cut short may have an index entry without its frame, or the reverse
+        count = std::min(indexBytes / sizeof(int64_t), (dataBytes - trajectoryHeaderBytes) / header.frameBytes);
+        if (header.version >= 2) count = std::min(count, (size_t)header.frames); // Files run ahead of the frames
+
+        return true;
+    }
+
+    size_t frames() const { return count; }
+    size_t capacity() const { return header.capacity; }
+
+    long long tickOf(size_t frame) const {
+        int64_t t;
+        memcpy(&t, index + frame * sizeof(int64_t), sizeof(t));
+        return hostIsLittleEndian() ? t : byteSwapped(t);
+    }
+
+    // Frame recorded at tick, or -1
+    long long find(long long tick) const {
+        size_t lo = 0, hi = count;
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            if (tickOf(mid) < tick) lo = mid + 1;
+            else hi = mid;
+        }
+        return lo < count && tickOf(lo) == tick ? (long long)lo : -1;
+    }
+
+    bool alive(size_t frame, size_t slot) const {
+        uint64_t word;
+        memcpy(&word, frameBase(frame) + header.capacity * 2 * sizeof(int16_t) + slot / 64 * sizeof(uint64_t), 8);
+        if (!hostIsLittleEndian()) word = byteSwapped(word);
+        return (word >> (slot % 64)) & 1;
+    }
+
+    float x(size_t frame, size_t slot) const { return coord(frame, slot); }
+    float y(size_t frame, size_t slot) const { return coord(frame, header.capacity + slot); }
+
+private:
+    TrajectoryHeader header = {};
+    const char* data = nullptr;
+    const char* index = nullptr;
+    size_t dataBytes = 0, indexBytes = 0, count = 0;
+
+    const char* frameBase(size_t frame) const {
+        return data + trajectoryHeaderBytes + frame * (size_t)header.frameBytes;
+    }
+
+    float coord(size_t frame, size_t k) const {
+        int16_t v;
+        memcpy(&v, frameBase(frame) + k * sizeof(int16_t), sizeof(v));
+        if (!hostIsLittleEndian()) v = byteSwapped(v);
+        return v * header.scale / 32767.0f;
+    }
+
+    bool fail() {
+        close();
+        return false;
+    }
+
+    static bool load(const char* path, const char*& p, size_t& bytes) {
+#ifdef _WIN32
+        FILE* f = fopen(path, "rb");
+        if (!f) return false;
+        fseek(f, 0, SEEK_END);
+        bytes = (size_t)ftell(f);
+        fseek(f, 0, SEEK_SET);
+        char* buf = new char[bytes ? bytes : 1];
+        bool ok = fread(buf, 1, bytes, f) == bytes;
+        fclose(f);
+        if (!ok) {
+            delete[] buf;
+            return false;
+        }
+        p = buf;
+        return true;
+#else
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            ::close(fd);
+            return false;
+        }
+        bytes = (size_t)st.st_size;
+        void* m = bytes ? mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0) : nullptr;
+        ::close(fd);
+        if (m == MAP_FAILED) return false;
+        p = static_cast<const char*>(m);
+        return true;
+#endif
+    }
+
+    static void unload(const char*& p, size_t bytes) {
+        if (!p) return;
+#ifdef _WIN32
+        delete[] p;
+        (void)bytes;
+#else
+        munmap(const_cast<char*>(p), bytes);
+#endif
+        p = nullptr;
+    }
+
+    void close() {
+        unload(data, dataBytes);
+        unload(index, indexBytes);
+        dataBytes = indexBytes = count = 0;
+    }
+};
+
+#endif // MOSQUITO_TRAJECTORY_H
@@ -0,0 +1,118 @@
+// ---------------------------------------------------------------------------
+// UnitCircle.h - cached unit-circle tables for circles and ellipses
+//
+// unitCircle(n) returns n + 1 (cos, sin) pairs, interleaved, for the angles
+// 2*pi*i/n. The last pair repeats the first, so a triangle fan can close on
+// it and a polygon or line loop can stop one short. The segment counts the
+// front-ends draw with most (16, 24, 32, 36, 48, 72) are tables computed at
+// compile time. Any other count is filled with cosf/sinf on first use and
+// kept. Drawing a circle or ellipse is then a multiply-add per vertex.
+//
+// CircleBatch collects many filled ellipses of one colour into a single
+// triangle list, so a front-end can draw them all with one call.
+//
+// No GL here. The runtime cache is not thread-safe; only the render thread
+// uses it.
+// ---------------------------------------------------------------------------
+#ifndef MOSQUITO_UNIT_CIRCLE_H
+#define MOSQUITO_UNIT_CIRCLE_H
+
+#include <cmath>
+#include <vector>
+
+namespace unit_circle {
+
+constexpr double PI = 3.14159265358979323846;
+
+// Taylor series; exact to float precision for |x| <= pi
+constexpr double sinSeries(double x) {
+    double term = x, sum = x;
+    for (int n = 1; n < 20; ++n) {
+        term *= -x * x / ((2.0 * n) * (2.0 * n + 1.0));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr double cosSeries(double x) {
+    double term = 1.0, sum = 1.0;
+    for (int n = 1; n < 20; ++n) {
+        term *= -x * x / ((2.0 * n - 1.0) * (2.0 * n));
+        sum += term;
+    }
+    return sum;
+}
+
+template <int N>
+struct Table {
+    float xy[2 * (N + 1)] = {};
+
+    constexpr Table() {
+        for (int i = 0; i < N; ++i) {
+            double a = 2.0 * PI * i / N;
+            if (a > PI) a -= 2.0 * PI; // Keep the series in range
+            xy[2 * i] = (float)cosSeries(a);
+            xy[2 * i + 1] = (float)sinSeries(a);
+        }
+        xy[2 * N] = 1.0f; // Closes exactly on the first point
+        xy[2 * N + 1] = 0.0f;
+    }
+};
+
+template <int N>
+inline constexpr Table<N> table{};
+
+} // namespace unit_circle
+
+inline const float* unitCircle(int segments) {
+    switch (segments) {
+    case 16: return unit_circle::table<16>.xy;
+    case 24: return unit_circle::table<24>.xy;
+    case 32: return unit_circle::table<32>.xy;
+    case 36: return unit_circle::table<36>.xy;
+    case 48: return unit_circle::table<48>.xy;
+    case 72: return unit_circle::table<72>.xy;
+    default: break;
+    }
+    static std::vector<std::vector<float>> cache; // Indexed by segment count
+    if ((size_t)segments >= cache.size()) cache.resize(segments + 1);
+    std::vector<float>& t = cache[segments];
+    if (t.empty()) {
+        t.resize(2 * (segments + 1));
+        for (int i = 0; i < segments; ++i) {
+            float a = 2.0f * 3.1415926f * i / segments;
+            t[2 * i] = cosf(a);
+            t[2 * i + 1] = sinf(a);
+        }
+        t[2 * segments] = 1.0f;
+        t[2 * segments + 1] = 0.0f;
+    }
+    return t.data();
+}
+
+class CircleBatch {
+public:
+    std::vector<float> xy; // x, y per vertex, three vertices per triangle
+
+    void clear() { xy.clear(); }
+    size_t vertexCount() const { return xy.size() / 2; }
+
+    // A filled ellipse as a fan of segments triangles
+    void add(float cx, float cy, float rx, float ry, int segments) {
+        const float* t = unitCircle(segments);
+        size_t at = xy.size();
+        xy.resize(at + 6 * (size_t)segments);
+        float* out = xy.data() + at;
+        for (int i = 0; i < segments; ++i) {
+            out[0] = cx;
+            out[1] = cy;
+            out[2] = cx + t[2 * i] * rx;
+            out[3] = cy + t[2 * i + 1] * ry;
+            out[4] = cx + t[2 * i + 2] * rx;
+            out[5] = cy + t[2 * i + 3] * ry;
+            out += 6;
+        }
+    }
+};
+
+#endif // MOSQUITO_UNIT_CIRCLE_H
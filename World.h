@@ -0,0 +1,1074 @@
+// ---------------------------------------------------------------------------
+// World.h - GL-free mosquito simulation engine
+//
+// This is the model that used to live in the globals of MyProject.cpp,
+// 3DProject.cpp and test.cpp. A front-end owns one World and calls step()
+// once per simulation tick. It forwards user actions (spray, bowl, rain,
+// day/night) through the member functions below and turns World::events
+// into popups and sounds. Nothing here touches GL or GLUT, so Headless.cpp
+// can drive it as fast as the CPU allows.
+//
+// With setThreads(n > 1) the per-agent passes (movement, breeding and
+// site occupancy) run in fixed-size chunks on a ThreadPool. Chunks never
+// touch shared state; what they produce (breeders, counts) goes into
+// per-chunk buffers that are merged in chunk order, so a run is identical
+// for any thread count.
+//
+// Countdowns are not polled per agent: a larva hatches a fixed time after
+// it was laid, so the due ones are always the first live larvae, and
+// corpse expiries sit on timing wheels (TimingWheel.h). A tick costs
+// nothing for larvae and corpses that are only waiting.
+//
+// Extra breeding sites (BreedingSites.h) are part of the map: they survive
+// restart() and are only changed through setSites()/addSite(). With none,
+// every rule runs exactly as with the pond and bowl alone.
+// ---------------------------------------------------------------------------
+#ifndef MOSQUITO_WORLD_H
+#define MOSQUITO_WORLD_H
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+#include "BreedingSites.h"
+#include "LarvaPool.h"
+#include "MoveKernel.h"
+#include "Population.h"
+#include "SimRandom.h"
+#include "SpatialGrid.h"
+#include "ThreadPool.h"
+#include "TimingWheel.h"
+
+// ---------------- Configuration ----------------
+// Every literal the three front-ends used to hard-code. Durations are in
+// ticks, i.e. calls to World::step(). The defaults are the 2D program's values.
+struct WorldConfig {
+    int tickMillis = 50;               // Simulated time per tick; the front-ends step it with SimClock
+    int maxMosquitoes = 30;            // Population capacity
+    // Reset
+    float initialAliveChance = 0.5f;   // Random fill at reset (0 = start empty)
+    float initialAttractChance = 1.0f / 3.0f;
+    float initialSpeed = 0.003f;
+    int initialSpawns = 0;             // Pond spawns at reset
+    // Arena, pond and water bowl
+    float bounds = 0.98f;
+    float pondX = -0.7f, pondY = -0.85f;
+    float pondRadiusX = 0.25f, pondRadiusY = 0.12f;
+    float pondNearScaleX = 1.8f, pondNearScaleY = 2.5f;
+    bool pondNearLowerLeftOnly = false;
+    float bowlX = -0.4f, bowlY = -0.9f, bowlRadius = 0.05f;
+    bool bowlVisible = false;
+    float bowlNearScale = 2.0f;
+    // Spawning
+    float spawnArea = 0.9f;
+    float spawnSpeed = 0.004f;
+    float spawnSizeMin = 0.035f, spawnSizeMax = 0.05f;
+    float spawnAttractChance = 0.5f;
+    float bowlSpawnScale = 1.2f;
+    float pondSpawnScale = 0.9f, pondSpawnJitterX = 0.04f, pondSpawnJitterY = 0.03f;
+    int spawnIntervalNormal = 180;
+    int spawnIntervalHigh = 50;
+    float secondSpawnChance = 0.6f;
+    int boostAliveThreshold = 5;
+    int boostNearPond = 2, boostNearBowl = 1;
+    bool respawnDead = true;           // Dead timers running out spawn a replacement
+    int minAlive = 5;                  // ...and empty slots are refilled below this
+    // Movement
+    float attractAccel = 0.001f, attractMinDist = 0.01f;
+    float speedLimit = 0.0f;           // 0 = unlimited
+    float jitterChance = 0.008f, jitterAmount = 0.002f;
+    // Breeding
+    int breedTicks = 200;              // ~10s near the pond lays a larva
+    bool breedAtBowl = false;
+    int maxLarvae = 0;                 // 0 = unlimited
+    float larvaOffset = 0.02f;
+    float larvaSize = 0.04f, larvaGrowth = 0.0f, larvaMaxSize = 0.04f;
+    int larvaMatureTicks = 400;        // ~20s, then larva matures
+    // Rain
+    float rainChance = 0.002f;
+    int rainDuration = 200;            // 10s at 50ms
+    int rainSpawnCount = 5;
+    // Spray
+    float sprayStartRadius = 0.02f, sprayGrowth = 0.018f, sprayMaxRadius = 0.15f;
+    int sprayDuration = 0;             // Fixed lifetime in ticks (0 = grow to max)
+    int maxSprayCharges = 5;
+    int sprayRefillInterval = 600;     // 30s at 50ms per tick
+    int deadTimerMin = 150, deadTimerRange = 150;
+    float killScatter = 0.04f;
+    // Weather and difficulty events (0 = off)
+    float windChance = 0.0f;
+    int windDuration = 0;
+    float windMaxForce = 0.0f;
+    float fogChance = 0.0f;
+    int fogDuration = 0;
+    float cleanupChance = 0.0f;
+    int cleanupDuration = 0;
+    float swarmChance = 0.0f;
+    int swarmMin = 0, swarmRange = 0;
+    int difficultyInterval = 0;
+    int gameOverAlive = 0;
+
+    static WorldConfig classic2D();    // MyProject.cpp
+    static WorldConfig classic3D();    // 3DProject.cpp
+    static WorldConfig arcade();       // test.cpp
+};
+
+inline WorldConfig WorldConfig::classic2D() {
+    return WorldConfig();
+}
+
+inline WorldConfig WorldConfig::classic3D() {
+    WorldConfig c;
+    c.pondY = -0.75f;
+    c.bowlY = -0.8f;
+    c.rainDuration = 600; // 30s at 50ms
+    return c;
+}
+
+inline WorldConfig WorldConfig::arcade() {
+    WorldConfig c;
+    c.tickMillis = 16;
+    c.maxMosquitoes = 50;
+    c.initialAliveChance = 0.0f;
+    c.initialSpawns = 5;
+    c.bounds = 0.95f;
+    c.pondX = 0.0f;
+    c.pondY = -0.2f;
+    c.pondRadiusX = 0.4f;
+    c.pondRadiusY = 0.2f;
+    c.pondNearScaleX = 1.5f;
+    c.pondNearScaleY = 2.0f;
+    c.pondNearLowerLeftOnly = true;
+    c.bowlX = 0.5f;
+    c.bowlY = 0.0f;
+    c.bowlRadius = 0.1f;
+    c.bowlVisible = true;
+    c.bowlNearScale = 1.8f;
+    c.spawnArea = 0.95f;
+    c.spawnSpeed = 0.005f;
+    c.spawnSizeMin = 0.03f;
+    c.spawnSizeMax = 0.06f;
+    c.bowlSpawnScale = 1.3f;
+    c.pondSpawnScale = 0.95f;
+    c.pondSpawnJitterX = 0.0f;
+    c.pondSpawnJitterY = 0.0f;
+    c.spawnIntervalNormal = 100;
+    c.spawnIntervalHigh = 60;
+    c.secondSpawnChance = 0.5f;
+    c.boostAliveThreshold = 8;
+    c.boostNearPond = 3;
+    c.boostNearBowl = 2;
+    c.respawnDead = false;
+    c.minAlive = 0;
+    c.attractAccel = 0.002f;
+    c.attractMinDist = 0.02f;
+    c.speedLimit = 0.008f;
+    c.jitterChance = 10.0f / 800.0f;
+    c.jitterAmount = 0.003f;
+    c.breedTicks = 150;
+    c.breedAtBowl = true;
+    c.maxLarvae = 100;
+    c.larvaOffset = 0.03f;
+    c.larvaSize = 0.01f;
+    c.larvaGrowth = 0.0001f;
+    c.larvaMaxSize = 0.015f;
+    c.larvaMatureTicks = 350;
+    c.rainChance = 6.0f / 900.0f;
+    c.rainDuration = 500;
+    c.rainSpawnCount = 3;
+    c.sprayStartRadius = 0.2f;
+    c.sprayGrowth = 0.0f;
+    c.sprayMaxRadius = 0.2f;
+    c.sprayDuration = 30;
+    c.deadTimerMin = 60;
+    c.deadTimerRange = 40;
+    c.killScatter = 0.05f;
+    c.windChance = 5.0f / 900.0f;
+    c.windDuration = 600;
+    c.windMaxForce = 0.006f;
+    c.fogChance = 4.0f / 900.0f;
+    c.fogDuration = 400;
+    c.cleanupChance = 3.0f / 900.0f;
+    c.cleanupDuration = 1000;
+    c.swarmChance = 3.0f / 900.0f;
+    c.swarmMin = 4;
+    c.swarmRange = 4;
+    c.difficultyInterval = 4800;
+    c.gameOverAlive = 40;
+    return c;
+}
+
+// ---------------- Agents ----------------
+// Mosquitoes and larvae are stored column-wise, see Population.h and
+// LarvaPool.h. Larvae must be added in the order they are laid.
+
+// ---------------- Events ----------------
+// Things a front-end may want to announce. Cleared at the start of each step().
+enum SimEventType {
+    EVENT_RAIN_STARTED,     // count = mosquitoes spawned
+    EVENT_RAIN_STOPPED,
+    EVENT_SPRAY_KILLS,      // count = mosquitoes + larvae killed this tick
+    EVENT_SPRAY_REFILLED,   // count = charges now available
+    EVENT_LARVA_SPAWNED,    // x, y = parent position
+    EVENT_LARVA_MATURED,
+    EVENT_WIND_STARTED,     // x = wind force
+    EVENT_FOG_STARTED,
+    EVENT_CLEANUP_STARTED,
+    EVENT_CLEANUP_ENDED,
+    EVENT_SWARM,            // count = mosquitoes spawned
+    EVENT_DIFFICULTY_UP,
+    EVENT_GAME_OVER
+};
+
+struct SimEvent {
+    SimEventType type;
+    int count;
+    float x, y;
+};
+
+// ---------------- World ----------------
+class World {
+public:
+    WorldConfig cfg;
+    Population mosquitoes;
+    LarvaPool larvae;
+    // Water bowl
+    float waterBowlX, waterBowlY;
+    bool waterBowlVisible;
+    // Spray
+    bool spraying;
+    float sprayX, sprayY, sprayRadius;
+    int sprayTimer;
+    int sprayCharges;
+    int sprayRefillTimer;
+    // Spawn control
+    int spawnCounter;
+    int currentSpawnInterval;
+    int difficultyTimer;
+    // Weather
+    bool rainActive;
+    int rainTimer;
+    bool windActive;
+    int windTimer;
+    float windForce;
+    bool fogActive;
+    int fogTimer;
+    int cleanupTimer;
+    int environmentState; // 0=Day, 1=Night, 2=Fog
+    // Score
+    int totalAlive;
+    int totalKilled;
+    // Breeding-site occupancy: mosquitoes whose SITE_* bits are set
+    int nearPondCount;
+    int nearBowlCount;
+    long long tick;
+    int killedThisTick;
+    int spawnedThisTick;
+    std::vector<SimEvent> events;
+    MoveIsa moveIsa; // Movement kernel, the widest the CPU supports unless overridden
+
+    explicit World(const WorldConfig& config = WorldConfig(), unsigned seed = 1);
+
+    void reset(unsigned seed);  // Reseed and restart
+    void restart();             // Restart, continuing the random stream and tick count
+    void step();
+    void setThreads(int threads);   // 1 runs everything on the calling thread
+    int threads() const { return pool ? pool->size() : 1; }
+
+    // User actions
+    bool spray(float x, float y);   // false if no charges are left
+    void toggleBowl();
+    void moveBowl(float x, float y);
+    bool triggerRain();             // false if it is already raining
+    void setEnvironment(int state);
+    float uniform(float a, float b); // From the world stream, e.g. for a random spray target
+
+    double simSeconds() const { return tick * cfg.tickMillis / 1000.0; } // Simulated time since reset()
+    float larvaSize(size_t i) const; // Of larva slot i
+    bool isNearPondArea(float x, float y) const;
+    bool isNearWaterBowl(float x, float y) const;
+    enum Site { SITE_POND = 1, SITE_BOWL = 2 };
+    unsigned char siteOf(float x, float y) const; // SITE_* bits
+    // Extra breeding sites, besides the pond and bowl
+    const std::vector<BreedingSite>& breedingSites() const { return sites; }
+    int siteLarvae(size_t s) const { return siteLarvaCount[s]; } // Live larvae laid there
+    void setSites(const std::vector<BreedingSite>& list); // Drops larvae laid at the old sites
+    void addSite(const BreedingSite& site);
+    void spawnOneMosquito(bool pondBoost);
+    void moveMosquitoes();          // Movement pass alone, for Benchmark.cpp
+
+private:
+    friend struct SnapshotIO; // Snapshot.h saves the private state too
+
+    // Randomness is keyed, not sequential (SimRandom.h). Per-agent draws use
+    // the agent's slot as the counter; world-level events (weather, spawns,
+    // user actions) take consecutive blocks of the STREAM_WORLD counter.
+    enum RandomStream { STREAM_WORLD, STREAM_MOVE, STREAM_KILL, STREAM_BREED };
+    SimRandom rng;
+    uint32_t worldDraws;  // Words used from the world stream this tick
+    RandomWords worldBlock;
+    // Spatial index over positions. A build costs a few full scans, so the
+    // mosquito grid is only built on ticks with an active spray; other
+    // queries use it when it exists and scan otherwise. Entries appended
+    // since the last build are scanned directly.
+    static constexpr float gridExtent = 1.1f;
+    SpatialGrid mosquitoGrid, larvaGrid;
+    bool mosquitoGridValid = false, larvaGridValid = false;
+    unsigned larvaGridLayout = 0; // larvae.layout when larvaGrid was built
+    // Extra breeding sites and the index over them, rebuilt when the list changes
+    std::vector<BreedingSite> sites;
+    std::vector<int> siteLarvaCount;
+    SiteIndex siteIndex;
+    bool siteIndexValid = false;
+    std::vector<float> homeX, homeY; // Each attracted mosquito's non-bowl target while there are sites
+    std::vector<uint32_t> hits; // Scratch for spray queries
+    std::vector<uint32_t> moveRand0, moveRand1; // Per-agent random words for the movement kernel
+    // Parallel passes
+    static constexpr size_t chunkSize = 8192; // Agents per task, independent of the thread count
+    std::unique_ptr<ThreadPool> pool;
+    std::vector<std::vector<uint32_t>> chunkPicks; // Indices each chunk selected, merged in chunk order
+    std::vector<int> chunkCounts; // Pond and bowl occupancy changes, two per chunk
+    // Corpse countdowns. A corpse's timer drops by 1 in updateBreeding() and,
+    // with respawnDead, by 2 in respawnDeadMosquitoes() (1 away from the pond
+    // while the bowl is hidden). Instead of decrementing every corpse, each
+    // rate class has a wheel whose clock advances by what its corpses lose,
+    // and every corpse is scheduled on its class's wheel.
+    enum CorpseClock { CLOCK_NEAR_POND, CLOCK_ELSEWHERE, CORPSE_CLOCKS };
+    struct CorpseTimer {
+        uint64_t deadline;   // On corpseWheels[clock]
+        uint32_t corpse;     // Index in mosquitoes.corpses
+        uint32_t generation; // Bumped when the corpse goes, so its wheel entry is ignored
+        uint8_t clock;
+        bool expiring;
+    };
+    TimingWheel corpseWheels[CORPSE_CLOCKS];
+    std::vector<CorpseTimer> corpseTimers;
+    std::vector<uint32_t> freeCorpseTimers;
+    std::vector<uint32_t> expiring; // Corpses running out in the current pass
+
+    uint32_t nextWorldWord();
+    float randFloat(float a, float b);
+    bool chance(float p);
+    void emit(SimEventType type, int count = 0, float x = 0.0f, float y = 0.0f);
+    void startRain();
+    void updateMosquitoesLogic();
+    void updateBreeding();
+    void updateLarvae();
+    void updateRain();
+    void updateWeather();
+    void updateSpawning();
+    void updateSpray();
+    void checkSprayCollisions();
+    void updateRefill();
+    void respawnDeadMosquitoes();
+    void addCorpse(float x, float y, int ticks);
+    int corpseTicksLeft(size_t c) const;
+    void removeCorpse(size_t c);
+    void clearCorpses();
+    void expireCorpses(int nearPondStep, int elsewhereStep, bool respawn);
+    void indexMosquitoes();
+    static size_t chunksFor(size_t n) { return (n + chunkSize - 1) / chunkSize; }
+    template <class F> void forEachChunk(size_t n, F f);
+    template <class F> void forEachMosquitoIn(float x0, float y0, float x1, float y1, F f);
+    template <class F> void forEachLarvaIn(float x0, float y0, float x1, float y1, F f);
+    void countSite(size_t i, unsigned char site);
+    void initSpawned(size_t i);
+    void spawnAtSite(size_t s);
+    int breedingSiteAt(size_t i) const; // Extra site mosquito i breeds at, -1 for the pond and bowl
+    bool siteHasRoom(int s) const;
+    void removeLarva(size_t i);
+};
+
+inline World::World(const WorldConfig& config, unsigned seed) : cfg(config), moveIsa(bestMoveIsa()) {
+    reset(seed);
+}
+
+inline void World::setThreads(int threads) {
+    if (threads == this->threads()) return;
+    pool.reset(threads > 1 ? new ThreadPool(threads) : nullptr);
+}
+
+inline uint32_t World::nextWorldWord() {
+    uint32_t k = worldDraws++;
+    if (k % 4 == 0) worldBlock = rng.at(k / 4, tick, STREAM_WORLD);
+    return worldBlock.w[k % 4];
+}
+
+inline float World::randFloat(float a, float b) {
+    return a + SimRandom::unit(nextWorldWord()) * (b - a);
+}
+
+inline float World::uniform(float a, float b) {
+    return randFloat(a, b);
+}
+
+inline bool World::chance(float p) {
+    return randFloat(0.0f, 1.0f) < p;
+}
+
+inline void World::emit(SimEventType type, int count, float x, float y) {
+    SimEvent e = {type, count, x, y};
+    events.push_back(e);
+}
+
+inline void World::reset(unsigned seed) {
+    rng.setSeed(seed);
+    tick = 0;
+    worldDraws = 0;
+    restart();
+}
+
+inline void World::restart() {
+    mosquitoes.assign(cfg.maxMosquitoes);
+    clearCorpses();
+    larvae.assign(cfg.maxLarvae);
+    siteLarvaCount.assign(sites.size(), 0);
+    mosquitoGridValid = larvaGridValid = false;
+    waterBowlX = cfg.bowlX;
+    waterBowlY = cfg.bowlY;
+    waterBowlVisible = cfg.bowlVisible;
+    spraying = false;
+    sprayX = sprayY = 0.0f;
+    sprayRadius = cfg.sprayStartRadius;
+    sprayTimer = 0;
+    sprayCharges = cfg.maxSprayCharges;
+    sprayRefillTimer = 0;
+    spawnCounter = 0;
+    currentSpawnInterval = cfg.spawnIntervalNormal;
+    difficultyTimer = 0;
+    rainActive = false;
+    rainTimer = 0;
+    windActive = false;
+    windTimer = 0;
+    windForce = 0.0f;
+    fogActive = false;
+    fogTimer = 0;
+    cleanupTimer = 0;
+    environmentState = 0;
+    totalAlive = 0;
+    totalKilled = 0;
+    nearPondCount = nearBowlCount = 0;
+    killedThisTick = 0;
+    spawnedThisTick = 0;
+    events.clear();
+    if (cfg.initialAliveChance > 0.0f) {
+        Population& m = mosquitoes;
+        for (size_t s = 0; s < m.capacity(); ++s) {
+            float x = randFloat(-cfg.spawnArea, cfg.spawnArea);
+            float y = randFloat(-cfg.spawnArea, cfg.spawnArea);
+            float dx = randFloat(-cfg.initialSpeed, cfg.initialSpeed);
+            float dy = randFloat(-cfg.initialSpeed, cfg.initialSpeed);
+            float size = randFloat(cfg.spawnSizeMin, cfg.spawnSizeMax);
+            bool alive = chance(cfg.initialAliveChance);
+            bool attracted = chance(cfg.initialAttractChance);
+            if (!alive) continue;
+            size_t i = m.spawn();
+            m.x[i] = x;
+            m.y[i] = y;
+            m.dx[i] = dx;
+            m.dy[i] = dy;
+            m.size[i] = size;
+            m.attractedToPond[i] = attracted;
+            m.pondTime[i] = 0;
+            m.site[i] = 0; // Not counted anywhere yet
+            countSite(i, siteOf(x, y));
+            totalAlive++;
+        }
+    }
+    for (int i = 0; i < cfg.initialSpawns; ++i) spawnOneMosquito(true);
+    spawnedThisTick = 0;
+}
+
+// ---------------- User actions ----------------
+inline bool World::spray(float x, float y) {
+    if (sprayCharges <= 0) return false;
+    sprayX = x;
+    sprayY = y;
+    sprayRadius = cfg.sprayStartRadius;
+    sprayTimer = cfg.sprayDuration;
+    spraying = true;
+    sprayCharges--;
+    return true;
+}
+
+inline void World::toggleBowl() {
+    waterBowlVisible = !waterBowlVisible;
+}
+
+inline void World::moveBowl(float x, float y) {
+    waterBowlX = x;
+    waterBowlY = y;
+}
+
+inline bool World::triggerRain() {
+    if (rainActive) return false;
+    startRain();
+    return true;
+}
+
+inline void World::setEnvironment(int state) {
+    environmentState = state;
+}
+
+// ---------------- Logic ----------------
+inline bool World::isNearPondArea(float x, float y) const {
+    float rx = cfg.pondRadiusX * cfg.pondNearScaleX;
+    float ry = cfg.pondRadiusY * cfg.pondNearScaleY;
+    float nx = (x - cfg.pondX) / rx;
+    float ny = (y - cfg.pondY) / ry;
+    if (cfg.pondNearLowerLeftOnly && (x >= cfg.pondX || y >= cfg.pondY)) return false;
+    return (nx * nx + ny * ny) <= 1.0f;
+}
+
+inline bool World::isNearWaterBowl(float x, float y) const {
+    if (!waterBowlVisible) return false;
+    float dx = x - waterBowlX;
+    float dy = y - waterBowlY;
+    return sqrtf(dx * dx + dy * dy) <= cfg.bowlRadius * cfg.bowlNearScale;
+}
+
+inline unsigned char World::siteOf(float x, float y) const {
+    return (isNearPondArea(x, y) ? SITE_POND : 0) | (isNearWaterBowl(x, y) ? SITE_BOWL : 0);
+}
+
+// Move mosquito i's entry in the occupancy counters to site
+inline void World::countSite(size_t i, unsigned char site) {
+    unsigned char& old = mosquitoes.site[i];
+    nearPondCount += (site & SITE_POND) - (old & SITE_POND);
+    nearBowlCount += ((site & SITE_BOWL) - (old & SITE_BOWL)) / SITE_BOWL;
+    old = site;
+}
+
+inline void World::spawnOneMosquito(bool pondBoost) {
+    Population& m = mosquitoes;
+    if (m.full()) return;
+    // A spawn may take the slot of a corpse still counting down
+    if (m.count() + m.corpses.size() >= m.capacity()) removeCorpse(m.corpses.size() - 1);
+    bool useBowl = waterBowlVisible && chance(0.5f);
+    float angle = randFloat(0.0f, 2.0f * 3.1415926f);
+    size_t i = m.spawn();
+    if (pondBoost && useBowl) {
+        m.x[i] = waterBowlX + cosf(angle) * cfg.bowlRadius * cfg.bowlSpawnScale;
+        m.y[i] = waterBowlY + sinf(angle) * cfg.bowlRadius * cfg.bowlSpawnScale;
+    } else if (pondBoost) {
+        float rx = cfg.pondRadiusX * cfg.pondSpawnScale + randFloat(0.0f, cfg.pondSpawnJitterX);
+        float ry = cfg.pondRadiusY * cfg.pondSpawnScale + randFloat(0.0f, cfg.pondSpawnJitterY);
+        m.x[i] = cfg.pondX + cosf(angle) * rx;
+        m.y[i] = cfg.pondY + sinf(angle) * ry;
+    } else {
+        m.x[i] = randFloat(-cfg.spawnArea, cfg.spawnArea);
+        m.y[i] = randFloat(-cfg.spawnArea, cfg.spawnArea);
+    }
+    initSpawned(i);
+}
+
+// A larva from an extra site hatches at that site's edge
+inline void World::spawnAtSite(size_t s) {
+    Population& m = mosquitoes;
+    if (m.full()) return;
+    if (m.count() + m.corpses.size() >= m.capacity()) removeCorpse(m.corpses.size() - 1);
+    const BreedingSite& site = sites[s];
+    float angle = randFloat(0.0f, 2.0f * 3.1415926f);
+    size_t i = m.spawn();
+    m.x[i] = site.x + cosf(angle) * site.radiusX * cfg.pondSpawnScale;
+    m.y[i] = site.y + sinf(angle) * site.radiusY * cfg.pondSpawnScale;
+    initSpawned(i);
+}
+
+// Everything but the position of a freshly spawned mosquito
+inline void World::initSpawned(size_t i) {
+    Population& m = mosquitoes;
+    m.dx[i] = randFloat(-cfg.spawnSpeed, cfg.spawnSpeed);
+    m.dy[i] = randFloat(-cfg.spawnSpeed, cfg.spawnSpeed);
+    m.size[i] = randFloat(cfg.spawnSizeMin, cfg.spawnSizeMax);
+    m.attractedToPond[i] = chance(cfg.spawnAttractChance);
+    m.pondTime[i] = 0;
+    m.site[i] = 0; // Not counted anywhere yet
+    countSite(i, siteOf(m.x[i], m.y[i]));
+    totalAlive++;
+    spawnedThisTick++;
+}
+
+inline void World::step() {
+    events.clear();
+    killedThisTick = 0;
+    spawnedThisTick = 0;
+    tick++;
+    worldDraws = 0;
+    updateMosquitoesLogic();
+    updateSpray();
+    updateRefill();
+    respawnDeadMosquitoes();
+    if (cfg.gameOverAlive > 0 && totalAlive > cfg.gameOverAlive) {
+        emit(EVENT_GAME_OVER, totalAlive);
+        restart();
+    }
+}
+
+inline void World::updateMosquitoesLogic() {
+    moveMosquitoes();
+    updateBreeding();
+    updateLarvae();
+    updateRain();
+    updateWeather();
+    updateSpawning();
+}
+
+// Streams only the position/velocity columns, see MoveKernel.h
+inline void World::moveMosquitoes() {
+    Population& m = mosquitoes;
+    const size_t n = m.count();
+    moveRand0.resize(n);
+    moveRand1.resize(n);
+    MoveParams p;
+    p.pondX = cfg.pondX;
+    p.pondY = cfg.pondY;
+    p.bowlX = waterBowlX;
+    p.bowlY = waterBowlY;
+    p.bowlVisible = waterBowlVisible;
+    p.attractAccel = cfg.attractAccel;
+    p.attractMinDist = cfg.attractMinDist;
+    p.speedLimit = cfg.speedLimit;
+    p.bounds = cfg.bounds;
+    p.wind = windActive ? windForce : 0.0f;
+    p.jitterThreshold = (uint32_t)std::min(cfg.jitterChance * 2147483648.0, 2147483647.0);
+    p.jitterAmount = cfg.jitterAmount;
+    MoveColumns c = {m.x.data(), m.y.data(), m.dx.data(), m.dy.data(), m.attractedToPond.data(),
+                     moveRand0.data(), moveRand1.data(), nullptr, nullptr};
+    if (!sites.empty()) {
+        if (!siteIndexValid) {
+            siteIndex.build(sites, -gridExtent, gridExtent);
+            siteIndexValid = true;
+        }
+        homeX.resize(n);
+        homeY.resize(n);
+        c.homeX = homeX.data();
+        c.homeY = homeY.data();
+    }
+    forEachChunk(n, [&](size_t, size_t begin, size_t end) {
+        rng.fill2(m.slot.data() + begin, end - begin, tick, STREAM_MOVE, moveRand0.data() + begin,
+                  moveRand1.data() + begin, moveIsa == MOVE_AVX2);
+        // Head for the pond unless a site pulls harder (distance over attractiveness)
+        for (size_t i = begin; c.homeX && i < end; ++i) {
+            homeX[i] = cfg.pondX;
+            homeY[i] = cfg.pondY;
+            if (!m.attractedToPond[i]) continue;
+            float dx = cfg.pondX - m.x[i], dy = cfg.pondY - m.y[i];
+            float score = sqrtf(dx * dx + dy * dy);
+            int s = siteIndex.nearest(m.x[i], m.y[i], score);
+            if (s < 0) continue;
+            homeX[i] = sites[s].x;
+            homeY[i] = sites[s].y;
+        }
+        moveAgents(moveIsa, p, c, begin, end);
+    });
+    mosquitoGridValid = false;
+}
+
+// Larva laying, site occupancy and dead timers. Whether there is room for
+// larvae is judged once per tick; the chunks list their breeders and the
+// merge lays larvae in index order until maxLarvae is reached. Each chunk
+// also sums the site entries and exits it saw, so the occupancy counters
+// are current without a second pass (spawns and kills adjust them too).
+inline void World::updateBreeding() {
+    Population& m = mosquitoes;
+    const bool room = cfg.maxLarvae == 0 || (int)larvae.count() < cfg.maxLarvae;
+    const size_t chunks = chunksFor(m.count());
+    if (chunkPicks.size() < chunks) chunkPicks.resize(chunks);
+    if (chunkCounts.size() < 2 * chunks) chunkCounts.resize(2 * chunks);
+    forEachChunk(m.count(), [&](size_t k, size_t begin, size_t end) {
+        std::vector<uint32_t>& breeders = chunkPicks[k];
+        breeders.clear();
+        int pondDelta = 0, bowlDelta = 0;
+        for (size_t i = begin; i < end; ++i) {
+            unsigned char site = siteOf(m.x[i], m.y[i]);
+            if (site != m.site[i]) {
+                pondDelta += (site & SITE_POND) - (m.site[i] & SITE_POND);
+                bowlDelta += ((site & SITE_BOWL) - (m.site[i] & SITE_BOWL)) / SITE_BOWL;
+                m.site[i] = site;
+            }
+            bool nearSite = (site & SITE_POND) || (cfg.breedAtBowl && (site & SITE_BOWL));
+            if (!nearSite && !sites.empty()) nearSite = siteHasRoom(siteIndex.containing(m.x[i], m.y[i]));
+            if (nearSite && room) {
+                if (++m.pondTime[i] > cfg.breedTicks) {
+                    breeders.push_back((uint32_t)i);
+                    m.pondTime[i] = 0;
+                }
+            } else {
+                m.pondTime[i] = 0;
+            }
+        }
+        chunkCounts[2 * k] = pondDelta;
+        chunkCounts[2 * k + 1] = bowlDelta;
+    });
+    for (size_t k = 0; k < chunks; ++k) {
+        nearPondCount += chunkCounts[2 * k];
+        nearBowlCount += chunkCounts[2 * k + 1];
+    }
+    for (size_t k = 0; k < chunks; ++k) {
+        for (uint32_t i : chunkPicks[k]) {
+            if (cfg.maxLarvae > 0 && (int)larvae.count() >= cfg.maxLarvae) break;
+            int s = breedingSiteAt(i);
+            if (s >= 0 && !siteHasRoom(s)) continue; // Filled by an earlier breeder this tick
+            RandomWords r = rng.at(m.slot[i], tick, STREAM_BREED);
+            if (!larvae.add(m.x[i] + (SimRandom::unit(r.w[0]) * 2.0f - 1.0f) * cfg.larvaOffset,
+                            m.y[i] + (SimRandom::unit(r.w[1]) * 2.0f - 1.0f) * cfg.larvaOffset,
+                            cfg.larvaSize, tick, s)) break;
+            if (s >= 0) siteLarvaCount[s]++;
+            emit(EVENT_LARVA_SPAWNED, 1, m.x[i], m.y[i]);
+        }
+    }
+    // A corpse whose timer runs out here just frees its slot
+    expireCorpses(1, 1, false);
+}
+
+// Every larva takes larvaMatureTicks, and they are laid in tick order, so
+// the ones due to hatch are the first live ones; the rest are not touched.
+// (A larva laid on tick t used to count its timer to 1 on that same tick.)
+inline void World::updateLarvae() {
+    LarvaPool& l = larvae;
+    bool hatched = false;
+    for (; l.front < l.used(); ++l.front) {
+        size_t i = l.front;
+        if (!l.alive[i]) continue;
+        if (tick - l.laidTick[i] < cfg.larvaMatureTicks) break;
+        if (l.site[i] >= 0) spawnAtSite((size_t)l.site[i]);
+        else spawnOneMosquito(true);
+        emit(EVENT_LARVA_MATURED);
+        removeLarva(i);
+        hatched = true;
+    }
+    if (hatched && l.wantsCompact()) l.compact();
+}
+
+inline void World::removeLarva(size_t i) {
+    if (!larvae.alive[i]) return;
+    if (larvae.site[i] >= 0) siteLarvaCount[larvae.site[i]]--;
+    larvae.remove(i);
+}
+
+// ---------------- Breeding sites ----------------
+inline void World::setSites(const std::vector<BreedingSite>& list) {
+    sites = list;
+    siteIndexValid = false;
+    siteLarvaCount.assign(sites.size(), 0);
+    for (size_t i = larvae.front; i < larvae.used(); ++i)
+        if (larvae.alive[i] && larvae.site[i] >= 0) larvae.remove(i);
+    larvae.compact();
+    larvaGridValid = false;
+}
+
+inline void World::addSite(const BreedingSite& site) {
+    sites.push_back(site);
+    siteLarvaCount.push_back(0);
+    siteIndexValid = false;
+}
+
+inline int World::breedingSiteAt(size_t i) const {
+    unsigned char site = mosquitoes.site[i];
+    if ((site & SITE_POND) || (cfg.breedAtBowl && (site & SITE_BOWL)) || sites.empty()) return -1;
+    return siteIndex.containing(mosquitoes.x[i], mosquitoes.y[i]);
+}
+
+inline bool World::siteHasRoom(int s) const {
+    return s >= 0 && (sites[s].capacity == 0 || siteLarvaCount[s] < sites[s].capacity);
+}
+
+// Grown size, from its age rather than a per-tick update
+inline float World::larvaSize(size_t i) const {
+    if (cfg.larvaGrowth <= 0.0f) return larvae.size[i];
+    return std::min(larvae.size[i] + cfg.larvaGrowth * (float)(tick - larvae.laidTick[i] + 1), cfg.larvaMaxSize);
+}
+
+inline void World::startRain() {
+    rainActive = true;
+    rainTimer = cfg.rainDuration;
+    for (int i = 0; i < cfg.rainSpawnCount; ++i) spawnOneMosquito(true);
+}
+
+inline void World::updateRain() {
+    if (rainActive) {
+        rainTimer--;
+        if (rainTimer <= 0) {
+            rainActive = false;
+            emit(EVENT_RAIN_STOPPED);
+        }
+    } else if (chance(cfg.rainChance) && cleanupTimer == 0 && environmentState != 2) { // No random rain in fog
+        startRain();
+        emit(EVENT_RAIN_STARTED, cfg.rainSpawnCount);
+    }
+}
+
+inline void World::updateWeather() {
+    if (windActive) {
+        windTimer--;
+        if (windTimer <= 0) windActive = false;
+    } else if (cfg.windChance > 0.0f && chance(cfg.windChance) && cleanupTimer == 0) {
+        windActive = true;
+        windTimer = cfg.windDuration;
+        windForce = randFloat(-cfg.windMaxForce, cfg.windMaxForce);
+        emit(EVENT_WIND_STARTED, 0, windForce);
+    }
+    if (fogActive) {
+        fogTimer--;
+        if (fogTimer <= 0) fogActive = false;
+    } else if (cfg.fogChance > 0.0f && chance(cfg.fogChance) && cleanupTimer == 0) {
+        fogActive = true;
+        fogTimer = cfg.fogDuration;
+        emit(EVENT_FOG_STARTED);
+    }
+    if (cleanupTimer > 0) {
+        cleanupTimer--;
+        if (cleanupTimer <= 0) {
+            currentSpawnInterval = cfg.spawnIntervalNormal;
+            emit(EVENT_CLEANUP_ENDED);
+        }
+    } else if (cfg.cleanupChance > 0.0f && chance(cfg.cleanupChance) && !rainActive && !windActive && !fogActive) {
+        cleanupTimer = cfg.cleanupDuration;
+        waterBowlVisible = false;
+        larvae.clear();
+        std::fill(siteLarvaCount.begin(), siteLarvaCount.end(), 0);
+        larvaGridValid = false;
+        currentSpawnInterval = cfg.spawnIntervalNormal * 2;
+        emit(EVENT_CLEANUP_STARTED);
+    }
+    if (cfg.swarmChance > 0.0f && chance(cfg.swarmChance) && !rainActive && !windActive && !fogActive && cleanupTimer == 0) {
+        int swarmCount = cfg.swarmMin + (int)(randFloat(0.0f, 1.0f) * cfg.swarmRange);
+        for (int i = 0; i < swarmCount; ++i) spawnOneMosquito(true);
+        emit(EVENT_SWARM, swarmCount);
+    }
+}
+
+inline void World::updateSpawning() {
+    bool boost = waterBowlVisible || totalAlive > cfg.boostAliveThreshold || rainActive ||
+                 cleanupTimer > 0 || environmentState != 0;
+    // Bowl entries are only cleared by the next pass once the bowl is hidden
+    int nearBowl = waterBowlVisible ? nearBowlCount : 0;
+    if (nearPondCount > cfg.boostNearPond || nearBowl > cfg.boostNearBowl) boost = true;
+    currentSpawnInterval = (boost && cleanupTimer == 0) ? cfg.spawnIntervalHigh : cfg.spawnIntervalNormal;
+    spawnCounter++;
+    if (spawnCounter >= currentSpawnInterval) {
+        spawnOneMosquito(boost);
+        if (chance(cfg.secondSpawnChance) && cleanupTimer == 0) spawnOneMosquito(boost);
+        spawnCounter = 0;
+    }
+    if (cfg.difficultyInterval > 0 && ++difficultyTimer >= cfg.difficultyInterval) {
+        currentSpawnInterval = std::max(40, currentSpawnInterval - 10);
+        difficultyTimer = 0;
+        emit(EVENT_DIFFICULTY_UP);
+    }
+}
+
+// ---------------- Spray & collision ----------------
+inline void World::updateSpray() {
+    if (!spraying) return;
+    if (cfg.sprayDuration > 0) {
+        sprayTimer--;
+        if (sprayTimer <= 0) spraying = false;
+    }
+    checkSprayCollisions();
+    if (cfg.sprayGrowth > 0.0f) {
+        sprayRadius += cfg.sprayGrowth;
+        if (sprayRadius > cfg.sprayMaxRadius) {
+            spraying = false;
+            sprayRadius = cfg.sprayStartRadius;
+        }
+    }
+}
+
+inline void World::checkSprayCollisions() {
+    if (!spraying) return;
+    int killedThisSpray = 0;
+    Population& m = mosquitoes;
+    float reach = sprayRadius + cfg.spawnSizeMax * 0.5f;
+    hits.clear();
+    if (!mosquitoGridValid) indexMosquitoes();
+    forEachMosquitoIn(sprayX - reach, sprayY - reach, sprayX + reach, sprayY + reach, [&](size_t i) {
+        float dx = m.x[i] - sprayX;
+        float dy = m.y[i] - sprayY;
+        float dist = sqrtf(dx * dx + dy * dy);
+        if (dist <= sprayRadius + m.size[i] * 0.5f) hits.push_back((uint32_t)i);
+    });
+    // Index order, so the corpse list does not depend on the grid
+    std::sort(hits.begin(), hits.end());
+    for (uint32_t i : hits) {
+        RandomWords r = rng.at(m.slot[i], tick, STREAM_KILL);
+        addCorpse(m.x[i] + (SimRandom::unit(r.w[1]) * 2.0f - 1.0f) * cfg.killScatter,
+                  m.y[i] + (SimRandom::unit(r.w[2]) * 2.0f - 1.0f) * cfg.killScatter,
+                  cfg.deadTimerMin + (int)(SimRandom::unit(r.w[0]) * cfg.deadTimerRange));
+    }
+    // Back to front, so each swap-remove only moves a survivor
+    for (size_t k = hits.size(); k-- > 0;) {
+        countSite(hits[k], 0);
+        m.kill(hits[k]);
+    }
+    if (!hits.empty()) mosquitoGridValid = false;
+    totalAlive -= (int)hits.size();
+    totalKilled += (int)hits.size();
+    killedThisSpray += (int)hits.size();
+    // Spray larvae too
+    int larvaeKilled = 0;
+    forEachLarvaIn(sprayX - sprayRadius, sprayY - sprayRadius, sprayX + sprayRadius, sprayY + sprayRadius, [&](size_t i) {
+        float dx = larvae.x[i] - sprayX;
+        float dy = larvae.y[i] - sprayY;
+        if (sqrtf(dx * dx + dy * dy) <= sprayRadius) {
+            removeLarva(i); // Tombstone; the grid stays valid
+            larvaeKilled++;
+        }
+    });
+    if (larvaeKilled > 0) {
+        if (larvae.wantsCompact()) larvae.compact();
+        totalKilled += larvaeKilled;
+        killedThisSpray += larvaeKilled;
+    }
+    if (killedThisSpray > 0) {
+        killedThisTick += killedThisSpray;
+        emit(EVENT_SPRAY_KILLS, killedThisSpray, sprayX, sprayY);
+    }
+}
+
+inline void World::updateRefill() {
+    sprayRefillTimer++;
+    if (sprayRefillTimer >= cfg.sprayRefillInterval && sprayCharges < cfg.maxSprayCharges) {
+        sprayCharges++;
+        sprayRefillTimer = 0;
+        emit(EVENT_SPRAY_REFILLED, sprayCharges);
+    }
+}
+
+inline void World::respawnDeadMosquitoes() {
+    if (!cfg.respawnDead) return;
+    Population& m = mosquitoes;
+    expireCorpses(2, waterBowlVisible ? 2 : 1, true); // Corpses running out spawn a replacement
+    // Empty slots top the population back up to minAlive
+    size_t empty = m.capacity() - m.count() - m.corpses.size();
+    for (size_t e = 0; e < empty && totalAlive < cfg.minAlive; ++e) spawnOneMosquito(false);
+}
+
+// ---------------- Corpse countdowns ----------------
+inline void World::addCorpse(float x, float y, int ticks) {
+    uint32_t t;
+    if (freeCorpseTimers.empty()) {
+        t = (uint32_t)corpseTimers.size();
+        corpseTimers.push_back(CorpseTimer());
+        corpseTimers[t].generation = 0;
+    } else {
+        t = freeCorpseTimers.back();
+        freeCorpseTimers.pop_back();
+    }
+    CorpseTimer& ct = corpseTimers[t];
+    ct.clock = isNearPondArea(x, y) ? CLOCK_NEAR_POND : CLOCK_ELSEWHERE;
+    ct.deadline = corpseWheels[ct.clock].now() + (ticks > 0 ? ticks : 0);
+    ct.corpse = (uint32_t)mosquitoes.corpses.size();
+    ct.expiring = false;
+    corpseWheels[ct.clock].schedule(ct.deadline, (uint64_t)ct.generation << 32 | t);
+    Corpse c = {x, y, t};
+    mosquitoes.corpses.push_back(c);
+}
+
+// What the old per-corpse deadTimer would read
+inline int World::corpseTicksLeft(size_t c) const {
+    const CorpseTimer& ct = corpseTimers[mosquitoes.corpses[c].timer];
+    return (int)(ct.deadline - corpseWheels[ct.clock].now());
+}
+
+// Swap-remove corpse c and retire its timer
+inline void World::removeCorpse(size_t c) {
+    std::vector<Corpse>& corpses = mosquitoes.corpses;
+    CorpseTimer& ct = corpseTimers[corpses[c].timer];
+    ct.generation++;
+    ct.expiring = false;
+    freeCorpseTimers.push_back(corpses[c].timer);
+    corpses[c] = corpses.back();
+    corpseTimers[corpses[c].timer].corpse = (uint32_t)c;
+    corpses.pop_back();
+}
+
+inline void World::clearCorpses() {
+    mosquitoes.corpses.clear();
+    corpseTimers.clear();
+    freeCorpseTimers.clear();
+    for (TimingWheel& w : corpseWheels) w.clear();
+}
+
+// One countdown pass: advance each clock by its step and remove the corpses
+// that run out. The order matters because a spawn into a full population
+// evicts the last corpse, so removal reproduces the old sweep (ascending
+// index, each hole refilled from the back, expiring corpses moved in from
+// the back removed again) while touching only the expiring corpses.
+inline void World::expireCorpses(int nearPondStep, int elsewhereStep, bool respawn) {
+    std::vector<Corpse>& corpses = mosquitoes.corpses;
+    const int steps[CORPSE_CLOCKS] = {nearPondStep, elsewhereStep};
+    expiring.clear();
+    for (int k = 0; k < CORPSE_CLOCKS; ++k) {
+        corpseWheels[k].advance(corpseWheels[k].now() + steps[k], [&](uint64_t entry) {
+            CorpseTimer& ct = corpseTimers[(uint32_t)entry];
+            if (ct.generation != (uint32_t)(entry >> 32)) return; // Its corpse was evicted
+            ct.expiring = true;
+            expiring.push_back(ct.corpse);
+        });
+    }
+    if (expiring.empty()) return;
+    std::sort(expiring.begin(), expiring.end());
+    for (uint32_t hole : expiring) {
+        if (hole >= corpses.size()) continue; // Already removed from the back
+        while (corpses.size() - 1 > hole && corpseTimers[corpses.back().timer].expiring) {
+            removeCorpse(corpses.size() - 1);
+            if (respawn) spawnOneMosquito(false);
+        }
+        removeCorpse(hole);
+        if (respawn) spawnOneMosquito(false);
+    }
+}
+
+// ---------------- Parallel passes ----------------
+// f(chunk, begin, end) for consecutive chunkSize ranges of [0, n)
+template <class F>
+inline void World::forEachChunk(size_t n, F f) {
+    const size_t chunks = chunksFor(n);
+    auto task = [&](size_t k) { f(k, k * chunkSize, std::min(n, (k + 1) * chunkSize)); };
+    if (pool) {
+        pool->run(chunks, task);
+    } else {
+        for (size_t k = 0; k < chunks; ++k) task(k);
+    }
+}
+
+// ---------------- Spatial queries ----------------
+inline void World::indexMosquitoes() {
+    const Population& m = mosquitoes;
+    mosquitoGrid.build(m.x.data(), m.y.data(), m.count(), -gridExtent, gridExtent, SpatialGrid::sideFor(m.count()));
+    mosquitoGridValid = true;
+}
+
+// Visits every mosquito that may lie in the rectangle; callers do the exact test
+template <class F>
+inline void World::forEachMosquitoIn(float x0, float y0, float x1, float y1, F f) {
+    size_t from = 0;
+    if (mosquitoGridValid) {
+        mosquitoGrid.query(x0, y0, x1, y1, f);
+        from = mosquitoGrid.size(); // Spawned since the build
+    }
+    for (size_t i = from; i < mosquitoes.count(); ++i) f(i);
+}
+
+// Live larvae only; the grid is built straight from the pool's columns
+template <class F>
+inline void World::forEachLarvaIn(float x0, float y0, float x1, float y1, F f) {
+    // Larvae added since the build are scanned; a compaction means a rebuild
+    if (!larvaGridValid || larvaGridLayout != larvae.layout) {
+        larvaGrid.build(larvae.x.data(), larvae.y.data(), larvae.used(), -gridExtent, gridExtent,
+                        SpatialGrid::sideFor(larvae.count()));
+        larvaGridValid = true;
+        larvaGridLayout = larvae.layout;
+    }
+    const unsigned char* alive = larvae.alive.data();
+    larvaGrid.query(x0, y0, x1, y1, [&](size_t i) {
+        if (alive[i]) f(i);
+    });
+    for (size_t i = larvaGrid.size(); i < larvae.used(); ++i) {
+        if (alive[i]) f(i);
+    }
+}
+
+#endif // MOSQUITO_WORLD_H
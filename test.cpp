@@ -7,6 +7,13 @@
 #include <algorithm>
 #include <cstring>
 #include <random>
+#include "InputLog.h"
+#include "MosquitoInstancer.h"
+#include "Particles.h"
+#include "SimClock.h"
+#include "Snapshot.h"
+#include "UnitCircle.h"
+#include "World.h"
 #include <cmath>  // For sin/cos in ripples
 #include <cstdlib>  // For rand() and RAND_MAX
 #include <cstdio>  // For sprintf (add if not present)
@@ -20,97 +27,38 @@
 #endif
 
 // --- Constants ---
-#define NUM_MOSQUITOES 50
-#define MAX_LARVAE 100
 #define WINDOW_W 1024
 #define WINDOW_H 768
-#define POPUP_DURATION 150
-#define MAX_SPRAY_CHARGES 5
-#define RAIN_DURATION 500
-#define RAIN_SPAWN_COUNT 3
-#define WIND_DURATION 600
-#define FOG_DURATION 400
-#define CLEANUP_DURATION 1000
-#define SPAWN_INTERVAL_NORMAL 100
-#define SPAWN_INTERVAL_HIGH 60
+#define POPUP_DURATION 150 // Rendered frames
 #define NUM_RAINDROPS 50
-
-// World positions
-#define POND_X 0.0f
-#define POND_Y -0.2f
-#define POND_RX 0.4f
-#define POND_RY 0.2f
+#define MAX_PARTICLES 1024 // Spray mist, rain and kill bursts together
+#define FRAME_MILLIS 16 // Redraw interval; the simulation runs on simClock
 
 // Menu options
 #define MENU_RESTART 1
 #define MENU_TOGGLE_BOWL 2
 #define MENU_TRIGGER_RAIN 3
 #define MENU_EXIT 4
+#define MENU_SAVE 5
+#define MENU_LOAD 6
+#define SNAPSHOT_FILE "mosquito.snap"
+#define INPUT_LOG_FILE "mosquito.input" // Every input, for Headless --replay
 
 // --- Structures ---
-struct Mosquito {
-    float x, y, z;
-    float dx, dy;
-    float size;
-    bool alive;
-    int deadTimer;
-    bool attractedToPond;
-    int pondTime;
-};
-
-struct Larva {
-    float x;      // Position x
-    float y;      // Position y
-    float size;   // Visual/collision size
-    int timer;    // Frame counter for logic (e.g., growth)
-    bool alive;   // Flag for active state
-
-    // Optional constructor for safe initialization
-    Larva(float px = 0.0f, float py = 0.0f, float ps = 0.01f, int pt = 0, bool pa = true)
-        : x(px), y(py), size(ps), timer(pt), alive(pa) {}
-};
-
-struct Raindrop {
-    float x, y, z;
-    float speed;
-};
+// Mosquito, Larva and the simulation rules live in World.h
 
 // --- Global Variables ---
-Mosquito mosquitoes[NUM_MOSQUITOES];
-std::vector<Larva> larvae;
-Raindrop rain[NUM_RAINDROPS];
+World world(WorldConfig::arcade(), std::random_device{}());
+SimClock simClock(world.cfg.tickMillis); // Fixed-dt ticks, independent of the frame rate
+InputQueue inputs; // User input, applied and logged at tick boundaries
+ParticleSystem particles(MAX_PARTICLES); // Cosmetic only, never part of world
           // For cylinders/cones
 float g_treeSwayAngle = 5.0f;
 
-int totalAlive = 0;
-int totalKilled = 0;
-int spawnCounter = 0;
-int currentSpawnInterval = SPAWN_INTERVAL_NORMAL;
-int difficultyTimer = 0;
-
-
-// --- Global State & Constants ---
-
-// Spray variables
-bool spraying = false;
-float sprayX, sprayY, sprayRadius;
-int sprayTimer = 0;
-int sprayCharges = MAX_SPRAY_CHARGES;
-
-// Environmental variables
+// Environmental variables (cosmetic; the weather itself is in world)
 bool dayTime = true;
-bool waterBowlVisible = true;
-float waterBowlX = 0.5f, waterBowlY = 0.0f, waterBowlRadius = 0.1f;
 bool draggingBowl = false;
-int rainTimer = 0;
-bool rainActive = false;
-int windTimer = 0;
-bool windActive = false;
-float windForce = 0.0f;
 float treeSwayAngle = 0.0f;
-int fogTimer = 0;
-bool fogActive = false;
-int cleanupTimer = 0;
 float cloudOffset = 0.0f; 
 
 // Popup
@@ -128,16 +76,16 @@ int windowHeight = WINDOW_H;
 int killedHistory[HISTOGRAM_SIZE] = {0};
 int historyIndex = 0;
 
-// Random number generator
+// Random number generator (cosmetic only; the simulation has its own)
 std::mt19937 rng(std::random_device{}());
 
 // --- Function Declarations ---
-void spawnOneMosquito(bool pondBoost);
-void checkSprayCollisions(int& killedThisFrame);
 void doSpray(float x, float y);
+void handleInput(const InputEvent& e);
 void updateHistogram(int killedCount);
 void initializeMosquitoes();
-void initializeRain();
+void emitRain();
+void emitBurst(float x, float y, int kills);
 float randFloat(float min, float max);
 void checkGLError(const char* func);
 void displayText(float x, float y, const char* text, void* font);
@@ -146,6 +94,7 @@ void drawCircle(float cx, float cy, float cz, float r, int segments);
 void drawLarva(float x, float y, float size);
 void drawCloud(float x, float y);
 void drawRain();
+void drawParticles();
 void drawPond();
 void drawWaterBowl();
 void drawWindEffect();
@@ -153,7 +102,7 @@ void drawFog();
 void drawHistogram();
 float screenToWorldX(int x, int w);
 float screenToWorldY(int y, int h);
-void updateMosquitoesLogic();
+void handleSimEvent(const SimEvent& e);
 void displayUI();
 void displayInstructions();
 void displayPopup();
@@ -181,36 +130,30 @@ void checkGLError(const char* func) {
 }
 
 void initializeMosquitoes() {
-    totalAlive = 0;
-    totalKilled = 0;
-    spawnCounter = 0;
-    currentSpawnInterval = SPAWN_INTERVAL_NORMAL;
-    difficultyTimer = 0;
-    spraying = false;
-    sprayCharges = MAX_SPRAY_CHARGES;
-    waterBowlVisible = true;
-    waterBowlX = 0.5f;
-    waterBowlY = 0.0f;
-    rainActive = false;
-    windActive = false;
-    fogActive = false;
-    cleanupTimer = 0;
-    larvae.clear();
-    for (int i = 0; i < NUM_MOSQUITOES; ++i) {
-        mosquitoes[i].alive = false;
-        mosquitoes[i].deadTimer = 0;
-    }
+    world.reset(rng());
     for (int i = 0; i < HISTOGRAM_SIZE; ++i) killedHistory[i] = 0;
     historyIndex = 0;
-    for (int i = 0; i < 5; ++i) spawnOneMosquito(true);
 }
 
-void initializeRain() {
-    for (int i = 0; i < NUM_RAINDROPS; ++i) {
-        rain[i].x = randFloat(-1.0f, 1.0f);
-        rain[i].y = randFloat(-1.0f, 1.0f);
-        rain[i].z = randFloat(-1.0f, 1.0f);
-        rain[i].speed = randFloat(0.01f, 0.03f);
+// Keep NUM_RAINDROPS falling while it rains; a fresh shower starts spread
+// over the whole sky, later drops enter at the top
+void emitRain() {
+    bool fresh = particles.count(PARTICLE_RAIN) == 0;
+    while (particles.count(PARTICLE_RAIN) < NUM_RAINDROPS) {
+        float y = fresh ? randFloat(-1.0f, 1.0f) : 1.0f;
+        float speed = randFloat(0.01f, 0.03f);
+        if (!particles.emit(PARTICLE_RAIN, randFloat(-1.0f, 1.0f), y, 0.0f, -speed, (y + 1.0f) / speed + 1.0f, 0.5f))
+            break;
+    }
+}
+
+// A few droplets flying out of the spray for each kill
+void emitBurst(float x, float y, int kills) {
+    int count = std::min(kills * 6, 60);
+    for (int i = 0; i < count; ++i) {
+        float angle = randFloat(0.0f, 2.0f * 3.1415926f);
+        float speed = randFloat(0.002f, 0.006f);
+        particles.emit(PARTICLE_BURST, x, y, cosf(angle) * speed, sinf(angle) * speed, randFloat(20.0f, 40.0f));
     }
 }
 
@@ -238,111 +181,48 @@ void displayText(float x, float y, const char* text, void* font = GLUT_BITMAP_HE
 void drawCircle(float cx, float cy, float cz, float r, int segments) {
     glPushMatrix();
     glTranslatef(cx, cy, cz);
+    const float* t = unitCircle(segments);
     glBegin(GL_TRIANGLE_FAN);
     glVertex3f(0.0f, 0.0f, 0.0f);
     for (int i = 0; i <= segments; i++) {
-        float angle = i * 2.0f * 3.1415926f / segments;
-        glVertex3f(cosf(angle) * r, sinf(angle) * r, 0.0f);
+        glVertex3f(t[2 * i] * r, t[2 * i + 1] * r, 0.0f);
     }
     glEnd();
     glPopMatrix();
 }
 
-void drawMosquito(float x, float y, float z, float size, float r, float g, float b, bool bloodFed = false) {
-    GLUquadricObj* quadric = gluNewQuadric();
-    gluQuadricDrawStyle(quadric, GLU_FILL);  // Use GLU_LINE for wireframe if desired
-
-    glPushMatrix();
-    glTranslatef(x, y, z);
-
-    // Thorax (central body part, ellipsoid shape)
-    glPushMatrix();
-    glColor3f(r * 0.8f, g * 0.8f, b * 0.8f);  // Slightly darker for thorax
-    glScalef(size * 0.15f, size * 0.1f, size * 0.1f);  // Elongate slightly
-    glutSolidSphere(1.0f, 12, 12);
-    glPopMatrix();
-
-    // Head (small sphere attached to thorax)
-    glPushMatrix();
-    glTranslatef(size * 0.15f, 0.0f, 0.0f);  // Position in front of thorax
-    glColor3f(r * 0.5f, g * 0.5f, b * 0.5f);  // Dark head
-    glutSolidSphere(size * 0.08f, 10, 10);
-    glPopMatrix();
-
-    // Proboscis (thin cylinder extending from head)
-    glPushMatrix();
-    glTranslatef(size * 0.23f, 0.0f, 0.0f);
-    glRotatef(90.0f, 0.0f, 1.0f, 0.0f);  // Align along x-axis
-    glColor3f(r * 0.3f, g * 0.3f, b * 0.3f);  // Dark proboscis
-    gluCylinder(quadric, size * 0.01f, size * 0.005f, size * 0.1f, 8, 1);  // Tapered
-    glPopMatrix();
-
-    // Antennae (two thin cylinders from head)
-    for (int i = -1; i <= 1; i += 2) {
-        glPushMatrix();
-        glTranslatef(size * 0.15f, size * 0.05f * i, size * 0.05f);
-        glRotatef(45.0f, 0.0f, 0.0f, 1.0f);  // Angle outward
-        glColor3f(r * 0.4f, g * 0.4f, b * 0.4f);
-        gluCylinder(quadric, size * 0.005f, size * 0.002f, size * 0.12f, 6, 1);
-        glPopMatrix();
-    }
-
-    // Abdomen (elongated, cylinder or scaled sphere; red if blood-fed)
-    glPushMatrix();
-    glTranslatef(-size * 0.15f, 0.0f, 0.0f);  // Behind thorax
-    if (bloodFed) {
-        glColor3f(1.0f, 0.0f, 0.0f);  // Red for blood-fed
-    } else {
-        glColor3f(r, g, b);
-    }
-    glScalef(size * 0.2f, size * 0.08f, size * 0.08f);  // Elongated
-    glutSolidSphere(1.0f, 12, 12);
-    glPopMatrix();
-
-    // Wings (two semi-transparent triangles)
-    for (int i = -1; i <= 1; i += 2) {
-        glPushMatrix();
-        glTranslatef(0.0f, size * 0.05f * i, size * 0.05f);
-        glRotatef(30.0f * i, 1.0f, 0.0f, 0.0f);  // Fan out
-        glColor4f(1.0f, 1.0f, 1.0f, 0.6f);  // Semi-transparent white
-        glBegin(GL_TRIANGLES);
-        glVertex3f(0.0f, 0.0f, 0.0f);
-        glVertex3f(size * 0.3f, size * 0.1f, 0.0f);
-        glVertex3f(0.0f, size * 0.2f, 0.0f);
-        glEnd();
-        glPopMatrix();
+// --- Cached Meshes ---
+// Mosquito and larva geometry is tessellated once, at unit size, into display
+// lists by buildMeshes(); drawing one is then a transform and a glCallList.
+// Where the GL allows it, all mosquitoes are instead one instanced call
+// (MosquitoInstancer.h).
+GLuint mosquitoList[2] = {0, 0}; // Plain, blood-fed
+GLuint larvaList = 0;
+MosquitoInstancer mosquitoInstancer;
+bool instancing = false;
+
+void compileMesh(GLuint list, const std::vector<MeshVertex>& mesh) {
+    glNewList(list, GL_COMPILE);
+    glBegin(GL_TRIANGLES);
+    for (const MeshVertex& v : mesh) {
+        glColor4f(v.r, v.g, v.b, v.a);
+        glNormal3f(v.nx, v.ny, v.nz);
+        glVertex3f(v.x, v.y, v.z);
     }
-
-    // Legs (six simple cylinders)
-    float legAngles[3] = {-45.0f, 0.0f, 45.0f};  // Front, mid, hind positions
-    for (int leg = 0; leg < 3; ++leg) {
-        for (int side = -1; side <= 1; side += 2) {
-            glPushMatrix();
-            glTranslatef(size * (0.05f - leg * 0.1f), size * 0.05f * side, 0.0f);
-            glRotatef(legAngles[leg], 0.0f, 0.0f, 1.0f);  // Angle legs
-            glColor3f(r * 0.6f, g * 0.6f, b * 0.6f);
-            gluCylinder(quadric, size * 0.01f, size * 0.005f, size * 0.3f, 6, 1);
-            glPopMatrix();
-        }
-    }
-
-    gluDeleteQuadric(quadric);
-    glPopMatrix();
+    glEnd();
+    glEndList();
 }
 
-void drawLarva(float x, float y, float size) {
-    GLUquadricObj* quadric = gluNewQuadric();
-    gluQuadricDrawStyle(quadric, GLU_FILL);
-
+void compileLarva(GLuint list, GLUquadricObj* quadric) {
+    glNewList(list, GL_COMPILE);
     glPushMatrix();
-    glTranslatef(x, y, 0.0f);  // Center at (x, y, 0); adjust z as needed
     glRotatef(-90.0f, 1.0f, 0.0f, 0.0f);  // Orient vertically, head "down"
 
     // Head (small sphere, darker)
     glPushMatrix();
-    glTranslatef(0.0f, size * 0.1f, 0.0f);
+    glTranslatef(0.0f, 0.1f, 0.0f);
     glColor4f(0.4f, 0.3f, 0.2f, 0.8f);  // Semi-transparent brown
-    glutSolidSphere(size * 0.05f, 10, 10);
+    glutSolidSphere(0.05f, 10, 10);
     glPopMatrix();
 
     // Mouth brushes (simplified as lines fanning out from head)
@@ -351,74 +231,119 @@ void drawLarva(float x, float y, float size) {
     glBegin(GL_LINES);
     for (int i = 0; i < 6; ++i) {
         float angle = i * 60.0f * 3.14159f / 180.0f;
-        glVertex3f(0.0f, size * 0.1f, 0.0f);
-        glVertex3f(size * 0.03f * sin(angle), size * 0.1f + size * 0.05f, size * 0.03f * cos(angle));
+        glVertex3f(0.0f, 0.1f, 0.0f);
+        glVertex3f(0.03f * sin(angle), 0.15f, 0.03f * cos(angle));
     }
     glEnd();
 
     // Antennae (two thin cylinders from head)
     for (int side = -1; side <= 1; side += 2) {
         glPushMatrix();
-        glTranslatef(size * 0.03f * side, size * 0.1f, 0.0f);
+        glTranslatef(0.03f * side, 0.1f, 0.0f);
         glRotatef(45.0f * side, 0.0f, 0.0f, 1.0f);
         glColor4f(0.4f, 0.3f, 0.2f, 0.8f);
-        gluCylinder(quadric, size * 0.005f, size * 0.002f, size * 0.08f, 6, 1);
+        gluCylinder(quadric, 0.005f, 0.002f, 0.08f, 6, 1);
         glPopMatrix();
     }
 
     // Thorax (ellipsoid, wider)
     glPushMatrix();
     glTranslatef(0.0f, 0.0f, 0.0f);
-    glScalef(size * 0.08f, size * 0.15f, size * 0.08f);  // Elongated along y
+    glScalef(0.08f, 0.15f, 0.08f);  // Elongated along y
     glColor4f(0.5f, 0.4f, 0.3f, 0.7f);
     glutSolidSphere(1.0f, 12, 12);
     glPopMatrix();
 
     // Abdomen (8 tapered cylinder segments)
-    float segmentLength = size * 0.05f;
-    float currentY = -size * 0.1f;  // Start after thorax
+    float segmentLength = 0.05f;
+    float currentY = -0.1f;  // Start after thorax
     for (int seg = 0; seg < 8; ++seg) {
         glPushMatrix();
         glTranslatef(0.0f, currentY, 0.0f);
         glColor4f(0.6f + seg * 0.05f, 0.5f + seg * 0.05f, 0.4f, 0.7f);  // Lighten slightly toward tail
-        gluCylinder(quadric, size * (0.04f - seg * 0.002f), size * (0.035f - seg * 0.002f), segmentLength, 8, 1);
+        gluCylinder(quadric, 0.04f - seg * 0.002f, 0.035f - seg * 0.002f, segmentLength, 8, 1);
         currentY -= segmentLength;
         glPopMatrix();
     }
 
     // Siphon (thin cylinder at rear)
     glPushMatrix();
-    glTranslatef(0.0f, currentY - size * 0.05f, 0.0f);
+    glTranslatef(0.0f, currentY - 0.05f, 0.0f);
     glColor4f(0.3f, 0.2f, 0.1f, 0.8f);  // Darker tube
-    gluCylinder(quadric, size * 0.01f, size * 0.005f, size * 0.1f, 6, 1);
+    gluCylinder(quadric, 0.01f, 0.005f, 0.1f, 6, 1);
     glPopMatrix();
 
     // Optional lateral hairs (simplified lines along abdomen)
     glColor4f(0.3f, 0.3f, 0.3f, 0.5f);
     glBegin(GL_LINES);
     for (int seg = 1; seg < 8; seg += 2) {
-        float hairY = -size * 0.1f - seg * segmentLength;
+        float hairY = -0.1f - seg * segmentLength;
         for (int side = -1; side <= 1; side += 2) {
-            glVertex3f(size * 0.03f * side, hairY, 0.0f);
-            glVertex3f(size * 0.05f * side, hairY - size * 0.02f, 0.0f);
+            glVertex3f(0.03f * side, hairY, 0.0f);
+            glVertex3f(0.05f * side, hairY - 0.02f, 0.0f);
         }
     }
     glEnd();
+    glPopMatrix();
+    glEndList();
+}
 
+// Needs a current GL context; called from initGL()
+void buildMeshes() {
+    GLUquadricObj* quadric = gluNewQuadric();
+    gluQuadricDrawStyle(quadric, GLU_FILL);
+    GLuint base = glGenLists(3);
+    mosquitoList[0] = base;
+    mosquitoList[1] = base + 1;
+    larvaList = base + 2;
+    std::vector<MeshVertex> plain = mosquitoMesh(0.5f, 0.3f, 0.1f, false);
+    std::vector<MeshVertex> fed = mosquitoMesh(0.5f, 0.3f, 0.1f, true);
+    compileMesh(mosquitoList[0], plain);
+    compileMesh(mosquitoList[1], fed);
+    compileLarva(larvaList, quadric);
     gluDeleteQuadric(quadric);
+    instancing = mosquitoInstancer.init(plain, fed);
+    printf("initGL: %s mosquitoes\n", instancing ? "Instanced" : "Display-list");
+}
+
+void drawMosquito(float x, float y, float z, float size, bool bloodFed = false) {
+    glPushMatrix();
+    glTranslatef(x, y, z);
+    glScalef(size, size, size);
+    glCallList(mosquitoList[bloodFed ? 1 : 0]);
+    glPopMatrix();
+}
+
+void drawLarva(float x, float y, float size) {
+    glPushMatrix();
+    glTranslatef(x, y, 0.0f);
+    glScalef(size, size, size);
+    glCallList(larvaList);
+    glPopMatrix();
+}
+
+void drawPond() {
+    const WorldConfig& c = world.cfg;
+    glPushMatrix();
+    glTranslatef(c.pondX, c.pondY, 0.0f);
+    glScalef(1.0f, c.pondRadiusY / c.pondRadiusX, 1.0f);  // Ellipse from a circle
+    glColor3f(0.25f, 0.45f, 0.25f);  // Muddy bank
+    drawCircle(0.0f, 0.0f, 0.0f, c.pondRadiusX * 1.08f, 48);
+    glColor3f(0.2f, 0.5f, 0.85f);  // Water
+    drawCircle(0.0f, 0.0f, 0.0f, c.pondRadiusX, 48);
     glPopMatrix();
 }
 
 void drawWaterBowl() {
-    if (!waterBowlVisible) return;
+    if (!world.waterBowlVisible) return;
     glColor3f(0.45f, 0.22f, 0.07f);  // Brown bowl
-    drawCircle(waterBowlX, waterBowlY, 0.0f, waterBowlRadius, waterBowlRadius, 32);
+    drawCircle(world.waterBowlX, world.waterBowlY, 0.0f, world.cfg.bowlRadius, 32);
     glColor3f(0.4f, 0.75f, 0.95f);  // Blue water
-    drawCircle(waterBowlX, waterBowlY, 0.0f, waterBowlRadius * 0.8f, waterBowlRadius * 0.8f, 32);
+    drawCircle(world.waterBowlX, world.waterBowlY, 0.0f, world.cfg.bowlRadius * 0.8f, 32);
 }
 
 void drawWindEffect() {
-    if (!windActive) return;
+    if (!world.windActive) return;
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     glColor4f(0.9f, 0.9f, 0.9f, 0.3f);  // Translucent white lines for wind
@@ -427,14 +352,14 @@ void drawWindEffect() {
         float x = randFloat(-1.0f, 1.0f);
         float y = randFloat(-1.0f, 1.0f);
         glVertex2f(x, y);
-        glVertex2f(x + windForce * 10.0f, y);
+        glVertex2f(x + world.windForce * 10.0f, y);
     }
     glEnd();
     glDisable(GL_BLEND);
 }
 
 void drawFog() {
-    if (!fogActive) return;
+    if (!world.fogActive) return;
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     glColor4f(0.7f, 0.7f, 0.7f, 0.5f);  // Gray fog overlay
@@ -557,19 +482,39 @@ void drawCloud(float x, float y) {
     glPopMatrix();
 }
 
+// Drops keep falling out of the sky after the rain stops
 void drawRain() {
-    if (!rainActive) return;
+    if (particles.count(PARTICLE_RAIN) == 0) return;
     glColor4f(0.5f, 0.7f, 1.0f, 0.7f);
     glLineWidth(1.5f);
     glBegin(GL_LINES);
-    for (int i = 0; i < NUM_RAINDROPS; ++i) {
-        glVertex3f(rain[i].x, rain[i].y, 0.0f);
-        glVertex3f(rain[i].x - windForce * 0.1f, rain[i].y + 0.02f, 0.0f);
+    for (size_t i = 0; i < particles.count(); ++i) {
+        if (particles.kind[i] != PARTICLE_RAIN) continue;
+        glVertex3f(particles.x[i], particles.y[i], 0.0f);
+        glVertex3f(particles.x[i] - world.windForce * 0.1f, particles.y[i] + 0.02f, 0.0f);
     }
     glEnd();
     glLineWidth(1.0f);
 }
 
+// Spray mist and kill bursts, fading out over their life
+void drawParticles() {
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glPointSize(3.0f);
+    glBegin(GL_POINTS);
+    for (size_t i = 0; i < particles.count(); ++i) {
+        float alpha = particles.life[i] * particles.fade[i];
+        if (particles.kind[i] == PARTICLE_MIST) glColor4f(0.1f, 0.6f, 1.0f, alpha * 0.8f);
+        else if (particles.kind[i] == PARTICLE_BURST) glColor4f(0.3f, 0.2f, 0.1f, alpha);
+        else continue;
+        glVertex3f(particles.x[i], particles.y[i], 0.0f);
+    }
+    glEnd();
+    glPointSize(1.0f);
+    glDisable(GL_BLEND);
+}
+
 
 
 
@@ -701,35 +646,181 @@ void drawHistogram() {
     glDisable(GL_DEPTH_TEST);
 }
 
+// --- Baked Scenery ---
+// The parts of the backdrop that never animate are compiled once into
+// display lists: a sky gradient and a horizon layer (haze by day; the milky
+// band and night mountains by night) for each dayTime, and the ground with
+// the pond. The sun, moon, stars, day mountains and clouds move, so display()
+// draws them live between the lists, in the original order. The ground is
+// rebaked when a loaded snapshot moves the pond.
+//
+// The night stars are placed once into a vertex array; twinkling only
+// rewrites their colour array each frame.
+GLuint skyList[2] = {0, 0};     // Night, day
+GLuint horizonList[2] = {0, 0}; // Night, day
+GLuint groundList = 0;
+float bakedPond[4] = {0.0f, 0.0f, 0.0f, 0.0f}; // pondX, pondY, pondRadiusX, pondRadiusY; none yet
+const int STAR_COUNT = 280;
+std::vector<float> starVertices; // x, y, z per star
+std::vector<float> starColours;  // r, g, b, a per star
+
+void drawSky(bool day) {
+    if (day) {
+        // Day gradient
+        glBegin(GL_QUADS);
+        glColor3f(0.08f, 0.45f, 0.85f); glVertex3f(-10.0f, 10.0f, -9.5f);
+        glColor3f(0.18f, 0.66f, 0.92f); glVertex3f(10.0f, 10.0f, -9.5f);
+        glColor3f(0.95f, 0.98f, 0.99f); glVertex3f(10.0f, -1.2f, -9.5f);
+        glColor3f(0.88f, 0.95f, 0.98f); glVertex3f(-10.0f, -1.2f, -9.5f);
+        glEnd();
+    } else {
+        // Night gradient
+        glBegin(GL_QUADS);
+        glColor3f(0.02f, 0.04f, 0.18f); glVertex3f(-10.0f, 10.0f, -9.5f);
+        glColor3f(0.05f, 0.08f, 0.28f); glVertex3f(10.0f, 10.0f, -9.5f);
+        glColor3f(0.08f, 0.10f, 0.18f); glVertex3f(10.0f, -1.2f, -9.5f);
+        glColor3f(0.03f, 0.06f, 0.12f); glVertex3f(-10.0f, -1.2f, -9.5f);
+        glEnd();
+    }
+}
+
+void drawHorizon(bool day) {
+    if (day) {
+        // Atmospheric haze
+        for (int layer = 0; layer < 3; ++layer) {
+            float h = -0.9f + layer * 0.08f;
+            float alpha = 0.06f * (1.0f - layer * 0.25f);
+            glColor4f(1.0f, 0.86f, 0.6f, alpha);
+            glBegin(GL_QUADS);
+            glVertex3f(-10.0f, h - 0.05f, -9.4f);
+            glVertex3f(10.0f, h - 0.05f, -9.4f);
+            glVertex3f(10.0f, h + 0.12f, -9.4f);
+            glVertex3f(-10.0f, h + 0.12f, -9.4f);
+            glEnd();
+        }
+    } else {
+        // Milky band
+        glColor4f(0.9f, 0.9f, 0.98f, 0.035f);
+        glBegin(GL_QUADS);
+        glVertex3f(-10.0f, 0.15f, -9.3f);
+        glVertex3f(10.0f, 0.15f, -9.3f);
+        glVertex3f(10.0f, -0.05f, -9.3f);
+        glVertex3f(-10.0f, -0.05f, -9.3f);
+        glEnd();
+        // Night mountains
+        glColor3f(0.02f, 0.02f, 0.04f);
+        glBegin(GL_TRIANGLE_STRIP);
+        glVertex3f(-1.2f, -0.2f, -9.1f);
+        for (float x = -1.2f; x <= 1.2f; x += 0.08f) {
+            float peak = 0.08f * (0.5f + 0.5f * sinf(3.0f * x + 0.6f));
+            glVertex3f(x, -0.2f + peak, -9.1f);
+            glVertex3f(x, -1.2f, -9.1f);
+        }
+        glEnd();
+    }
+}
+
+void drawGround() {
+    glBegin(GL_QUADS);
+    glColor3f(0.3f, 0.6f, 0.3f);
+    glVertex3f(-1, -1, -0.1f);
+    glVertex3f(1, -1, -0.1f);
+    glVertex3f(1, -0.5f, -0.1f);
+    glVertex3f(-1, -0.5f, -0.1f);
+    glEnd();
+    drawPond();
+}
+
+// Needs a current GL context; called from initGL()
+void buildScenery() {
+    GLuint base = glGenLists(5);
+    for (int day = 0; day < 2; ++day) {
+        skyList[day] = base + day;
+        horizonList[day] = base + 2 + day;
+        glNewList(skyList[day], GL_COMPILE);
+        drawSky(day == 1);
+        glEndList();
+        glNewList(horizonList[day], GL_COMPILE);
+        drawHorizon(day == 1);
+        glEndList();
+    }
+    groundList = base + 4;
+    std::mt19937 sr(424242);
+    std::uniform_real_distribution<float> sx(-1.1f, 1.1f), sy(0.0f, 1.05f);
+    starVertices.clear();
+    starColours.assign(STAR_COUNT * 4, 0.8f); // Alpha stays 0.8
+    for (int i = 0; i < STAR_COUNT; ++i) {
+        float x = sx(sr);
+        float y = sy(sr);
+        starVertices.insert(starVertices.end(), {x, y, -9.2f});
+    }
+}
+
+void drawStars(float time) {
+    for (int i = 0; i < STAR_COUNT; ++i) {
+        float tw = 0.5f + 0.5f * sinf(time * 2.0f + (float)i * 0.13f);
+        float bright = 0.6f + 0.4f * tw;
+        float* c = &starColours[i * 4];
+        c[0] = 0.95f * bright;
+        c[1] = 0.95f * bright;
+        c[2] = 1.0f * bright;
+    }
+    glPointSize(1.8f);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, starVertices.data());
+    glColorPointer(4, GL_FLOAT, 0, starColours.data());
+    glDrawArrays(GL_POINTS, 0, STAR_COUNT);
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glPointSize(1.0f);
+}
+
+void bakeGround() {
+    const WorldConfig& c = world.cfg;
+    float pond[4] = {c.pondX, c.pondY, c.pondRadiusX, c.pondRadiusY};
+    if (!memcmp(pond, bakedPond, sizeof(pond))) return;
+    glNewList(groundList, GL_COMPILE);
+    drawGround();
+    glEndList();
+    memcpy(bakedPond, pond, sizeof(pond));
+}
+
 // --- Logic Helpers ---
+// Beep on Windows, log the cue elsewhere
+void audioCue(int freq, int ms, const char* label) {
+    if (simClock.warp != 1.0) return; // Silent while fast-forwarding
+    #ifdef _WIN32
+    Beep(freq, ms);
+    (void)label;
+    #else
+    (void)freq; (void)ms;
+    fprintf(stderr, "Audio: %s\n", label);
+    #endif
+}
+
 void doSpray(float x, float y) {
-    if (sprayCharges <= 0) {
+    inputs.push(world, INPUT_SPRAY, x, y);
+}
+
+// Popup, sound and particles for a spray once the world has applied it
+void showSpray(const InputEvent& e) {
+    if (!e.accepted) {
         snprintf(popupText, sizeof(popupText), "No spray charges left!");
         popupTimer = POPUP_DURATION;
-        #ifdef _WIN32
-        Beep(350, 150);
-        #else
-        fprintf(stderr, "Audio: No spray charges left!\n");
-        #endif
+        audioCue(350, 150, "No spray charges left!");
         return;
     }
-    spraying = true;
-    sprayX = x;
-    sprayY = y;
-    sprayRadius = 0.2f;
-    sprayTimer = 30;
-    sprayCharges--;
-    
-    // Add visual particles for spray effect
+
+    // Mist drifting out of the nozzle ring (cosmetic, not larvae)
     for (int i = 0; i < 8; ++i) {
         float angle = i * 2.0f * 3.1415926f / 8.0f;
-        float px = x + cosf(angle) * 0.08f;
-        float py = y + sinf(angle) * 0.08f;
-        Larva particle = {px, py, 0.005f, 0};
-        larvae.push_back(particle);
+        float px = e.x + cosf(angle) * 0.08f;
+        float py = e.y + sinf(angle) * 0.08f;
+        particles.emit(PARTICLE_MIST, px, py, cosf(angle) * 0.002f, sinf(angle) * 0.002f, 45.0f);
     }
     
-    snprintf(popupText, sizeof(popupText), "Spraying! Charges left: %d", sprayCharges);
+    snprintf(popupText, sizeof(popupText), "Spraying! Charges left: %d", world.sprayCharges);
     popupTimer = POPUP_DURATION;
     #ifdef _WIN32
     Beep(1100, 150);
@@ -739,317 +830,113 @@ void doSpray(float x, float y) {
     #endif
 }
 
-bool isNearPondArea(float x, float y) {
-    float rx = POND_RX * 1.5f, ry = POND_RY * 2.0f;
-    float nx = (x - POND_X) / rx, ny = (y - POND_Y) / ry;
-    // Check left side and lower area
-    return (nx * nx + ny * ny) <= 1.0f && x < POND_X && y < POND_Y;
-}
-
-bool isNearWaterBowl(float x, float y) {
-    if (!waterBowlVisible) return false;
-    float dx = x - waterBowlX, dy = y - waterBowlY;
-    return sqrtf(dx * dx + dy * dy) <= waterBowlRadius * 1.8f;
-}
-
-void spawnOneMosquito(bool pondBoost) {
-    for (int i = 0; i < NUM_MOSQUITOES; ++i) {
-        if (!mosquitoes[i].alive) {
-            bool useBowl = waterBowlVisible && (randFloat(0.0f, 1.0f) < 0.5f);
-            float angle = randFloat(0.0f, 2.0f * 3.1415926f);
-            if (pondBoost && useBowl) {
-                mosquitoes[i].x = waterBowlX + cosf(angle) * waterBowlRadius * 1.3f;
-                mosquitoes[i].y = waterBowlY + sinf(angle) * waterBowlRadius * 1.3f;
-            } else if (pondBoost) {
-                float rx = POND_RX * 0.95f, ry = POND_RY * 0.95f;
-                mosquitoes[i].x = POND_X + cosf(angle) * rx;
-                mosquitoes[i].y = POND_Y + sinf(angle) * ry;
-            } else {
-                mosquitoes[i].x = randFloat(-0.95f, 0.95f);
-                mosquitoes[i].y = randFloat(-0.95f, 0.95f);
-            }
-            mosquitoes[i].z = randFloat(0.05f, 0.1f);
-            mosquitoes[i].dx = randFloat(-0.005f, 0.005f);
-            mosquitoes[i].dy = randFloat(-0.005f, 0.005f);
-            mosquitoes[i].size = randFloat(0.03f, 0.06f);
-            mosquitoes[i].alive = true;
-            mosquitoes[i].deadTimer = 0;
-            mosquitoes[i].attractedToPond = (randFloat(0.0f, 1.0f) < 0.5f);
-            mosquitoes[i].pondTime = 0;
-            totalAlive++;
-            #ifdef _WIN32
-            Beep(1050, 60);
-            #else
-            fprintf(stderr, "Audio: Mosquito spawned!\n");
-            #endif
-            return;
-        }
-    }
-}
-
-void checkSprayCollisions(int& killedThisFrame) {
-    if (!spraying) return;
-    int killedThisSpray = 0;
-    for (int i = 0; i < NUM_MOSQUITOES; ++i) {
-        if (!mosquitoes[i].alive) continue;
-        float dx = mosquitoes[i].x - sprayX, dy = mosquitoes[i].y - sprayY;
-        float dist = sqrtf(dx * dx + dy * dy);
-        if (dist <= sprayRadius + mosquitoes[i].size * 0.5f) {
-            mosquitoes[i].alive = false;
-            mosquitoes[i].deadTimer = 60 + (int)(randFloat(0.0f, 1.0f) * 40);
-            totalAlive--;
-            totalKilled++;
-            killedThisSpray++;
-            mosquitoes[i].x += randFloat(-0.05f, 0.05f);
-            mosquitoes[i].y += randFloat(-0.05f, 0.05f);
+// Feedback for an input once the world has applied it
+void handleInput(const InputEvent& e) {
+    switch (e.type) {
+        case INPUT_SPRAY:
+        case INPUT_SPRAY_RANDOM:
+            showSpray(e);
+            break;
+        case INPUT_TOGGLE_BOWL:
+            snprintf(popupText, sizeof(popupText), world.waterBowlVisible ?
+                     "Water bowl toggled on!" : "Water bowl toggled off!");
+            popupTimer = POPUP_DURATION;
             #ifdef _WIN32
-            Beep(950, 90);
-            #else
-            fprintf(stderr, "Audio: Mosquito killed!\n");
+            Beep(1050, 200);
             #endif
-        }
-    }
-    for (size_t i = 0; i < larvae.size(); ++i) {
-        float dx = larvae[i].x - sprayX, dy = larvae[i].y - sprayY;
-        float dist = sqrtf(dx * dx + dy * dy);
-        if (dist <= sprayRadius) {
-            larvae.erase(larvae.begin() + i);
-            --i;
-            totalKilled++;
-            killedThisSpray++;
+            break;
+        case INPUT_RAIN:
+            if (e.accepted) {
+                snprintf(popupText, sizeof(popupText),
+                         "Rain event triggered! %d mosquitoes spawned!", world.cfg.rainSpawnCount);
+                popupTimer = POPUP_DURATION;
+                #ifdef _WIN32
+                Beep(550, 350);
+                #endif
+            }
+            break;
+        case INPUT_RESTART:
+            for (int i = 0; i < HISTOGRAM_SIZE; ++i) killedHistory[i] = 0;
+            historyIndex = 0;
+            snprintf(popupText, sizeof(popupText), "Simulation restarted!");
+            popupTimer = POPUP_DURATION;
             #ifdef _WIN32
-            Beep(950, 90);
-            #else
-            fprintf(stderr, "Audio: Larva killed!\n");
+            Beep(1000, 200);
             #endif
-        }
-    }
-    if (killedThisSpray > 0) {
-        killedThisFrame += killedThisSpray;
-        snprintf(popupText, sizeof(popupText), "Spray killed %d mosquitoes/larvae!", killedThisSpray);
-        popupTimer = POPUP_DURATION;
+            break;
     }
 }
 
-void updateMosquitoesLogic() {
-    int killedThisFrame = 0;
-    for (int i = 0; i < NUM_MOSQUITOES; ++i) {
-        if (mosquitoes[i].alive) {
-            if (mosquitoes[i].attractedToPond) {
-                float targetX = POND_X, targetY = POND_Y;
-                if (waterBowlVisible && randFloat(0.0f, 1.0f) < 0.5f) {
-                    targetX = waterBowlX;
-                    targetY = waterBowlY;
-                }
-                float dx = targetX - mosquitoes[i].x, dy = targetY - mosquitoes[i].y;
-                float dist = sqrtf(dx * dx + dy * dy);
-                if (dist > 0.02f) {
-                    float speed = 0.002f;
-                    mosquitoes[i].dx += (dx / dist) * speed;
-                    mosquitoes[i].dy += (dy / dist) * speed;
-                    float speedLimit = 0.008f;
-                    float currentSpeed = sqrtf(mosquitoes[i].dx * mosquitoes[i].dx + mosquitoes[i].dy * mosquitoes[i].dy);
-                    if (currentSpeed > speedLimit) {
-                        mosquitoes[i].dx = (mosquitoes[i].dx / currentSpeed) * speedLimit;
-                        mosquitoes[i].dy = (mosquitoes[i].dy / currentSpeed) * speedLimit;
-                    }
-                }
-            }
-            mosquitoes[i].x += mosquitoes[i].dx + (windActive ? windForce : 0.0f);
-            mosquitoes[i].y += mosquitoes[i].dy;
-            mosquitoes[i].z = 0.05f + 0.05f * sinf((float)glutGet(GLUT_ELAPSED_TIME) * 0.005f);
-            if (mosquitoes[i].x < -0.95f || mosquitoes[i].x > 0.95f) mosquitoes[i].dx = -mosquitoes[i].dx;
-            if (mosquitoes[i].y < -0.95f || mosquitoes[i].y > 0.95f) mosquitoes[i].dy = -mosquitoes[i].dy;
-            if (randFloat(0.0f, 1.0f) * 800 < 10) {
-                mosquitoes[i].dx += randFloat(-0.003f, 0.003f);
-                mosquitoes[i].dy += randFloat(-0.003f, 0.003f);
-            }
-            if ((isNearPondArea(mosquitoes[i].x, mosquitoes[i].y) || isNearWaterBowl(mosquitoes[i].x, mosquitoes[i].y)) && larvae.size() < MAX_LARVAE) {
-                mosquitoes[i].pondTime++;
-                if (mosquitoes[i].pondTime > 150) {
-                    Larva larva = {mosquitoes[i].x + randFloat(-0.03f, 0.03f), mosquitoes[i].y + randFloat(-0.03f, 0.03f), 0.01f, 0};
-                    larvae.push_back(larva);
-                    mosquitoes[i].pondTime = 0;
-                    #ifdef _WIN32
-                    Beep(1150, 120);
-                    #else
-                    fprintf(stderr, "Audio: Larva spawned!\n");
-                    #endif
-                    snprintf(popupText, sizeof(popupText), "Larva spawned in %s!", isNearPondArea(mosquitoes[i].x, mosquitoes[i].y) ? "pond" : "water bowl");
-                    popupTimer = POPUP_DURATION;
-                }
-            } else {
-                mosquitoes[i].pondTime = 0;
-            }
-        } else if (mosquitoes[i].deadTimer > 0) {
-            mosquitoes[i].deadTimer--;
-        }
-    }
-    for (size_t i = 0; i < larvae.size(); ++i) {
-        larvae[i].timer++;
-        larvae[i].size += 0.0001f;
-        if (larvae[i].size > 0.015f) larvae[i].size = 0.015f;
-        if (larvae[i].timer > 350) {
-            spawnOneMosquito(true);
-            larvae.erase(larvae.begin() + i);
-            --i;
-            #ifdef _WIN32
-            Beep(1250, 120);
-            #else
-            fprintf(stderr, "Audio: Larva matured!\n");
-            #endif
+// Turn what the world reported this tick into popups and sounds
+void handleSimEvent(const SimEvent& e) {
+    switch (e.type) {
+        case EVENT_SPRAY_KILLS:
+            for (int i = 0; i < e.count; ++i) audioCue(950, 90, "Killed!");
+            emitBurst(e.x, e.y, e.count);
+            snprintf(popupText, sizeof(popupText), "Spray killed %d mosquitoes/larvae!", e.count);
+            popupTimer = POPUP_DURATION;
+            break;
+        case EVENT_LARVA_SPAWNED:
+            audioCue(1150, 120, "Larva spawned!");
+            snprintf(popupText, sizeof(popupText), "Larva spawned in %s!", world.isNearPondArea(e.x, e.y) ? "pond" : "water bowl");
+            popupTimer = POPUP_DURATION;
+            break;
+        case EVENT_LARVA_MATURED:
+            audioCue(1250, 120, "Larva matured!");
             snprintf(popupText, sizeof(popupText), "Larva matured into mosquito!");
             popupTimer = POPUP_DURATION;
-        }
-    }
-    if (rainActive) {
-        rainTimer--;
-        if (rainTimer <= 0) {
-            rainActive = false;
+            break;
+        case EVENT_RAIN_STOPPED:
             snprintf(popupText, sizeof(popupText), "Rain stopped. Check breeding sites!");
             popupTimer = POPUP_DURATION;
-        }
-        for (int i = 0; i < NUM_RAINDROPS; ++i) {
-            rain[i].y -= rain[i].speed;
-            rain[i].x += windForce * 0.5f;
-            if (rain[i].y < -1.0f) {
-                rain[i].y = 1.0f;
-                rain[i].x = randFloat(-1.0f, 1.0f);
-            }
-        }
-    } else if (randFloat(0.0f, 1.0f) * 900 < 6 && !cleanupTimer) {
-        rainActive = true;
-        rainTimer = RAIN_DURATION;
-        for (int i = 0; i < RAIN_SPAWN_COUNT; ++i) spawnOneMosquito(true);
-        snprintf(popupText, sizeof(popupText), "Rain event! %d mosquitoes spawned!", RAIN_SPAWN_COUNT);
-        popupTimer = POPUP_DURATION;
-        #ifdef _WIN32
-        Beep(550, 350);
-        #else
-        fprintf(stderr, "Audio: Rain event!\n");
-        #endif
-    }
-    if (windActive) {
-        windTimer--;
-        if (windTimer <= 0) windActive = false;
-        treeSwayAngle = sinf((float)windTimer * 0.1f) * 10.0f;
-    } else if (randFloat(0.0f, 1.0f) * 900 < 5 && !cleanupTimer) {
-        windActive = true;
-        windTimer = WIND_DURATION;
-        windForce = randFloat(-0.006f, 0.006f);
-        snprintf(popupText, sizeof(popupText), "Wind event! Mosquitoes shifted %s!", windForce > 0 ? "right" : "left");
-        popupTimer = POPUP_DURATION;
-        #ifdef _WIN32
-        Beep(750, 250);
-        #else
-        fprintf(stderr, "Audio: Wind event!\n");
-        #endif
-    }
-    if (fogActive) {
-        fogTimer--;
-        if (fogTimer <= 0) fogActive = false;
-    } else if (randFloat(0.0f, 1.0f) * 900 < 4 && !cleanupTimer) {
-        fogActive = true;
-        fogTimer = FOG_DURATION;
-        snprintf(popupText, sizeof(popupText), "Fog event! Visibility reduced!");
-        popupTimer = POPUP_DURATION;
-        #ifdef _WIN32
-        Beep(650, 250);
-        #else
-        fprintf(stderr, "Audio: Fog event!\n");
-        #endif
-    }
-    if (cleanupTimer > 0) {
-        cleanupTimer--;
-        if (cleanupTimer <= 0) {
-            currentSpawnInterval = SPAWN_INTERVAL_NORMAL;
+            break;
+        case EVENT_RAIN_STARTED:
+            snprintf(popupText, sizeof(popupText), "Rain event! %d mosquitoes spawned!", e.count);
+            popupTimer = POPUP_DURATION;
+            audioCue(550, 350, "Rain event!");
+            break;
+        case EVENT_WIND_STARTED:
+            snprintf(popupText, sizeof(popupText), "Wind event! Mosquitoes shifted %s!", e.x > 0 ? "right" : "left");
+            popupTimer = POPUP_DURATION;
+            audioCue(750, 250, "Wind event!");
+            break;
+        case EVENT_FOG_STARTED:
+            snprintf(popupText, sizeof(popupText), "Fog event! Visibility reduced!");
+            popupTimer = POPUP_DURATION;
+            audioCue(650, 250, "Fog event!");
+            break;
+        case EVENT_CLEANUP_ENDED:
             snprintf(popupText, sizeof(popupText), "Cleanup ended. Monitor breeding sites!");
             popupTimer = POPUP_DURATION;
-        }
-    } else if (randFloat(0.0f, 1.0f) * 900 < 3 && !rainActive && !windActive && !fogActive) {
-        cleanupTimer = CLEANUP_DURATION;
-        waterBowlVisible = false;
-        larvae.clear();
-        currentSpawnInterval = SPAWN_INTERVAL_NORMAL * 2;
-        snprintf(popupText, sizeof(popupText), "Cleanup campaign! Breeding sites cleared!");
-        popupTimer = POPUP_DURATION;
-        #ifdef _WIN32
-        Beep(1550, 350);
-        #else
-        fprintf(stderr, "Audio: Cleanup event!\n");
-        #endif
-    }
-    if (randFloat(0.0f, 1.0f) * 900 < 3 && !rainActive && !windActive && !fogActive && !cleanupTimer) {
-        int swarmCount = 4 + (int)(randFloat(0.0f, 1.0f) * 4);
-        for (int i = 0; i < swarmCount; ++i) spawnOneMosquito(true);
-        snprintf(popupText, sizeof(popupText), "Mosquito swarm! %d spawned!", swarmCount);
-        popupTimer = POPUP_DURATION;
-        #ifdef _WIN32
-        Beep(1050, 250);
-        #else
-        fprintf(stderr, "Audio: Swarm event!\n");
-        #endif
-    }
-    bool boost = waterBowlVisible || totalAlive > 8 || rainActive || cleanupTimer > 0;
-    int nearPondCount = 0, nearBowlCount = 0;
-    for (int i = 0; i < NUM_MOSQUITOES; ++i) {
-        if (mosquitoes[i].alive) {
-            if (isNearPondArea(mosquitoes[i].x, mosquitoes[i].y)) nearPondCount++;
-            if (isNearWaterBowl(mosquitoes[i].x, mosquitoes[i].y)) nearBowlCount++;
-        }
-    }
-    if (nearPondCount > 3 || nearBowlCount > 2) boost = true;
-    currentSpawnInterval = boost && !cleanupTimer ? SPAWN_INTERVAL_HIGH : SPAWN_INTERVAL_NORMAL;
-    spawnCounter++;
-    if (spawnCounter >= currentSpawnInterval) {
-        spawnOneMosquito(boost);
-        if (randFloat(0.0f, 1.0f) * 100 < 50 && !cleanupTimer) spawnOneMosquito(boost);
-        spawnCounter = 0;
-    }
-    difficultyTimer++;
-    if (difficultyTimer >= 4800) {
-        currentSpawnInterval = std::max(40, currentSpawnInterval - 10);
-        difficultyTimer = 0;
-        snprintf(popupText, sizeof(popupText), "Difficulty increased! Faster mosquito spawns!");
-        popupTimer = POPUP_DURATION;
-        #ifdef _WIN32
-        Beep(1300, 200);
-        #else
-        fprintf(stderr, "Audio: Difficulty increased!\n");
-        #endif
-    }
-    if (spraying) {
-        sprayTimer--;
-        if (sprayTimer <= 0) spraying = false;
-    }
-    if (popupTimer > 0) popupTimer--;
-    cloudOffset += dayTime ? 0.0005f : 0.0002f;
-    if (cloudOffset > 2.0f) cloudOffset = -2.0f;
-    if (totalAlive > 40) {
-        snprintf(popupText, sizeof(popupText), "Game Over! Too many mosquitoes! Restarting...");
-        popupTimer = POPUP_DURATION * 2;
-        initializeMosquitoes();
-        #ifdef _WIN32
-        Beep(300, 500);
-        #else
-        fprintf(stderr, "Audio: Game over!\n");
-        #endif
-    }
-    static int sprayRechargeTimer = 0;
-    sprayRechargeTimer++;
-    if (sprayRechargeTimer >= 600 && sprayCharges < MAX_SPRAY_CHARGES) {
-        sprayCharges++;
-        sprayRechargeTimer = 0;
-        snprintf(popupText, sizeof(popupText), "Spray charge recharged! Charges: %d", sprayCharges);
-        popupTimer = POPUP_DURATION;
-        #ifdef _WIN32
-        Beep(1200, 200);
-        #else
-        fprintf(stderr, "Audio: Spray recharged!\n");
-        #endif
+            break;
+        case EVENT_CLEANUP_STARTED:
+            snprintf(popupText, sizeof(popupText), "Cleanup campaign! Breeding sites cleared!");
+            popupTimer = POPUP_DURATION;
+            audioCue(1550, 350, "Cleanup event!");
+            break;
+        case EVENT_SWARM:
+            snprintf(popupText, sizeof(popupText), "Mosquito swarm! %d spawned!", e.count);
+            popupTimer = POPUP_DURATION;
+            audioCue(1050, 250, "Swarm event!");
+            break;
+        case EVENT_DIFFICULTY_UP:
+            snprintf(popupText, sizeof(popupText), "Difficulty increased! Faster mosquito spawns!");
+            popupTimer = POPUP_DURATION;
+            audioCue(1300, 200, "Difficulty increased!");
+            break;
+        case EVENT_GAME_OVER:
+            snprintf(popupText, sizeof(popupText), "Game Over! Too many mosquitoes! Restarting...");
+            popupTimer = POPUP_DURATION * 2;
+            for (int i = 0; i < HISTOGRAM_SIZE; ++i) killedHistory[i] = 0;
+            historyIndex = 0;
+            audioCue(300, 500, "Game over!");
+            break;
+        case EVENT_SPRAY_REFILLED:
+            snprintf(popupText, sizeof(popupText), "Spray charge recharged! Charges: %d", e.count);
+            popupTimer = POPUP_DURATION;
+            audioCue(1200, 200, "Spray recharged!");
+            break;
     }
-    updateHistogram(killedThisFrame);
-    checkSprayCollisions(killedThisFrame);
 }
 
 // --- UI Display ---
@@ -1086,9 +973,9 @@ void displayUI() {
     displayText(panelL + 0.02f, panelT - 0.04f, "Dengue Awareness", GLUT_BITMAP_HELVETICA_18);
 
     // Key stats
-    snprintf(buf, sizeof(buf), "Alive: %d", totalAlive);
+    snprintf(buf, sizeof(buf), "Alive: %d", world.totalAlive);
     displayText(panelL + 0.02f, panelT - 0.12f, buf);
-    snprintf(buf, sizeof(buf), "Killed: %d", totalKilled);
+    snprintf(buf, sizeof(buf), "Killed: %d", world.totalKilled);
     displayText(panelL + 0.02f, panelT - 0.18f, buf);
 
     // Recent kills (last history slot)
@@ -1098,12 +985,16 @@ void displayUI() {
     displayText(panelL + 0.02f, panelT - 0.24f, buf);
 
     // Spawn rate
-    const char* spawnText = (currentSpawnInterval <= SPAWN_INTERVAL_HIGH ? "High" : "Normal");
+    const char* spawnText = (world.currentSpawnInterval <= world.cfg.spawnIntervalHigh ? "High" : "Normal");
     snprintf(buf, sizeof(buf), "Spawn Rate: %s", spawnText);
     displayText(panelL + 0.02f, panelT - 0.30f, buf);
 
+    // Time warp
+    simClock.formatSpeed(buf, sizeof(buf));
+    displayText(panelL + 0.22f, panelT - 0.12f, buf);
+
     // Water bowl status
-    snprintf(buf, sizeof(buf), "Water Bowl: %s", waterBowlVisible ? "On" : "Off");
+    snprintf(buf, sizeof(buf), "Water Bowl: %s", world.waterBowlVisible ? "On" : "Off");
     displayText(panelL + 0.02f, panelT - 0.36f, buf);
 
     // Spray charges visual bar (segmented)
@@ -1111,10 +1002,10 @@ void displayUI() {
     float barY = panelT - 0.44f;
     displayText(barX, barY + 0.02f, "Spray:");
     float segW = 0.026f, segH = 0.04f, gap = 0.008f;
-    for (int i = 0; i < MAX_SPRAY_CHARGES; ++i) {
+    for (int i = 0; i < world.cfg.maxSprayCharges; ++i) {
         float sx = barX + 0.06f + i * (segW + gap);
         float sy = barY - 0.02f;
-        if (i < sprayCharges) {
+        if (i < world.sprayCharges) {
             // available charge
             glColor4f(0.12f, 0.72f, 0.95f, 0.95f);
         } else {
@@ -1142,36 +1033,36 @@ void displayUI() {
     float dotR = 0.017f;
     auto drawDot = [&](float cx, float cy, float r, float g, float b, bool on){
         if (on) glColor3f(r,g,b); else glColor3f(0.25f,0.25f,0.25f);
+        const float* t = unitCircle(16);
         glBegin(GL_TRIANGLE_FAN);
           glVertex2f(cx, cy);
           for (int a = 0; a <= 16; ++a) {
-            float ang = a * 2.0f * 3.1415926f / 16.0f;
-            glVertex2f(cx + cosf(ang) * dotR, cy + sinf(ang) * dotR);
+            glVertex2f(cx + t[2 * a] * dotR, cy + t[2 * a + 1] * dotR);
           }
         glEnd();
     };
 
     // Rain
-    drawDot(stX + 0.01f, stY + 0.00f, 0.0f, 0.6f, 1.0f, rainActive);
+    drawDot(stX + 0.01f, stY + 0.00f, 0.0f, 0.6f, 1.0f, world.rainActive);
     displayText(stX + 0.05f, stY + 0.0f, "Rain");
     // Wind
-    drawDot(stX + 0.01f, stY - 0.07f, 1.0f, 1.0f, 1.0f, windActive);
+    drawDot(stX + 0.01f, stY - 0.07f, 1.0f, 1.0f, 1.0f, world.windActive);
     displayText(stX + 0.05f, stY - 0.07f, "Wind");
     // Fog
-    drawDot(stX + 0.01f, stY - 0.14f, 0.8f, 0.85f, 0.95f, fogActive);
+    drawDot(stX + 0.01f, stY - 0.14f, 0.8f, 0.85f, 0.95f, world.fogActive);
     displayText(stX + 0.05f, stY - 0.14f, "Fog");
     // Cleanup
-    bool cleaning = (cleanupTimer > 0);
+    bool cleaning = (world.cleanupTimer > 0);
     drawDot(stX + 0.01f, stY - 0.21f, 0.2f, 0.9f, 0.2f, cleaning);
     displayText(stX + 0.05f, stY - 0.21f, "Cleanup");
 
     // Danger indicator if mosquitoes high
     float dangerX = panelR - 0.12f, dangerY = panelT - 0.14f;
-    if (totalAlive > 35) {
+    if (world.totalAlive > 35) {
         // big red warning
         glColor3f(1.0f, 0.2f, 0.2f);
         displayText(dangerX, dangerY, "!!! DANGER !!!", GLUT_BITMAP_HELVETICA_18);
-    } else if (totalAlive > 20) {
+    } else if (world.totalAlive > 20) {
         glColor3f(1.0f, 0.6f, 0.1f);
         displayText(dangerX, dangerY, "High mosquito load", GLUT_BITMAP_HELVETICA_12);
     } else {
@@ -1190,6 +1081,7 @@ void displayInstructions() {
         "R: Toggle Water Bowl",
         "T: Trigger Rain",
         "D: Toggle Day/Night",
+        "F: Fast-Forward (x1/x10/x100/max)",
         "Right-Click & Drag: Move Water Bowl",
         "Right-Click: Menu",
         "ESC: Exit"
@@ -1275,19 +1167,7 @@ void display() {
 
     if (dayTime) {
 
-        // Day gradient
-
-        glBegin(GL_QUADS);
-
-        glColor3f(0.08f, 0.45f, 0.85f); glVertex3f(-10.0f, 10.0f, -9.5f);
-
-        glColor3f(0.18f, 0.66f, 0.92f); glVertex3f(10.0f, 10.0f, -9.5f);
-
-        glColor3f(0.95f, 0.98f, 0.99f); glVertex3f(10.0f, -1.2f, -9.5f);
-
-        glColor3f(0.88f, 0.95f, 0.98f); glVertex3f(-10.0f, -1.2f, -9.5f);
-
-        glEnd();
+        glCallList(skyList[1]);
 
 
 
@@ -1317,29 +1197,7 @@ void display() {
 
 
 
-        // Atmospheric haze
-
-        for (int layer = 0; layer < 3; ++layer) {
-
-            float h = -0.9f + layer * 0.08f;
-
-            float alpha = 0.06f * (1.0f - layer * 0.25f);
-
-            glColor4f(1.0f, 0.86f, 0.6f, alpha);
-
-            glBegin(GL_QUADS);
-
-            glVertex3f(-10.0f, h - 0.05f, -9.4f);
-
-            glVertex3f(10.0f, h - 0.05f, -9.4f);
-
-            glVertex3f(10.0f, h + 0.12f, -9.4f);
-
-            glVertex3f(-10.0f, h + 0.12f, -9.4f);
-
-            glEnd();
-
-        }
+        glCallList(horizonList[1]);
 
 
 
@@ -1385,19 +1243,7 @@ void display() {
 
     } else {
 
-        // Night gradient
-
-        glBegin(GL_QUADS);
-
-        glColor3f(0.02f, 0.04f, 0.18f); glVertex3f(-10.0f, 10.0f, -9.5f);
-
-        glColor3f(0.05f, 0.08f, 0.28f); glVertex3f(10.0f, 10.0f, -9.5f);
-
-        glColor3f(0.08f, 0.10f, 0.18f); glVertex3f(10.0f, -1.2f, -9.5f);
-
-        glColor3f(0.03f, 0.06f, 0.12f); glVertex3f(-10.0f, -1.2f, -9.5f);
-
-        glEnd();
+        glCallList(skyList[0]);
 
 
 
@@ -1429,81 +1275,11 @@ void display() {
 
         // Stars
 
-        static bool starsInit = false;
-
-        static std::vector<std::pair<float, float>> stars;
-
-        if (!starsInit) {
-
-            starsInit = true;
-
-            std::mt19937 sr(424242);
-
-            std::uniform_real_distribution<float> sx(-1.1f, 1.1f), sy(0.0f, 1.05f);
-
-            for (int i = 0; i < 280; ++i) stars.emplace_back(sx(sr), sy(sr));
-
-        }
-
-        glPointSize(1.8f);
-
-        glBegin(GL_POINTS);
-
-        for (size_t i = 0; i < stars.size(); ++i) {
-
-            float tw = 0.5f + 0.5f * sinf(time * 2.0f + (float)i * 0.13f);
-
-            float bright = 0.6f + 0.4f * tw;
-
-            glColor4f(0.95f * bright, 0.95f * bright, 1.0f * bright, 0.8f);
-
-            glVertex3f(stars[i].first, stars[i].second, -9.2f);
-
-        }
-
-        glEnd();
-
-        glPointSize(1.0f);
-
-
-
-        // Milky band
-
-        glColor4f(0.9f, 0.9f, 0.98f, 0.035f);
-
-        glBegin(GL_QUADS);
-
-        glVertex3f(-10.0f, 0.15f, -9.3f);
-
-        glVertex3f(10.0f, 0.15f, -9.3f);
-
-        glVertex3f(10.0f, -0.05f, -9.3f);
-
-        glVertex3f(-10.0f, -0.05f, -9.3f);
-
-        glEnd();
-
-
-
-        // Night mountains
-
-        glColor3f(0.02f, 0.02f, 0.04f);
-
-        glBegin(GL_TRIANGLE_STRIP);
-
-        glVertex3f(-1.2f, -0.2f, -9.1f);
-
-        for (float x = -1.2f; x <= 1.2f; x += 0.08f) {
+        drawStars(time);
 
-            float peak = 0.08f * (0.5f + 0.5f * sinf(3.0f * x + 0.6f));
-
-            glVertex3f(x, -0.2f + peak, -9.1f);
 
-            glVertex3f(x, -1.2f, -9.1f);
 
-        }
-
-        glEnd();
+        glCallList(horizonList[0]);
 
     }
 
@@ -1529,62 +1305,48 @@ void display() {
 
 
 
-    // --- Ground ---
-
-    glBegin(GL_QUADS);
-
-    glColor3f(0.3f, 0.6f, 0.3f);
-
-    glVertex3f(-1, -1, -0.1f);
-
-    glVertex3f(1, -1, -0.1f);
-
-    glVertex3f(1, -0.5f, -0.1f);
-
-    glVertex3f(-1, -0.5f, -0.1f);
-
-    glEnd();
-
-
-
-    // --- Scene Objects ---
-
-    // Houses rearranged to be spaced out and slightly more right
-
-
+    // --- Ground and Pond ---
 
-    // Tree: Large size (2.5) placed far to the left, but within view boundary
+    bakeGround();
 
-    // In display() or wherever you draw trees
-
-
-    drawPond();
+    glCallList(groundList);
 
     drawWaterBowl();
 
 
 
     // --- Larvae and Mosquitoes ---
+    // The cached meshes are scaled per instance, so lit normals need renormalizing
+    glEnable(GL_NORMALIZE);
 
-    for (size_t i = 0; i < larvae.size(); ++i)
+    for (size_t i = world.larvae.front; i < world.larvae.used(); ++i)
 
-        if (larvae[i].alive)
+        if (world.larvae.alive[i])
 
-            drawLarva(larvae[i].x, larvae[i].y, larvae[i].size);
+            drawLarva(world.larvae.x[i], world.larvae.y[i], world.larvaSize(i));
 
-    for (int i = 0; i < NUM_MOSQUITOES; ++i)
+    // Hover is cosmetic: drawn from simulated time, never stored in the world
+    float hoverZ = 0.05f + 0.05f * sinf((float)simClock.renderSeconds(world.tick) * 5.0f);
 
-        if (mosquitoes[i].alive)
+    const Population& pop = world.mosquitoes;
 
-            drawMosquito(mosquitoes[i].x, mosquitoes[i].y, mosquitoes[i].z,
+    // A population too big for the GL to map falls back to the display lists for good
+    instancing = instancing && mosquitoInstancer.reserve(pop.count());
 
-                         mosquitoes[i].size, 0.5f, 0.3f, 0.1f);
+    if (instancing) {
+        MosquitoInstancer::Hover hover = {hoverZ, 0.0f, 0.0f};
+        mosquitoInstancer.draw(pop.x.data(), pop.y.data(), pop.size.data(), nullptr, nullptr, pop.count(), hover);
+    } else {
+        for (size_t i = 0; i < pop.count(); ++i)
+            drawMosquito(pop.x[i], pop.y[i], hoverZ, pop.size[i]);
+    }
+    glDisable(GL_NORMALIZE);
 
 
 
     // --- Spray Effect ---
 
-    if (spraying) {
+    if (world.spraying) {
 
         glEnable(GL_BLEND);
 
@@ -1592,7 +1354,7 @@ void display() {
 
         glColor4f(0.1f, 0.6f, 1.0f, 0.5f);
 
-        drawCircle(sprayX, sprayY, 0.0f, sprayRadius, 36);
+        drawCircle(world.sprayX, world.sprayY, 0.0f, world.sprayRadius, 36);
 
         glDisable(GL_BLEND);
 
@@ -1600,6 +1362,10 @@ void display() {
 
 
 
+    drawParticles();
+
+
+
     // --- Environment Effects ---
 
     drawRain();
@@ -1646,40 +1412,47 @@ void display() {
 void menuFunc(int option) {
     switch (option) {
         case MENU_RESTART:
-            initializeMosquitoes();
-            snprintf(popupText, sizeof(popupText), "Simulation restarted!");
-            popupTimer = POPUP_DURATION;
-            #ifdef _WIN32
-            Beep(1000, 200);
-            #endif
+            inputs.push(world, INPUT_RESTART, 0.0f, 0.0f, (int32_t)rng());
             break;
 
         case MENU_TOGGLE_BOWL:
-            waterBowlVisible = !waterBowlVisible;
-            snprintf(popupText, sizeof(popupText), waterBowlVisible ?
-                     "Water bowl toggled on!" : "Water bowl toggled off!");
-            popupTimer = POPUP_DURATION;
-            #ifdef _WIN32
-            Beep(1050, 200);
-            #endif
+            inputs.push(world, INPUT_TOGGLE_BOWL);
             break;
 
         case MENU_TRIGGER_RAIN:
-            if (!rainActive) {
-                rainActive = true;
-                rainTimer = RAIN_DURATION;
-                for (int i = 0; i < RAIN_SPAWN_COUNT; ++i)
-                    spawnOneMosquito(true);
-                snprintf(popupText, sizeof(popupText),
-                         "Rain event triggered! %d mosquitoes spawned!", RAIN_SPAWN_COUNT);
-                popupTimer = POPUP_DURATION;
-                #ifdef _WIN32
-                Beep(550, 350);
-                #endif
+            inputs.push(world, INPUT_RAIN);
+            break;
+
+        case MENU_SAVE: {
+            // The histogram rides along as [historyIndex, killedHistory...]
+            std::vector<int32_t> history(killedHistory, killedHistory + HISTOGRAM_SIZE);
+            history.insert(history.begin(), historyIndex);
+            snprintf(popupText, sizeof(popupText), saveSnapshot(world, SNAPSHOT_FILE, &history) ?
+                     "Saved to " SNAPSHOT_FILE : "Could not write " SNAPSHOT_FILE);
+            popupTimer = POPUP_DURATION;
+            break;
+        }
+
+        case MENU_LOAD: {
+            std::vector<int32_t> history;
+            if (loadSnapshot(world, SNAPSHOT_FILE, &history)) {
+                if (history.size() == HISTOGRAM_SIZE + 1) {
+                    historyIndex = history[0] % HISTOGRAM_SIZE;
+                    std::copy(history.begin() + 1, history.end(), killedHistory);
+                }
+                simClock.stepMillis = world.cfg.tickMillis;
+                simClock.reset();
+                inputs.record(INPUT_LOG_FILE, world); // A replay starts from the loaded state
+                snprintf(popupText, sizeof(popupText), "Loaded " SNAPSHOT_FILE);
+            } else {
+                snprintf(popupText, sizeof(popupText), "Could not load " SNAPSHOT_FILE);
             }
+            popupTimer = POPUP_DURATION;
             break;
+        }
 
         case MENU_EXIT:
+            inputs.finish(world);
             exit(0);
     }
     glutPostRedisplay();
@@ -1688,30 +1461,18 @@ void menuFunc(int option) {
 // --- Keyboard Input ---
 void keyboard(unsigned char key, int x, int y) {
     switch (key) {
-        case 27: exit(0); break;
-        case 's': case 'S': doSpray(randFloat(-0.95f, 0.95f), randFloat(-0.95f, 0.95f)); break;
+        case 27: inputs.finish(world); exit(0); break;
+        case 's': case 'S':
+            inputs.push(world, INPUT_SPRAY_RANDOM, 0.95f); // Target drawn from the sim stream when applied
+            break;
         case 'r': case 'R':
-            waterBowlVisible = !waterBowlVisible;
-            snprintf(popupText, sizeof(popupText), waterBowlVisible ?
-                     "Water bowl toggled on!" : "Water bowl toggled off!");
-            popupTimer = POPUP_DURATION;
-            #ifdef _WIN32
-            Beep(1050, 200);
-            #endif
+            inputs.push(world, INPUT_TOGGLE_BOWL);
             break;
         case 't': case 'T':
-            if (!rainActive) {
-                rainActive = true;
-                rainTimer = RAIN_DURATION;
-                for (int i = 0; i < RAIN_SPAWN_COUNT; ++i)
-                    spawnOneMosquito(true);
-                snprintf(popupText, sizeof(popupText),
-                         "Rain event triggered! %d mosquitoes spawned!", RAIN_SPAWN_COUNT);
-                popupTimer = POPUP_DURATION;
-                #ifdef _WIN32
-                Beep(550, 350);
-                #endif
-            }
+            inputs.push(world, INPUT_RAIN);
+            break;
+        case 'f': case 'F':
+            simClock.cycleWarp();
             break;
         case 'd': case 'D':
             dayTime = !dayTime;
@@ -1728,17 +1489,17 @@ void keyboard(unsigned char key, int x, int y) {
 
 // --- Mouse Input ---
 void mouse(int button, int state, int x, int y) {
-    if (button == GLUT_LEFT_BUTTON && state == GLUT_DOWN && sprayCharges > 0) {
+    if (button == GLUT_LEFT_BUTTON && state == GLUT_DOWN && world.sprayCharges > 0) {
         float wx = screenToWorldX(x, windowWidth);
         float wy = screenToWorldY(y, windowHeight);
         doSpray(wx, wy);
     }
 
-    if (button == GLUT_RIGHT_BUTTON && state == GLUT_DOWN && waterBowlVisible) {
+    if (button == GLUT_RIGHT_BUTTON && state == GLUT_DOWN && world.waterBowlVisible) {
         float wx = screenToWorldX(x, windowWidth);
         float wy = screenToWorldY(y, windowHeight);
-        float dx = wx - waterBowlX, dy = wy - waterBowlY;
-        if (sqrtf(dx * dx + dy * dy) <= waterBowlRadius * 1.5f) {
+        float dx = wx - world.waterBowlX, dy = wy - world.waterBowlY;
+        if (sqrtf(dx * dx + dy * dy) <= world.cfg.bowlRadius * 1.5f) {
             draggingBowl = true;
             lastMouseX = x;
             lastMouseY = y;
@@ -1752,10 +1513,8 @@ void mouse(int button, int state, int x, int y) {
 }
 
 void motion(int x, int y) {
-    if (draggingBowl && waterBowlVisible) {
-        waterBowlX = screenToWorldX(x, windowWidth);
-        waterBowlY = screenToWorldY(y, windowHeight);
-        glutPostRedisplay();
+    if (draggingBowl && world.waterBowlVisible) {
+        inputs.push(world, INPUT_MOVE_BOWL, screenToWorldX(x, windowWidth), screenToWorldY(y, windowHeight));
     }
 }
 
@@ -1771,15 +1530,38 @@ void initGL() {
     glEnable(GL_BLEND);
     glEnable(GL_DEPTH_TEST);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    buildMeshes();
+    buildScenery();
     initializeMosquitoes();
-    initializeRain();
+    inputs.record(INPUT_LOG_FILE, world);
     printf("initGL: Complete\n");
 }
 
+// One simulation tick, plus the cosmetic state that advances with it
+void stepSimulation() {
+    inputs.apply(world, handleInput);
+    world.step();
+    for (size_t i = 0; i < world.events.size(); ++i) handleSimEvent(world.events[i]);
+    if (world.spawnedThisTick > 0) audioCue(1050, 60, "Mosquito spawned!");
+    updateHistogram(world.killedThisTick);
+
+    // Cosmetic state that follows the weather
+    if (world.windActive) treeSwayAngle = sinf((float)world.windTimer * 0.1f) * 10.0f;
+    cloudOffset += dayTime ? 0.0005f : 0.0002f;
+    if (cloudOffset > 2.0f) cloudOffset = -2.0f;
+}
+
 void timerFunc(int value) {
-    updateMosquitoesLogic();
+    int steps = simClock.advance(glutGet(GLUT_ELAPSED_TIME));
+    for (int i = 0; i < steps; ++i) stepSimulation();
+
+    // Particles and popups advance once per rendered frame, so under warp
+    // they still live long enough to be seen
+    if (world.rainActive) emitRain();
+    particles.step(world.windForce);
+    if (popupTimer > 0) popupTimer--;
     glutPostRedisplay();
-    glutTimerFunc(16, timerFunc, 0); // ~60 FPS
+    glutTimerFunc(FRAME_MILLIS, timerFunc, 0); // ~60 FPS
 }
 
 int main(int argc, char** argv) {
@@ -1799,12 +1581,14 @@ int main(int argc, char** argv) {
     glutKeyboardFunc(keyboard);
     glutMouseFunc(mouse);
     glutMotionFunc(motion);
-    glutTimerFunc(16, timerFunc, 0);
+    glutTimerFunc(FRAME_MILLIS, timerFunc, 0);
 
     glutCreateMenu(menuFunc);
     glutAddMenuEntry("Restart Simulation", MENU_RESTART);
     glutAddMenuEntry("Toggle Water Bowl", MENU_TOGGLE_BOWL);
     glutAddMenuEntry("Trigger Rain Event", MENU_TRIGGER_RAIN);
+    glutAddMenuEntry("Save Snapshot", MENU_SAVE);
+    glutAddMenuEntry("Load Snapshot", MENU_LOAD);
     glutAddMenuEntry("Exit", MENU_EXIT);
     glutAttachMenu(GLUT_RIGHT_BUTTON);
 